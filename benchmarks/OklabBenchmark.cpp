@@ -1,10 +1,12 @@
 #include "benchmark/cppbenchmark.h"
 
 #include "ColorConversions.h"
+#include "ColorBatchConversions.h"
 #include "../src/OkLxx.h"
 
 #include <random>
 #include <chrono>
+#include <vector>
 
 using namespace oklab;
 
@@ -52,4 +54,32 @@ BENCHMARK("P3 to RGB", settings)
     }
 }
 
+BENCHMARK("P3 to RGB (batch of 65536 pixels)", settings)
+{
+    static std::vector<P3> input = []()
+    {
+        std::vector<P3> colors(65536);
+        for (P3 &color : colors)
+        {
+            color = P3{rand() % 256, rand() % 256, rand() % 256};
+        }
+        return colors;
+    }();
+    static std::vector<Oklab> oklab(input.size());
+    static std::vector<RGB> output(input.size());
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    p3ToOklab(input, oklab);
+    oklabToRgb(oklab, output);
+
+    auto stop = std::chrono::high_resolution_clock::now();
+
+    uint64_t latency = std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+    if (latency > 0)
+    {
+        context.metrics().AddLatency(latency);
+    }
+}
+
 BENCHMARK_MAIN()
\ No newline at end of file
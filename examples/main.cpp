@@ -1,7 +1,12 @@
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <sys/stat.h>
 #include "args.hxx"
 #include "ColorConversions.h"
 #include "ColorTypes.h"
+#include "ConversionTable.h"
+#include "PnmImage.h"
 
 using namespace oklab;
 
@@ -16,6 +21,28 @@ ColorType parseColor(const std::string &input)
     return ColorType{r, g, b};
 }
 
+GamutMapping parseGamutMapping(const std::string &name)
+{
+    if (name == "css4")
+        return GamutMapping::Css4;
+    if (name == "cusp")
+        return GamutMapping::Cusp;
+    if (name == "clamp")
+        return GamutMapping::Clamp;
+    if (name == "none")
+        return GamutMapping::None;
+    throw args::ValidationError("mapping must be css4, cusp, clamp or none");
+}
+
+// Whether both paths name the same existing file, through links or different spellings
+bool isSameFile(const std::string &path1, const std::string &path2)
+{
+    struct stat stat1;
+    struct stat stat2;
+    return stat(path1.c_str(), &stat1) == 0 && stat(path2.c_str(), &stat2) == 0 &&
+           stat1.st_dev == stat2.st_dev && stat1.st_ino == stat2.st_ino;
+}
+
 int main(int argc, char **argv)
 {
     args::ArgumentParser parser("Color transformation CLI application.");
@@ -26,22 +53,122 @@ int main(int argc, char **argv)
     args::Command rgbToP3Cmd(commands, "rgbToP3", "Convert RGB to P3 color space", [&](args::Subparser &sp)
                              {
         args::ValueFlag<std::string> inputColor(sp, "inputColor", "The input RGB color (format: 'r g b')", {"inputColor"}, args::Options::Required);
+        args::ValueFlag<std::string> mapping(sp, "mapping", "The gamut mapping: css4, cusp, clamp or none (default: the build's)", {"mapping"});
         sp.Parse();
+        GamutMapping gamutMapping = mapping ? parseGamutMapping(args::get(mapping)) : defaultGamutMapping();
         RGB rgb = parseColor<RGB>(args::get(inputColor));
         Oklab oklab = rgbToOklab(rgb);
-        P3 p3 = oklabToP3(oklab);
+        P3 p3 = oklabToP3(oklab, gamutMapping);
         std::cout << "Converted P3: " << p3[0] << ", " << p3[1] << ", " << p3[2] << std::endl; });
 
     args::Command p3ToRgbCmd(commands, "P3ToRgb", "Convert P3 to RGB color space", [&](args::Subparser &sp)
                              {
         args::ValueFlag<std::string> inputColor(sp, "inputColor", "The input P3 color (format: 'r g b')", {"inputColor"}, args::Options::Required);
+        args::ValueFlag<std::string> mapping(sp, "mapping", "The gamut mapping: css4, cusp, clamp or none (default: the build's)", {"mapping"});
         sp.Parse();
+        GamutMapping gamutMapping = mapping ? parseGamutMapping(args::get(mapping)) : defaultGamutMapping();
         P3 p3 = parseColor<P3>(args::get(inputColor));
         std::cout << "Parsed P3: " << p3[0] << ", " << p3[1] << ", " << p3[2] << std::endl;
         Oklab oklab = p3ToOklab(p3);
-        RGB rgb = oklabToRgb(oklab);
+        RGB rgb = oklabToRgb(oklab, gamutMapping);
         std::cout << "Converted RGB: " << rgb[0] << ", " << rgb[1] << ", " << rgb[2] << std::endl; });
 
+    args::Command buildTableCmd(commands, "buildTable", "Precompute every 8-bit conversion into a table file", [&](args::Subparser &sp)
+                                {
+        args::ValueFlag<std::string> direction(sp, "direction", "The conversion to store: rgbToP3 or P3ToRgb", {"direction"}, args::Options::Required);
+        args::ValueFlag<std::string> output(sp, "output", "The table file to write", {"output"}, args::Options::Required);
+        args::ValueFlag<unsigned> threads(sp, "threads", "Number of threads (default: all cores)", {"threads"}, 0);
+        sp.Parse();
+        bool built = false;
+        if (args::get(direction) == "rgbToP3")
+        {
+            built = RgbToP3Table::build(args::get(output), args::get(threads));
+        }
+        else if (args::get(direction) == "P3ToRgb")
+        {
+            built = P3ToRgbTable::build(args::get(output), args::get(threads));
+        }
+        else
+        {
+            throw args::ValidationError("direction must be rgbToP3 or P3ToRgb");
+        }
+        if (!built)
+        {
+            throw args::ValidationError("could not write " + args::get(output));
+        }
+        std::cout << "Wrote " << args::get(output) << std::endl; });
+
+    args::Command convertImageCmd(commands, "convertImage", "Convert a binary PPM or PAM image, reporting the throughput", [&](args::Subparser &sp)
+                                  {
+        args::ValueFlag<std::string> direction(sp, "direction", "The conversion: rgbToP3 or P3ToRgb", {"direction"}, args::Options::Required);
+        args::ValueFlag<std::string> input(sp, "input", "The PPM or PAM image to convert", {"input"}, args::Options::Required);
+        args::ValueFlag<std::string> output(sp, "output", "The image to write", {"output"}, args::Options::Required);
+        args::ValueFlag<std::string> format(sp, "format", "The output format: ppm or pam (default: the input's)", {"format"});
+        args::ValueFlag<unsigned> maxValue(sp, "maxValue", "The output maximum sample value, up to 65535 (default: the input's)", {"maxValue"});
+        args::ValueFlag<std::string> mapping(sp, "mapping", "The gamut mapping: css4, cusp, clamp or none (default: the build's)", {"mapping"});
+        args::ValueFlag<unsigned> threads(sp, "threads", "Number of threads (default: all cores)", {"threads"}, 0);
+        args::ValueFlag<unsigned> repeat(sp, "repeat", "Number of conversions timed, the best one reported", {"repeat"}, 1);
+        sp.Parse();
+
+        // Everything is checked before the output file is created, which truncates it
+        bool isP3ToRgb = args::get(direction) == "P3ToRgb";
+        if (!isP3ToRgb && args::get(direction) != "rgbToP3")
+        {
+            throw args::ValidationError("direction must be rgbToP3 or P3ToRgb");
+        }
+        if (format && args::get(format) != "ppm" && args::get(format) != "pam")
+        {
+            throw args::ValidationError("format must be ppm or pam");
+        }
+        GamutMapping gamutMapping = mapping ? parseGamutMapping(args::get(mapping)) : defaultGamutMapping();
+        // The input is memory-mapped: truncating it would fault its reads
+        if (isSameFile(args::get(input), args::get(output)))
+        {
+            throw args::ValidationError("output must not be the input file");
+        }
+
+        std::unique_ptr<PnmImage> image = PnmImage::open(args::get(input));
+        if (!image)
+        {
+            throw args::ValidationError("could not read " + args::get(input) + " as a binary PPM or an RGB PAM");
+        }
+
+        PnmFormat outputFormat = image->format();
+        if (format)
+        {
+            outputFormat = args::get(format) == "ppm" ? PnmFormat::Ppm : PnmFormat::Pam;
+        }
+        bool hasAlpha = image->hasAlpha() && outputFormat == PnmFormat::Pam;
+        unsigned outputMaxValue = maxValue ? args::get(maxValue) : image->maxValue();
+
+        std::unique_ptr<PnmImage> converted = PnmImage::create(args::get(output), outputFormat, image->width(), image->height(), outputMaxValue, hasAlpha);
+        if (!converted)
+        {
+            throw args::ValidationError("could not write " + args::get(output));
+        }
+
+        ThreadPool pool(args::get(threads));
+        ImageConversionOptions options;
+        options.mapping = gamutMapping;
+        options.pool = &pool;
+
+        double seconds = 0;
+        for (unsigned i = 0; i < std::max(1u, args::get(repeat)); ++i)
+        {
+            auto start = std::chrono::steady_clock::now();
+            isP3ToRgb ? p3ToRgb(*image, *converted, options) : rgbToP3(*image, *converted, options);
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            seconds = i == 0 ? elapsed : std::min(seconds, elapsed);
+        }
+        if (!converted->flush())
+        {
+            throw args::ValidationError("could not write " + args::get(output));
+        }
+
+        double pixels = static_cast<double>(image->width()) * static_cast<double>(image->height());
+        std::cout << "Converted " << image->width() << "x" << image->height() << " pixels on " << pool.threadCount() << " threads in "
+                  << seconds * 1000 << " ms (" << pixels / seconds / 1e6 << " Mpixels/s)" << std::endl; });
+
     try
     {
         parser.ParseCLI(argc, argv);
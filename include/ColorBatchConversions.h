@@ -0,0 +1,206 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "ColorTypes.h"
+#include "GamutMapping.h"
+
+/**
+ * @file ColorBatchConversions.h
+ * @brief Provides functions for converting whole buffers of colors between color spaces.
+ *
+ * Each batch function has the same per-pixel semantics as its single-color counterpart in
+ * ColorConversions.h (including gamut mapping), but processes the buffer in blocks so the
+ * individual conversion stages run as tight loops over many pixels. The overloads taking a
+ * `GamutMapping` select the algorithm once for the whole buffer.
+ *
+ * Buffer sizes are checked in every build: the functions throw `std::invalid_argument`, before
+ * writing anything, when the output and input sizes differ or the planes of a planar buffer do.
+ */
+
+namespace oklab
+{
+    /**
+     * @brief Non-owning view over a contiguous sequence of elements.
+     */
+    template <typename T>
+    class Span
+    {
+    public:
+        Span() : data_(nullptr), size_(0) {}
+
+        Span(T *data, std::size_t size) : data_(data), size_(size) {}
+
+        template <std::size_t N>
+        Span(T (&array)[N]) : data_(array), size_(N) {}
+
+        template <typename U, std::size_t N>
+        Span(std::array<U, N> &array) : data_(array.data()), size_(N) {}
+
+        template <typename U, std::size_t N>
+        Span(const std::array<U, N> &array) : data_(array.data()), size_(N) {}
+
+        template <typename U>
+        Span(std::vector<U> &vector) : data_(vector.data()), size_(vector.size()) {}
+
+        template <typename U>
+        Span(const std::vector<U> &vector) : data_(vector.data()), size_(vector.size()) {}
+
+        // Allow Span<T> -> Span<const T>
+        template <typename U>
+        Span(const Span<U> &other) : data_(other.data()), size_(other.size()) {}
+
+        T *data() const { return data_; }
+        std::size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+
+        T &operator[](std::size_t index) const { return data_[index]; }
+
+        T *begin() const { return data_; }
+        T *end() const { return data_ + size_; }
+
+        Span subspan(std::size_t offset, std::size_t count) const { return Span(data_ + offset, count); }
+
+    private:
+        T *data_;
+        std::size_t size_;
+    };
+
+    /**
+     * @brief Planar (structure-of-arrays) view over a buffer of 3-channel colors.
+     *
+     * Each channel lives in its own span; all three spans must have the same size, which the
+     * batch functions check.
+     */
+    template <typename T>
+    struct Planar
+    {
+        std::array<Span<T>, 3> channels;
+
+        Planar(Span<T> c0, Span<T> c1, Span<T> c2) : channels{c0, c1, c2} {}
+
+        // Allow Planar<T> -> Planar<const T>
+        template <typename U>
+        Planar(const Planar<U> &other) : channels{other.channels[0], other.channels[1], other.channels[2]} {}
+
+        std::size_t size() const { return channels[0].size(); }
+    };
+
+    /**
+     * @brief Converts a buffer of RGB colors to Oklab.
+     * @param input Interleaved RGB colors to convert.
+     * @param output Receives the Oklab colors; must have the same size as the input.
+     */
+    void rgbToOklab(Span<const RGB> input, Span<Oklab> output);
+
+    /**
+     * @brief Converts planar RGB channels (0-255) to planar Oklab channels.
+     * @param input Planar R, G and B channels to convert.
+     * @param output Receives the L, a and b channels; must have the same size as the input.
+     */
+    void rgbToOklab(Planar<const int> input, Planar<double> output);
+
+    /**
+     * @brief Converts a buffer of Oklab colors to RGB.
+     * Includes gamut mapping to ensure the output stays within the valid RGB range.
+     * @param input Interleaved Oklab colors to convert.
+     * @param output Receives the RGB colors; must have the same size as the input.
+     */
+    void oklabToRgb(Span<const Oklab> input, Span<RGB> output);
+
+    /**
+     * @brief Converts a buffer of Oklab colors to RGB with the given gamut mapping.
+     */
+    void oklabToRgb(Span<const Oklab> input, Span<RGB> output, GamutMapping mapping);
+
+    /**
+     * @brief Converts planar Oklab channels to planar RGB channels (0-255).
+     * Includes gamut mapping to ensure the output stays within the valid RGB range.
+     * @param input Planar L, a and b channels to convert.
+     * @param output Receives the R, G and B channels; must have the same size as the input.
+     */
+    void oklabToRgb(Planar<const double> input, Planar<int> output);
+
+    /**
+     * @brief Converts planar Oklab channels to planar RGB channels (0-255) with the given gamut mapping.
+     */
+    void oklabToRgb(Planar<const double> input, Planar<int> output, GamutMapping mapping);
+
+    /**
+     * @brief Converts a buffer of P3 colors to Oklab.
+     * @param input Interleaved P3 colors to convert.
+     * @param output Receives the Oklab colors; must have the same size as the input.
+     */
+    void p3ToOklab(Span<const P3> input, Span<Oklab> output);
+
+    /**
+     * @brief Converts planar P3 channels (0-255) to planar Oklab channels.
+     * @param input Planar R, G and B channels to convert.
+     * @param output Receives the L, a and b channels; must have the same size as the input.
+     */
+    void p3ToOklab(Planar<const int> input, Planar<double> output);
+
+    /**
+     * @brief Converts a buffer of Oklab colors to P3.
+     * Includes gamut mapping to ensure the output stays within the valid P3 range.
+     * @param input Interleaved Oklab colors to convert.
+     * @param output Receives the P3 colors; must have the same size as the input.
+     */
+    void oklabToP3(Span<const Oklab> input, Span<P3> output);
+
+    /**
+     * @brief Converts a buffer of Oklab colors to P3 with the given gamut mapping.
+     */
+    void oklabToP3(Span<const Oklab> input, Span<P3> output, GamutMapping mapping);
+
+    /**
+     * @brief Converts planar Oklab channels to planar P3 channels (0-255).
+     * Includes gamut mapping to ensure the output stays within the valid P3 range.
+     * @param input Planar L, a and b channels to convert.
+     * @param output Receives the R, G and B channels; must have the same size as the input.
+     */
+    void oklabToP3(Planar<const double> input, Planar<int> output);
+
+    /**
+     * @brief Converts planar Oklab channels to planar P3 channels (0-255) with the given gamut mapping.
+     */
+    void oklabToP3(Planar<const double> input, Planar<int> output, GamutMapping mapping);
+
+    /**
+     * @brief Converts a buffer of RGB colors of the given bit depth to Oklab.
+     * @param input Interleaved RGB colors, with codes in [0, maxCodeValue(depth)].
+     * @param output Receives the Oklab colors; must have the same size as the input.
+     */
+    void rgbToOklab(Span<const RGB> input, Span<Oklab> output, BitDepth depth);
+
+    /**
+     * @brief Converts a buffer of Oklab colors to RGB colors of the given bit depth.
+     * Includes gamut mapping to ensure the output stays within the valid RGB range.
+     */
+    void oklabToRgb(Span<const Oklab> input, Span<RGB> output, BitDepth depth);
+
+    /**
+     * @brief Converts a buffer of Oklab colors to RGB colors of the given bit depth, with the given gamut mapping.
+     */
+    void oklabToRgb(Span<const Oklab> input, Span<RGB> output, BitDepth depth, GamutMapping mapping);
+
+    /**
+     * @brief Converts a buffer of P3 colors of the given bit depth to Oklab.
+     * @param input Interleaved P3 colors, with codes in [0, maxCodeValue(depth)].
+     * @param output Receives the Oklab colors; must have the same size as the input.
+     */
+    void p3ToOklab(Span<const P3> input, Span<Oklab> output, BitDepth depth);
+
+    /**
+     * @brief Converts a buffer of Oklab colors to P3 colors of the given bit depth.
+     * Includes gamut mapping to ensure the output stays within the valid P3 range.
+     */
+    void oklabToP3(Span<const Oklab> input, Span<P3> output, BitDepth depth);
+
+    /**
+     * @brief Converts a buffer of Oklab colors to P3 colors of the given bit depth, with the given gamut mapping.
+     */
+    void oklabToP3(Span<const Oklab> input, Span<P3> output, BitDepth depth, GamutMapping mapping);
+} // namespace oklab
@@ -1,11 +1,28 @@
 #pragma once
 
 #include "ColorTypes.h"
+#include "GamutMapping.h"
 #include <algorithm> // Include if needed for std::min, std::max, etc.
 
 /**
  * @file ColorConversions.h
  * @brief Provides functions for converting between different color spaces.
+ *
+ * The conversions compute in double precision by default. Their single-precision variants
+ * (`rgbToOklab<float>`, `oklabToRgb(Oklabf)`, ...) run the same pipeline, gamut mapping
+ * included, in float. Over all 2^24 8-bit inputs, versus the double pipeline:
+ * - the float round trips RGB -> Oklab -> RGB and P3 -> Oklab -> P3 give the same colors as
+ *   the double ones;
+ * - `p3ToRgb<float>` and `rgbToP3<float>` differ by at most 1 code per channel, on 2433 and
+ *   1398 inputs respectively (less than 0.015%).
+ *
+ * The conversions into RGB and P3 apply `defaultGamutMapping()`; their overloads taking a
+ * `GamutMapping` apply the given algorithm instead.
+ *
+ * The overloads taking a `BitDepth` read and write codes of that depth instead of 0-255, through
+ * per-depth tables: decoding is exactly `gammaToLinear(code / max)` and encoding exactly
+ * `round(linearToGamma(value) * max)`, so `BitDepth::Eight` gives the 8-bit results. The
+ * gamma-encoded `GammaSRGB` / `GammaP3` conversions skip quantization altogether.
  */
 
 namespace oklab
@@ -18,6 +35,15 @@ namespace oklab
      */
     Oklab rgbToOklab(const RGB &color);
 
+    /**
+     * @brief Converts an RGB color to an Oklab color in the given precision.
+     * @tparam Scalar `double` or `float` (e.g. `rgbToOklab<float>(rgb)`).
+     * @param color RGB color to convert.
+     * @return Oklab representation of the input color.
+     */
+    template <typename Scalar>
+    BasicOklab<Scalar> rgbToOklab(const RGB &color);
+
     /**
      * @brief Converts an Oklab color to an RGB color.
      * @param color Oklab color to convert.
@@ -26,6 +52,27 @@ namespace oklab
      */
     RGB oklabToRgb(const Oklab &color);
 
+    /**
+     * @brief Converts an Oklab color to an RGB color with the given gamut mapping.
+     * @param color Oklab color to convert.
+     * @param mapping Algorithm bringing out-of-gamut colors into the RGB gamut.
+     * @return RGB representation of the input color.
+     */
+    RGB oklabToRgb(const Oklab &color, GamutMapping mapping);
+
+    /**
+     * @brief Converts a single-precision Oklab color to an RGB color.
+     * Gamut mapping runs in single precision.
+     * @param color Oklab color to convert.
+     * @return RGB representation of the input color.
+     */
+    RGB oklabToRgb(const Oklabf &color);
+
+    /**
+     * @brief Converts a single-precision Oklab color to an RGB color with the given gamut mapping.
+     */
+    RGB oklabToRgb(const Oklabf &color, GamutMapping mapping);
+
     /**
      * @brief Converts a P3 color to an Oklab color.
      * @param color P3 color to convert.
@@ -33,6 +80,15 @@ namespace oklab
      */
     Oklab p3ToOklab(const P3 &color);
 
+    /**
+     * @brief Converts a P3 color to an Oklab color in the given precision.
+     * @tparam Scalar `double` or `float` (e.g. `p3ToOklab<float>(p3)`).
+     * @param color P3 color to convert.
+     * @return Oklab representation of the input color.
+     */
+    template <typename Scalar>
+    BasicOklab<Scalar> p3ToOklab(const P3 &color);
+
     /**
      * @brief Converts an Oklab color to a P3 color.
      * @param color Oklab color to convert.
@@ -41,6 +97,27 @@ namespace oklab
      */
     P3 oklabToP3(const Oklab &color);
 
+    /**
+     * @brief Converts an Oklab color to a P3 color with the given gamut mapping.
+     * @param color Oklab color to convert.
+     * @param mapping Algorithm bringing out-of-gamut colors into the P3 gamut.
+     * @return P3 representation of the input color.
+     */
+    P3 oklabToP3(const Oklab &color, GamutMapping mapping);
+
+    /**
+     * @brief Converts a single-precision Oklab color to a P3 color.
+     * Gamut mapping runs in single precision.
+     * @param color Oklab color to convert.
+     * @return P3 representation of the input color.
+     */
+    P3 oklabToP3(const Oklabf &color);
+
+    /**
+     * @brief Converts a single-precision Oklab color to a P3 color with the given gamut mapping.
+     */
+    P3 oklabToP3(const Oklabf &color, GamutMapping mapping);
+
     /**
      * @brief Converts a generic color type to Oklab.
      * This template function must be specialized for each supported color type.
@@ -60,6 +137,24 @@ namespace oklab
     template <typename ColorType>
     ColorType convertFromOklab(const Oklab &oklab);
 
+    /**
+     * @brief Converts a generic color type to Oklch.
+     * Specialized for `RGB` and `P3`; achromatic colors have a NaN (powerless) hue.
+     * @param color Color to convert.
+     * @return Oklch representation of the input color.
+     */
+    template <typename ColorType>
+    Oklch convertToOklch(const ColorType &color);
+
+    /**
+     * @brief Converts Oklch to a generic color type, including gamut mapping.
+     * Specialized for `RGB` and `P3`; a NaN hue gives an achromatic color.
+     * @param oklch Oklch color to convert.
+     * @return Color representation of the input Oklch.
+     */
+    template <typename ColorType>
+    ColorType convertFromOklch(const Oklch &oklch);
+
     /**
      * @brief Converts a RGB color to P3.
      *
@@ -68,6 +163,18 @@ namespace oklab
      */
     P3 rgbToP3(const RGB &color);
 
+    /**
+     * @brief Converts a RGB color to P3 with the given gamut mapping.
+     */
+    P3 rgbToP3(const RGB &color, GamutMapping mapping);
+
+    /**
+     * @brief Converts a RGB color to P3, computing in the given precision.
+     * @tparam Scalar `double` or `float` (e.g. `rgbToP3<float>(rgb)`).
+     */
+    template <typename Scalar>
+    P3 rgbToP3(const RGB &color);
+
     /**
      * @brief Converts an P3 color to RGB.
      *
@@ -75,4 +182,82 @@ namespace oklab
      * @return RGB representation of the input color.
      */
     RGB p3ToRgb(const P3 &color);
+
+    /**
+     * @brief Converts a P3 color to RGB with the given gamut mapping.
+     */
+    RGB p3ToRgb(const P3 &color, GamutMapping mapping);
+
+    /**
+     * @brief Converts a P3 color to RGB, computing in the given precision.
+     * @tparam Scalar `double` or `float` (e.g. `p3ToRgb<float>(p3)`).
+     */
+    template <typename Scalar>
+    RGB p3ToRgb(const P3 &color);
+
+    /**
+     * @brief Converts an RGB color of the given bit depth to an Oklab color.
+     * @param color RGB color, with codes in [0, maxCodeValue(depth)].
+     */
+    Oklab rgbToOklab(const RGB &color, BitDepth depth);
+
+    /**
+     * @brief Converts an Oklab color to an RGB color of the given bit depth.
+     * Includes gamut mapping to ensure the output stays within the valid RGB range.
+     */
+    RGB oklabToRgb(const Oklab &color, BitDepth depth);
+
+    /**
+     * @brief Converts an Oklab color to an RGB color of the given bit depth, with the given gamut mapping.
+     */
+    RGB oklabToRgb(const Oklab &color, BitDepth depth, GamutMapping mapping);
+
+    /**
+     * @brief Converts a P3 color of the given bit depth to an Oklab color.
+     * @param color P3 color, with codes in [0, maxCodeValue(depth)].
+     */
+    Oklab p3ToOklab(const P3 &color, BitDepth depth);
+
+    /**
+     * @brief Converts an Oklab color to a P3 color of the given bit depth.
+     * Includes gamut mapping to ensure the output stays within the valid P3 range.
+     */
+    P3 oklabToP3(const Oklab &color, BitDepth depth);
+
+    /**
+     * @brief Converts an Oklab color to a P3 color of the given bit depth, with the given gamut mapping.
+     */
+    P3 oklabToP3(const Oklab &color, BitDepth depth, GamutMapping mapping);
+
+    /**
+     * @brief Converts a gamma-encoded sRGB color, channels in [0, 1], to an Oklab color.
+     */
+    Oklab gammaSRGBToOklab(const GammaSRGB &color);
+
+    /**
+     * @brief Converts an Oklab color to a gamma-encoded sRGB color, without quantization.
+     * Includes gamut mapping, as `oklabToRgb`.
+     */
+    GammaSRGB oklabToGammaSRGB(const Oklab &color);
+
+    /**
+     * @brief Converts an Oklab color to a gamma-encoded sRGB color with the given gamut mapping.
+     */
+    GammaSRGB oklabToGammaSRGB(const Oklab &color, GamutMapping mapping);
+
+    /**
+     * @brief Converts a gamma-encoded P3 color, channels in [0, 1], to an Oklab color.
+     */
+    Oklab gammaP3ToOklab(const GammaP3 &color);
+
+    /**
+     * @brief Converts an Oklab color to a gamma-encoded P3 color, without quantization.
+     * Includes gamut mapping, as `oklabToP3`.
+     */
+    GammaP3 oklabToGammaP3(const Oklab &color);
+
+    /**
+     * @brief Converts an Oklab color to a gamma-encoded P3 color with the given gamut mapping.
+     */
+    GammaP3 oklabToGammaP3(const Oklab &color, GamutMapping mapping);
 } // namespace oklab
\ No newline at end of file
@@ -1,11 +1,21 @@
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
+
 #include "ColorTypes.h"
 #include "ColorConversions.h" // For conversion functions
+#include "ColorBatchConversions.h"
+#include "GamutMapping.h"
 
 /**
  * @file ColorManipulations.h
  * @brief Provides template functions for color manipulations performed in the Oklab/Oklch color spaces.
+ *
+ * The single-color functions convert each color to Oklch and back. `adjustColors` applies the
+ * same lightness, chroma and hue adjustments to whole arrays, block by block: in Oklab, where a
+ * chroma scaling and a hue rotation are one 2x2 matrix applied to (a, b), so no trigonometry runs
+ * per color, and with the batch conversions on the way in and out.
  */
 
 namespace oklab
@@ -48,7 +58,7 @@ namespace oklab
         Oklch oklch = convertToOklch(color);
         oklch[0] *= (1 - amount); // Adjust lightness channel
 
-        return convertFromOklch<Colorype>(oklch);
+        return convertFromOklch<ColorType>(oklch);
     }
 
     /**
@@ -66,4 +76,72 @@ namespace oklab
         return convertFromOklch<ColorType>(oklch);
     }
 
+    /**
+     * @brief Scales the chroma of a given color in the Oklch color space.
+     * @param color Color to saturate.
+     * @param amount Relative change of the chroma (0 - no change, -1 - achromatic, 1 - doubled).
+     * @return Saturated color of the same type as the input.
+     */
+    template <typename ColorType>
+    ColorType saturate(const ColorType &color, double amount)
+    {
+        Oklch oklch = convertToOklch(color);
+        oklch[1] *= std::max(0.0, 1 + amount); // Chroma stays non-negative
+
+        return convertFromOklch<ColorType>(oklch);
+    }
+
+    /**
+     * @brief Rotates the hue of a given color in the Oklch color space.
+     * @param color Color to rotate.
+     * @param degrees Rotation of the hue, in degrees.
+     * @return Rotated color of the same type as the input; achromatic colors are unchanged.
+     */
+    template <typename ColorType>
+    ColorType rotateHue(const ColorType &color, double degrees)
+    {
+        Oklch oklch = convertToOklch(color);
+        oklch[2] += degrees; // A NaN (powerless) hue stays NaN
+
+        return convertFromOklch<ColorType>(oklch);
+    }
+
+    /**
+     * @brief Adjustments applied by `adjustColors`, all zero for no change.
+     */
+    struct OklchAdjustment
+    {
+        /** Positive amounts lighten as `lighten`, negative amounts darken as `darken(-lightness)`. */
+        double lightness = 0.0;
+        /** Relative change of the chroma, as `saturate`. */
+        double chroma = 0.0;
+        /** Rotation of the hue in degrees, as `rotateHue`. */
+        double hue = 0.0;
+    };
+
+    /**
+     * @brief Adjusts the lightness, chroma and hue of an array of colors.
+     *
+     * Available for `RGB` and `P3`, mapped back into their gamut, and for `Oklab`, unmapped, e.g.
+     * `adjustColors<RGB>(input, output, adjustment)`. Lightness matches `lighten` / `darken`;
+     * chroma and hue are applied in Oklab, so results match `saturate` and `rotateHue` up to
+     * rounding (and to the colors' 8-bit codes for `RGB` and `P3`, within one code).
+     *
+     * @param input Colors to adjust.
+     * @param output Receives the adjusted colors; must have the same size as the input, may be the
+     * input itself.
+     * @param mapping Gamut mapping of `RGB` and `P3` outputs.
+     * @throws std::invalid_argument If the spans differ in size.
+     */
+    template <typename ColorType>
+    void adjustColors(Span<const ColorType> input, Span<ColorType> output, const OklchAdjustment &adjustment,
+                      GamutMapping mapping = defaultGamutMapping());
+
+    /**
+     * @brief Specialization for `Oklab` colors, adjusted without conversion or gamut mapping: the
+     * mapping argument is ignored.
+     */
+    template <>
+    void adjustColors<Oklab>(Span<const Oklab>, Span<Oklab>, const OklchAdjustment &, GamutMapping);
+
 } // namespace oklab
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+/**
+ * @file ColorMatrices.h
+ * @brief Contains the transformation matrices shared by the runtime and constexpr conversions.
+ */
+
+namespace oklab
+{
+    inline constexpr double RGB_TO_LMS[3][3] = {
+        {0.4122214694707629, 0.5363325372617349, 0.0514459932675022},
+        {0.2119034958178251, 0.6806995506452345, 0.1073969535369406},
+        {0.0883024591900564, 0.2817188391361215, 0.6299787016738222}};
+
+    inline constexpr double LMS_TO_RGB[3][3] = {
+        {4.0767416360759601, -3.3077115392580625, 0.2309699031821046},
+        {-1.2684379732850317, 2.6097573492876882, -0.3413193760026572},
+        {-0.0041960761386754, -0.7034186179359361, 1.7076146940746113}};
+
+    inline constexpr double P3_TO_LMS[3][3] = {
+        {0.4813798527499544, 0.4621183710113182, 0.0565017762387275},
+        {0.2288319418112447, 0.6532168193835679, 0.1179512388051878},
+        {0.0839457523229932, 0.2241652709775665, 0.6918889766994405}};
+
+    inline constexpr double LMS_TO_P3[3][3] = {
+        {3.1277689713618742, -2.2571357625916386, 0.1293667912297653},
+        {-1.0910090184377974, 2.4133317103069212, -0.3223226918691247},
+        {-0.0260108019385704, -0.5080413317041669, 1.5340521336427371}};
+
+    inline constexpr double LMSG_TO_OKLAB[3][3] = {
+        {0.2104542683093140, 0.7936177747023054, -0.0040720430116193},
+        {1.9779985324311684, -2.4285922420485799, 0.4505937096174110},
+        {0.0259040424655478, 0.7827717124575296, -0.8086757549230774}};
+
+    inline constexpr double OKLAB_TO_LMSG[3][3] = {
+        {1.0000000000000000, 0.3963377773761749, 0.2158037573099136},
+        {1.0000000000000000, -0.1055613458156586, -0.0638541728258133},
+        {1.0000000000000000, -0.0894841775298119, -1.2914855480194092}};
+} // namespace oklab
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <initializer_list>
 #include <type_traits>
 
 // Tag definitions
@@ -39,40 +41,46 @@ struct TaggedArray : public std::array<T, N>
     using Base = std::array<T, N>;
     using Base::Base; // Inherit constructors
 
+    // Constructors and assignments are constexpr so colors can be computed at compile time
+    // (see ConstexprConversions.h).
+
     // Default constructor
-    TaggedArray() : Base() {}
+    constexpr TaggedArray() : Base() {}
 
     // Initializer list constructor
-    TaggedArray(std::initializer_list<T> ilist)
+    constexpr TaggedArray(std::initializer_list<T> ilist) : Base()
     {
-        std::copy_n(ilist.begin(), N, this->begin());
+        for (int i = 0; i < N; ++i)
+        {
+            (*this)[i] = ilist.begin()[i];
+        }
     }
 
     // Allow conversion from std::array
-    TaggedArray(const std::array<T, N> &other) : Base(other) {}
+    constexpr TaggedArray(const std::array<T, N> &other) : Base(other) {}
 
     // Copy constructor
-    TaggedArray(const TaggedArray &other) : Base(other) {}
+    constexpr TaggedArray(const TaggedArray &other) : Base(other) {}
 
     // Move constructor
-    TaggedArray(TaggedArray &&other) noexcept : Base(std::move(other)) {}
+    constexpr TaggedArray(TaggedArray &&other) noexcept : Base(std::move(other)) {}
 
     // Assignment from std::array
-    TaggedArray &operator=(const std::array<T, N> &other)
+    constexpr TaggedArray &operator=(const std::array<T, N> &other)
     {
         Base::operator=(other);
         return *this;
     }
 
     // Copy assignment operator
-    TaggedArray &operator=(const TaggedArray &other)
+    constexpr TaggedArray &operator=(const TaggedArray &other)
     {
         Base::operator=(other);
         return *this;
     }
 
     // Move assignment operator
-    TaggedArray &operator=(TaggedArray &&other) noexcept
+    constexpr TaggedArray &operator=(TaggedArray &&other) noexcept
     {
         Base::operator=(std::move(other));
         return *this;
@@ -93,43 +101,100 @@ namespace oklab
     using RGB = TaggedArray<int, 3, RGBTag>;
 
     /**
-     * @brief Represents an RGB color in gamma-scaled doubleing-point format.
+     * @brief Represents an P3 color using integers (0-255).
      */
-    using GammaSRGB = TaggedArray<double, 3, GammaSRGBTag>;
+    using P3 = TaggedArray<int, 3, P3Tag>;
 
     /**
-     * @brief Represents an RGB color in linear-scaled doubleing-point format.
+     * @brief Bit depths of integer gamma-encoded channels.
+     *
+     * `RGB` and `P3` hold 8-bit codes by default; the conversions taking a `BitDepth` read and
+     * write codes in [0, maxCodeValue(depth)] instead.
      */
-    using LinearSRGB = TaggedArray<double, 3, LinearSRGBTag>;
+    enum class BitDepth
+    {
+        Eight = 8,
+        Ten = 10,
+        Twelve = 12,
+        Sixteen = 16
+    };
 
     /**
-     * @brief Represents an P3 color using integers (0-255).
+     * @brief Returns the largest code of a bit depth, the code of full intensity.
      */
-    using P3 = TaggedArray<int, 3, P3Tag>;
+    constexpr int maxCodeValue(BitDepth depth)
+    {
+        return (1 << static_cast<int>(depth)) - 1;
+    }
+
+    /**
+     * @brief Floating-point color types, generic over the scalar type (`double` or `float`).
+     */
+    template <typename Scalar>
+    using BasicGammaSRGB = TaggedArray<Scalar, 3, GammaSRGBTag>;
+
+    template <typename Scalar>
+    using BasicLinearSRGB = TaggedArray<Scalar, 3, LinearSRGBTag>;
+
+    template <typename Scalar>
+    using BasicGammaP3 = TaggedArray<Scalar, 3, GammaP3Tag>;
+
+    template <typename Scalar>
+    using BasicLinearP3 = TaggedArray<Scalar, 3, LinearP3Tag>;
+
+    template <typename Scalar>
+    using BasicLMS = TaggedArray<Scalar, 3, LMSTag>;
+
+    template <typename Scalar>
+    using BasicOklab = TaggedArray<Scalar, 3, OklabTag>;
+
+    template <typename Scalar>
+    using BasicOklch = TaggedArray<Scalar, 3, OklchTag>;
+
+    /**
+     * @brief Represents an RGB color in gamma-scaled doubleing-point format.
+     */
+    using GammaSRGB = BasicGammaSRGB<double>;
+
+    /**
+     * @brief Represents an RGB color in linear-scaled doubleing-point format.
+     */
+    using LinearSRGB = BasicLinearSRGB<double>;
 
     /**
      * @brief Represents an P3 color in gamma-scaled doubleing-point format.
      */
-    using GammaP3 = TaggedArray<double, 3, GammaP3Tag>;
+    using GammaP3 = BasicGammaP3<double>;
 
     /**
      * @brief Represents an P3 color in linear-scaled doubleing-point format.
      */
-    using LinearP3 = TaggedArray<double, 3, LinearP3Tag>;
+    using LinearP3 = BasicLinearP3<double>;
 
     /**
      * @brief Represents an intermediate LMS color.
      */
-    using LMS = TaggedArray<double, 3, LMSTag>;
+    using LMS = BasicLMS<double>;
 
     /**
      * @brief Represents a color in the Oklab color space.
      */
-    using Oklab = TaggedArray<double, 3, OklabTag>;
+    using Oklab = BasicOklab<double>;
 
     /**
      * @brief Represents a color in the Oklch color space.
      */
-    using Oklch = TaggedArray<double, 3, OklchTag>;
+    using Oklch = BasicOklch<double>;
+
+    /**
+     * @brief Single-precision variants, used by the float conversion pipeline.
+     */
+    using GammaSRGBf = BasicGammaSRGB<float>;
+    using LinearSRGBf = BasicLinearSRGB<float>;
+    using GammaP3f = BasicGammaP3<float>;
+    using LinearP3f = BasicLinearP3<float>;
+    using LMSf = BasicLMS<float>;
+    using Oklabf = BasicOklab<float>;
+    using Oklchf = BasicOklch<float>;
 
 } // namespace oklab
\ No newline at end of file
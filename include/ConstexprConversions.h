@@ -0,0 +1,528 @@
+#pragma once
+
+#include <array>
+#include <limits>
+
+#include "ColorTypes.h"
+#include "ColorMatrices.h"
+#include "ConversionFormulas.h"
+#include "GamutMapping.h"
+#include "GamutMappingFormulas.h"
+
+/**
+ * @file ConstexprConversions.h
+ * @brief Provides constexpr versions of the scalar conversions, for compile-time palettes.
+ *
+ * The functions in `oklab::constant` run the formulas of their runtime counterparts in
+ * ColorConversions.h, gamut mappings included (ConversionFormulas.h, GamutMappingFormulas.h),
+ * but only use constexpr arithmetic, so they can be evaluated by the compiler (C++17 is enough):
+ *
+ * ```cpp
+ * constexpr oklab::Oklab brand = oklab::constant::rgbToOklab(oklab::RGB{255, 87, 51});
+ * constexpr oklab::RGB preview = oklab::constant::p3ToRgb(oklab::P3{255, 0, 0}, oklab::GamutMapping::Clamp);
+ * ```
+ *
+ * Without a `GamutMapping` argument, they apply `DEFAULT_GAMUT_MAPPING`, the MAPPING_ALGORITHM
+ * the library was built with. `std::pow`, `std::sqrt`, `std::cbrt` and the trigonometric
+ * functions are replaced by series evaluated to full double precision, so Oklab results are
+ * within a few ulps of the runtime ones and 8-bit results are identical on all 2^24 inputs. At
+ * runtime, prefer the library functions: these ones are much slower.
+ */
+
+namespace oklab
+{
+    namespace constant
+    {
+        namespace detail
+        {
+            constexpr double PI = 3.14159265358979323846;
+            // ln(2) and pi/2 split in a high part with trailing zero bits and a low part, so that
+            // multiples of the high part are exact.
+            constexpr double LN2_HIGH = 6.93147180369123816490e-01;
+            constexpr double LN2_LOW = 1.90821492927058770002e-10;
+            constexpr double INV_LN2 = 1.44269504088896338700e+00;
+            constexpr double PI_OVER_2_HIGH = 1.57079632673412561417e+00;
+            constexpr double PI_OVER_2_LOW = 6.07710050650619224932e-11;
+            constexpr double SQRT_2 = 1.41421356237309504880;
+
+            constexpr double abs(double value)
+            {
+                return value < 0 ? -value : value;
+            }
+
+            constexpr int roundToInt(double value)
+            {
+                // Half away from zero, like std::round
+                int truncated = static_cast<int>(value);
+                double fraction = value - truncated;
+                if (fraction >= 0.5)
+                {
+                    return truncated + 1;
+                }
+                if (fraction <= -0.5)
+                {
+                    return truncated - 1;
+                }
+                return truncated;
+            }
+
+            constexpr double scaleByPowerOfTwo(double value, int exponent)
+            {
+                for (; exponent > 0; --exponent)
+                {
+                    value *= 2.0;
+                }
+                for (; exponent < 0; ++exponent)
+                {
+                    value *= 0.5;
+                }
+                return value;
+            }
+
+            /**
+             * @brief Splits a positive finite value into `mantissa * 2^exponent`, mantissa in [1, 2).
+             */
+            struct Decomposition
+            {
+                double mantissa;
+                int exponent;
+            };
+
+            constexpr Decomposition decompose(double value)
+            {
+                int exponent = 0;
+                while (value >= 18446744073709551616.0)
+                {
+                    value /= 18446744073709551616.0; // 2^64
+                    exponent += 64;
+                }
+                while (value < 1.0 / 18446744073709551616.0)
+                {
+                    value *= 18446744073709551616.0;
+                    exponent -= 64;
+                }
+                while (value >= 2.0)
+                {
+                    value *= 0.5;
+                    ++exponent;
+                }
+                while (value < 1.0)
+                {
+                    value *= 2.0;
+                    --exponent;
+                }
+                return Decomposition{value, exponent};
+            }
+
+            /**
+             * @brief Exact `std::fmod` for a positive divisor.
+             */
+            constexpr double fmod(double value, double divisor)
+            {
+                double remainder = abs(value);
+                while (remainder >= divisor)
+                {
+                    // divisor * 2^k <= remainder < divisor * 2^(k+1): the subtraction is exact
+                    double multiple = divisor;
+                    while (multiple * 2.0 <= remainder)
+                    {
+                        multiple *= 2.0;
+                    }
+                    remainder -= multiple;
+                }
+                return value < 0 ? -remainder : remainder;
+            }
+
+            constexpr double sqrt(double value)
+            {
+                if (value <= 0)
+                {
+                    return 0.0;
+                }
+
+                Decomposition parts = decompose(value);
+                if (parts.exponent % 2 != 0)
+                {
+                    parts.mantissa *= 2.0;
+                    parts.exponent -= 1;
+                }
+
+                // Newton iterations on a value in [1, 4)
+                double root = (1.0 + parts.mantissa) / 2.0;
+                for (int step = 0; step < 6; ++step)
+                {
+                    root = (root + parts.mantissa / root) / 2.0;
+                }
+                return scaleByPowerOfTwo(root, parts.exponent / 2);
+            }
+
+            constexpr double cbrt(double value)
+            {
+                if (value == 0)
+                {
+                    return value;
+                }
+
+                Decomposition parts = decompose(abs(value));
+                int remainder = ((parts.exponent % 3) + 3) % 3;
+                parts.mantissa = scaleByPowerOfTwo(parts.mantissa, remainder);
+                parts.exponent -= remainder;
+
+                // Halley iterations on a value in [1, 8)
+                double root = 1.0 + (parts.mantissa - 1.0) / 7.0;
+                for (int step = 0; step < 6; ++step)
+                {
+                    double cube = root * root * root;
+                    root -= root * ((cube - parts.mantissa) / (2.0 * cube + parts.mantissa));
+                }
+
+                root = scaleByPowerOfTwo(root, parts.exponent / 3);
+                return value < 0 ? -root : root;
+            }
+
+            constexpr double log(double value)
+            {
+                Decomposition parts = decompose(value);
+                if (parts.mantissa > SQRT_2)
+                {
+                    parts.mantissa *= 0.5;
+                    parts.exponent += 1;
+                }
+
+                // ln(m) = 2 atanh(u), u = (m - 1) / (m + 1), |u| < 0.172
+                double u = (parts.mantissa - 1.0) / (parts.mantissa + 1.0);
+                double u2 = u * u;
+                double series = 0.0;
+                double power = u;
+                for (int term = 1; term < 40; term += 2)
+                {
+                    series += power / term;
+                    power *= u2;
+                }
+
+                return parts.exponent * LN2_HIGH + (parts.exponent * LN2_LOW + 2.0 * series);
+            }
+
+            constexpr double exp(double value)
+            {
+                // value = n ln(2) + r, |r| <= ln(2) / 2
+                double scaled = value * INV_LN2;
+                int n = static_cast<int>(scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+                double r = (value - n * LN2_HIGH) - n * LN2_LOW;
+
+                double series = 1.0;
+                double term = 1.0;
+                for (int k = 1; k < 24; ++k)
+                {
+                    term *= r / k;
+                    series += term;
+                }
+                return scaleByPowerOfTwo(series, n);
+            }
+
+            /**
+             * @brief `base^exponent` for a non-negative base.
+             */
+            constexpr double pow(double base, double exponent)
+            {
+                return base == 0 ? 0.0 : exp(exponent * log(base));
+            }
+
+            /**
+             * @brief Sine and cosine of an angle in [0, 2 pi].
+             */
+            struct SineCosine
+            {
+                double sine;
+                double cosine;
+            };
+
+            constexpr SineCosine sinCos(double angle)
+            {
+                // angle = quadrant pi/2 + r, |r| <= pi/4
+                int quadrant = static_cast<int>(angle / PI_OVER_2_HIGH + 0.5);
+                double r = (angle - quadrant * PI_OVER_2_HIGH) - quadrant * PI_OVER_2_LOW;
+                double r2 = r * r;
+
+                double sine = 0.0;
+                double cosine = 0.0;
+                double sineTerm = r;
+                double cosineTerm = 1.0;
+                for (int k = 1; k < 40; k += 2)
+                {
+                    sine += sineTerm;
+                    cosine += cosineTerm;
+                    sineTerm *= -r2 / ((k + 1) * (k + 2));
+                    cosineTerm *= -r2 / (k * (k + 1));
+                }
+
+                switch (quadrant % 4)
+                {
+                case 0:
+                    return SineCosine{sine, cosine};
+                case 1:
+                    return SineCosine{cosine, -sine};
+                case 2:
+                    return SineCosine{-sine, -cosine};
+                default:
+                    return SineCosine{-cosine, sine};
+                }
+            }
+
+            /**
+             * @brief Arc tangent of a value in [0, 1].
+             */
+            constexpr double atanUnit(double value)
+            {
+                // atan(t) = 2 atan(t / (1 + sqrt(1 + t^2))), applied twice: |t| <= tan(pi/16)
+                for (int halving = 0; halving < 2; ++halving)
+                {
+                    value = value / (1.0 + sqrt(1.0 + value * value));
+                }
+
+                double value2 = value * value;
+                double series = 0.0;
+                double power = value;
+                for (int term = 1; term < 40; term += 2)
+                {
+                    series += (term % 4 == 1 ? power : -power) / term;
+                    power *= value2;
+                }
+                return 4.0 * series;
+            }
+
+            constexpr double atan2(double y, double x)
+            {
+                if (x == 0 && y == 0)
+                {
+                    return 0.0;
+                }
+
+                double absY = abs(y);
+                double absX = abs(x);
+                double angle = absY <= absX ? atanUnit(absY / absX) : PI / 2.0 - atanUnit(absX / absY);
+                if (x < 0)
+                {
+                    angle = PI - angle;
+                }
+                return y < 0 ? -angle : angle;
+            }
+
+            constexpr double constrainAngle(double angle)
+            {
+                return fmod((fmod(angle, 360.0) + 360.0), 360.0);
+            }
+
+            constexpr double clamp(double value)
+            {
+                return value < 0.0 ? 0.0 : (1.0 < value ? 1.0 : value);
+            }
+
+            /**
+             * @brief The `Math` policy of ConversionFormulas.h, evaluated by the compiler.
+             */
+            struct Math
+            {
+                static constexpr double sqrt(double value)
+                {
+                    return detail::sqrt(value);
+                }
+
+                static constexpr double cbrt(double value)
+                {
+                    return detail::cbrt(value);
+                }
+
+                static constexpr double pow(double base, double exponent)
+                {
+                    return detail::pow(base, exponent);
+                }
+
+                static constexpr void sinCosDegrees(double degrees, double &sine, double &cosine)
+                {
+                    SineCosine sineCosine = sinCos(constrainAngle(degrees) * PI / 180.0);
+                    sine = sineCosine.sine;
+                    cosine = sineCosine.cosine;
+                }
+
+                static constexpr double hueDegrees(double a, double b)
+                {
+                    return constrainAngle(atan2(b, a) * 180.0 / PI);
+                }
+            };
+        } // namespace detail
+
+        /** @brief constexpr equivalent of `gammaToLinear`. */
+        constexpr double gammaToLinear(double value)
+        {
+            return formulas::gammaToLinear<detail::Math>(value);
+        }
+
+        /** @brief constexpr equivalent of `linearToGamma`. */
+        constexpr double linearToGamma(double value)
+        {
+            return formulas::linearToGamma<detail::Math>(value);
+        }
+
+        /** @brief constexpr equivalent of `oklchToOklab`. */
+        constexpr Oklab oklchToOklab(const Oklch &oklch)
+        {
+            return formulas::oklchToOklab<detail::Math>(oklch);
+        }
+
+        /** @brief constexpr equivalent of `oklabToOklch`. */
+        constexpr Oklch oklabToOklch(const Oklab &oklab)
+        {
+            return formulas::oklabToOklch<detail::Math>(oklab);
+        }
+
+        /** @brief constexpr equivalent of `deltaE`. */
+        constexpr double deltaE(const Oklab &oklab1, const Oklab &oklab2)
+        {
+            return formulas::deltaE<detail::Math>(oklab1, oklab2);
+        }
+
+        namespace detail
+        {
+            /**
+             * @brief The `Space` policy of GamutMappingFormulas.h for an 8-bit color type and its
+             * linear color type, evaluated by the compiler.
+             */
+            template <typename ColorType, typename LinearColorType>
+            struct Space;
+
+            template <typename ColorType, typename LinearColorType, const double (&TO_LMS)[3][3], const double (&FROM_LMS)[3][3]>
+            struct BasicSpace
+            {
+                using Color = ColorType;
+                using LinearColor = LinearColorType;
+                using Scalar = double;
+
+                static constexpr LinearColorType decode(const ColorType &color)
+                {
+                    return LinearColorType{gammaToLinear(color[0] / 255.0), gammaToLinear(color[1] / 255.0), gammaToLinear(color[2] / 255.0)};
+                }
+
+                static constexpr Oklab toOklab(const LinearColorType &linearColor)
+                {
+                    return formulas::lmsToOklab<Math>(LMS(formulas::multiplyMatrix(TO_LMS, linearColor)));
+                }
+
+                static constexpr LinearColorType toLinear(const Oklab &oklab)
+                {
+                    return LinearColorType(formulas::multiplyMatrix(FROM_LMS, formulas::oklabToLms(oklab)));
+                }
+
+                static constexpr PolarOklab toPolar(const Oklab &oklab)
+                {
+                    return formulas::oklabToPolar<Math>(oklab);
+                }
+
+                static constexpr bool isInGamut(const LinearColorType &linearColor)
+                {
+                    return linearColor[0] >= 0.0 && linearColor[0] <= 1.0 &&
+                           linearColor[1] >= 0.0 && linearColor[1] <= 1.0 &&
+                           linearColor[2] >= 0.0 && linearColor[2] <= 1.0;
+                }
+
+                static constexpr LinearColorType clip(const LinearColorType &linearColor)
+                {
+                    return LinearColorType{clamp(linearColor[0]), clamp(linearColor[1]), clamp(linearColor[2])};
+                }
+
+                static constexpr ColorType encode(const LinearColorType &linearColor)
+                {
+                    return ColorType{
+                        roundToInt(linearToGamma(linearColor[0]) * 255.0),
+                        roundToInt(linearToGamma(linearColor[1]) * 255.0),
+                        roundToInt(linearToGamma(linearColor[2]) * 255.0)};
+                }
+
+                static constexpr double deltaE(const Oklab &oklab1, const Oklab &oklab2)
+                {
+                    return constant::deltaE(oklab1, oklab2);
+                }
+
+                static constexpr double sqrt(double value)
+                {
+                    return Math::sqrt(value);
+                }
+
+                static constexpr double cbrt(double value)
+                {
+                    return Math::cbrt(value);
+                }
+            };
+
+            template <>
+            struct Space<RGB, LinearSRGB> : BasicSpace<RGB, LinearSRGB, RGB_TO_LMS, LMS_TO_RGB>
+            {
+            };
+
+            template <>
+            struct Space<P3, LinearP3> : BasicSpace<P3, LinearP3, P3_TO_LMS, LMS_TO_P3>
+            {
+            };
+
+            /**
+             * @brief constexpr equivalent of the gamut mapping of the runtime conversions, step for step.
+             */
+            template <typename ColorType, typename LinearColorType>
+            constexpr ColorType mapToGamut(const Oklab &oklab, GamutMapping mapping)
+            {
+                using TargetSpace = Space<ColorType, LinearColorType>;
+
+                switch (mapping)
+                {
+                case GamutMapping::Css4:
+                    return formulas::css4::map<TargetSpace>(oklab);
+                case GamutMapping::Cusp:
+                    return formulas::cusp::map<TargetSpace>(oklab);
+                case GamutMapping::Clamp:
+                    return TargetSpace::encode(TargetSpace::clip(TargetSpace::toLinear(oklab)));
+                case GamutMapping::None:
+                default:
+                    return TargetSpace::encode(TargetSpace::toLinear(oklab));
+                }
+            }
+        } // namespace detail
+
+        /** @brief constexpr equivalent of `rgbToOklab`. */
+        constexpr Oklab rgbToOklab(const RGB &rgb)
+        {
+            using TargetSpace = detail::Space<RGB, LinearSRGB>;
+            return TargetSpace::toOklab(TargetSpace::decode(rgb));
+        }
+
+        /** @brief constexpr equivalent of `p3ToOklab`. */
+        constexpr Oklab p3ToOklab(const P3 &p3)
+        {
+            using TargetSpace = detail::Space<P3, LinearP3>;
+            return TargetSpace::toOklab(TargetSpace::decode(p3));
+        }
+
+        /** @brief constexpr equivalent of `oklabToRgb`. */
+        constexpr RGB oklabToRgb(const Oklab &oklab, GamutMapping mapping = DEFAULT_GAMUT_MAPPING)
+        {
+            return detail::mapToGamut<RGB, LinearSRGB>(oklab, mapping);
+        }
+
+        /** @brief constexpr equivalent of `oklabToP3`. */
+        constexpr P3 oklabToP3(const Oklab &oklab, GamutMapping mapping = DEFAULT_GAMUT_MAPPING)
+        {
+            return detail::mapToGamut<P3, LinearP3>(oklab, mapping);
+        }
+
+        /** @brief constexpr equivalent of `rgbToP3`. */
+        constexpr P3 rgbToP3(const RGB &rgb, GamutMapping mapping = DEFAULT_GAMUT_MAPPING)
+        {
+            return constant::oklabToP3(constant::rgbToOklab(rgb), mapping);
+        }
+
+        /** @brief constexpr equivalent of `p3ToRgb`. */
+        constexpr RGB p3ToRgb(const P3 &p3, GamutMapping mapping = DEFAULT_GAMUT_MAPPING)
+        {
+            return constant::oklabToRgb(constant::p3ToOklab(p3), mapping);
+        }
+    } // namespace constant
+} // namespace oklab
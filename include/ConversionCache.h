@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "ColorTypes.h"
+#include "ColorBatchConversions.h"
+
+/**
+ * @file ConversionCache.h
+ * @brief Provides a lazily filled, lock-free cache of the 8-bit gamut-mapped conversions.
+ *
+ * A middle ground between converting every color and building a whole `ConversionTable`: the
+ * 2^24 inputs are split into 16x16x16 blocks, computed with the batch conversions the first time
+ * one of their colors is converted. Colors that recur, as they do in long-running workers, are
+ * then served from memory.
+ *
+ * Blocks are published with an atomic pointer per block: one thread claims an empty block and
+ * fills it, while the others convert their colors directly until it is published. Nothing
+ * waits and no lock is taken. Once the memory limit is reached, colors of blocks not yet cached
+ * are converted directly.
+ */
+
+namespace oklab
+{
+    /**
+     * @brief Counters of a `ConversionCache`, summed over all threads.
+     */
+    struct CacheStatistics
+    {
+        /** Colors served from a cached block. */
+        std::uint64_t hits;
+        /** Colors whose block was not cached yet. */
+        std::uint64_t misses;
+        /** Blocks computed, each after a miss. */
+        std::uint64_t blockFills;
+        /** Misses converted directly: block being filled by another thread, or memory limit reached. */
+        std::uint64_t bypasses;
+    };
+
+    /**
+     * @brief Cache of the 8-bit `InputType -> OutputType` conversion.
+     *
+     * Available for `ConversionCache<P3, RGB>` (`p3ToRgb`) and `ConversionCache<RGB, P3>`
+     * (`rgbToP3`); results are identical to these functions. All member functions are
+     * thread-safe.
+     */
+    template <typename InputType, typename OutputType>
+    class ConversionCache
+    {
+    public:
+        /** Colors per block axis. */
+        static constexpr std::size_t BLOCK_EDGE = 16;
+        static constexpr std::size_t BLOCK_ENTRIES = BLOCK_EDGE * BLOCK_EDGE * BLOCK_EDGE;
+        static constexpr std::size_t BLOCK_BYTES = 3 * BLOCK_ENTRIES;
+        static constexpr std::size_t BLOCK_COUNT = (std::size_t{1} << 24) / BLOCK_ENTRIES;
+
+        /**
+         * @param memoryLimit Maximum size of the cached blocks in bytes (12 KiB each, 48 MiB
+         * for all of them). The block directory adds a fixed 32 KiB.
+         */
+        explicit ConversionCache(std::size_t memoryLimit = BLOCK_COUNT * BLOCK_BYTES);
+
+        ~ConversionCache();
+
+        ConversionCache(const ConversionCache &) = delete;
+        ConversionCache &operator=(const ConversionCache &) = delete;
+
+        /**
+         * @brief Converts one color; its channels must be in [0, 255].
+         */
+        OutputType convert(const InputType &color);
+
+        /**
+         * @brief Converts a buffer of colors.
+         * @throws std::invalid_argument If the spans differ in size.
+         */
+        void convert(Span<const InputType> input, Span<OutputType> output);
+
+        CacheStatistics statistics() const;
+
+        /** Size of the cached blocks in bytes. */
+        std::size_t memoryUsage() const;
+
+    private:
+        // Counters are striped over cache lines, each thread updating its own slot.
+        static constexpr std::size_t COUNTER_SLOTS = 16;
+
+        struct alignas(64) CounterSlot
+        {
+            std::atomic<std::uint64_t> hits{0};
+            std::atomic<std::uint64_t> misses{0};
+            std::atomic<std::uint64_t> blockFills{0};
+            std::atomic<std::uint64_t> bypasses{0};
+        };
+
+        const unsigned char *fillBlock(std::size_t block, CounterSlot &counters);
+
+        std::size_t maxBlocks_;
+        std::atomic<std::size_t> allocatedBlocks_{0};
+        // Null when empty, FILLING_BLOCK while a thread computes it, then the block's entries.
+        std::atomic<const unsigned char *> blocks_[BLOCK_COUNT];
+        CounterSlot counters_[COUNTER_SLOTS];
+    };
+
+    using P3ToRgbCache = ConversionCache<P3, RGB>;
+    using RgbToP3Cache = ConversionCache<RGB, P3>;
+} // namespace oklab
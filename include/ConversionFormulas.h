@@ -0,0 +1,228 @@
+#pragma once
+
+#include <array>
+#include <limits>
+
+#include "ColorTypes.h"
+#include "ColorMatrices.h"
+
+/**
+ * @file ConversionFormulas.h
+ * @brief Contains the scalar formulas shared by the runtime and constexpr conversions.
+ *
+ * Each formula is a constexpr template over a `Math` policy, a type with the static functions
+ * it needs among:
+ * - `sqrt(x)`, `cbrt(x)` and `pow(base, exponent)`;
+ * - `sinCosDegrees(degrees, sine, cosine)`, writing the sine and cosine of an angle in degrees;
+ * - `hueDegrees(a, b)`, the angle of (a, b) in degrees, in [0, 360).
+ *
+ * The library instantiates them with libm and its branchless approximations, ConstexprConversions.h
+ * with series evaluated by the compiler, so both run the same steps and differ only by the
+ * rounding of these functions.
+ */
+
+namespace oklab
+{
+    /**
+     * @brief Oklch color whose hue is carried as its cosine and sine instead of an angle.
+     *
+     * Colors of the same lightness and hue, at any chroma, are then two multiplications away,
+     * without trigonometry: the CSS4 gamut mapping moves along this line for its whole search.
+     * Achromatic colors (the NaN hue of Oklch) have a cosine and sine of 0.
+     */
+    template <typename Scalar>
+    struct BasicPolarOklab
+    {
+        Scalar lightness;
+        Scalar chroma;
+        Scalar cosine;
+        Scalar sine;
+
+        /**
+         * @brief The Oklab color of the same lightness and hue at `atChroma`.
+         */
+        constexpr BasicOklab<Scalar> at(Scalar atChroma) const
+        {
+            return BasicOklab<Scalar>{lightness, cosine * atChroma, sine * atChroma};
+        }
+    };
+
+    using PolarOklab = BasicPolarOklab<double>;
+    using PolarOklabf = BasicPolarOklab<float>;
+
+    namespace formulas
+    {
+        // Within the noise of 8-bit conversions: below it, (a, b) has no meaningful hue
+        constexpr double ACHROMATIC_EPSILON = 0.0002;
+
+        template <typename Scalar>
+        constexpr Scalar abs(Scalar value)
+        {
+            return value < 0 ? -value : value;
+        }
+
+        template <typename Scalar>
+        constexpr bool isNaN(Scalar value)
+        {
+            return value != value;
+        }
+
+        /**
+         * @brief Multiplies a 3x3 matrix by a 3D vector, the coefficients rounded to `Scalar`.
+         */
+        template <typename Scalar>
+        constexpr std::array<Scalar, 3> multiplyMatrix(const double (*matrix)[3], const std::array<Scalar, 3> &vector)
+        {
+            std::array<Scalar, 3> result = {0, 0, 0};
+            for (int i = 0; i < 3; ++i)
+            {
+                for (int j = 0; j < 3; ++j)
+                {
+                    result[i] += static_cast<Scalar>(matrix[i][j]) * vector[j];
+                }
+            }
+            return result;
+        }
+
+        /**
+         * @brief The inverse of the sRGB transfer function, odd around 0.
+         */
+        template <typename Math>
+        constexpr double gammaToLinear(double value)
+        {
+            double absValue = abs(value);
+            if (absValue <= 0.04045)
+            {
+                return value / 12.92;
+            }
+            double linear = Math::pow((absValue + 0.055) / 1.055, 2.4);
+            return value < 0 ? -linear : linear;
+        }
+
+        /**
+         * @brief The sRGB transfer function, odd around 0.
+         */
+        template <typename Math>
+        constexpr double linearToGamma(double value)
+        {
+            double absValue = abs(value);
+            if (absValue <= 0.0031308)
+            {
+                return 12.92 * value;
+            }
+            double gamma = 1.055 * Math::pow(absValue, 1.0 / 2.4) - 0.055;
+            return value < 0 ? -gamma : gamma;
+        }
+
+        template <typename Math, typename Scalar>
+        constexpr BasicOklab<Scalar> lmsToOklab(const BasicLMS<Scalar> &lms)
+        {
+            std::array<Scalar, 3> lmsG = {Math::cbrt(lms[0]), Math::cbrt(lms[1]), Math::cbrt(lms[2])};
+            return BasicOklab<Scalar>(formulas::multiplyMatrix(LMSG_TO_OKLAB, lmsG));
+        }
+
+        template <typename Scalar>
+        constexpr BasicLMS<Scalar> oklabToLms(const BasicOklab<Scalar> &oklab)
+        {
+            std::array<Scalar, 3> lmsG = formulas::multiplyMatrix(OKLAB_TO_LMSG, oklab);
+            return BasicLMS<Scalar>{lmsG[0] * lmsG[0] * lmsG[0], lmsG[1] * lmsG[1] * lmsG[1], lmsG[2] * lmsG[2] * lmsG[2]};
+        }
+
+        template <typename Math, typename Scalar>
+        constexpr Scalar deltaE(const BasicOklab<Scalar> &oklab1, const BasicOklab<Scalar> &oklab2)
+        {
+            Scalar deltaL = oklab1[0] - oklab2[0];
+            // TODO: 2 is debated here: https://github.com/w3c/csswg-drafts/pull/10063
+            // However, reference implementation use 1 so we do too.
+            const Scalar FACTOR = 1;
+            Scalar deltaA = FACTOR * (oklab1[1] - oklab2[1]);
+            Scalar deltaB = FACTOR * (oklab1[2] - oklab2[2]);
+            return Math::sqrt(deltaL * deltaL + deltaA * deltaA + deltaB * deltaB);
+        }
+
+        template <typename Scalar>
+        constexpr bool isAchromatic(const BasicOklab<Scalar> &oklab)
+        {
+            Scalar epsilon = static_cast<Scalar>(ACHROMATIC_EPSILON);
+            return abs(oklab[1]) < epsilon && abs(oklab[2]) < epsilon;
+        }
+
+        // A hue rounded to float may reach 360
+        template <typename Scalar>
+        constexpr Scalar toHue(double hue)
+        {
+            Scalar rounded = static_cast<Scalar>(hue);
+            return rounded < 360 ? rounded : 0;
+        }
+
+        template <typename Math, typename Scalar>
+        constexpr BasicOklab<Scalar> oklchToOklab(const BasicOklch<Scalar> &oklch)
+        {
+            if (isNaN(oklch[2]))
+            {
+                return BasicOklab<Scalar>{oklch[0], 0, 0};
+            }
+
+            double sine = 0;
+            double cosine = 0;
+            Math::sinCosDegrees(static_cast<double>(oklch[2]), sine, cosine);
+            return BasicOklab<Scalar>{
+                oklch[0],
+                static_cast<Scalar>(cosine * oklch[1]),
+                static_cast<Scalar>(sine * oklch[1])};
+        }
+
+        template <typename Math, typename Scalar>
+        constexpr BasicOklch<Scalar> oklabToOklch(const BasicOklab<Scalar> &oklab)
+        {
+            if (isAchromatic(oklab))
+            {
+                return BasicOklch<Scalar>{oklab[0], 0, std::numeric_limits<Scalar>::quiet_NaN()};
+            }
+
+            return BasicOklch<Scalar>{
+                oklab[0],
+                Math::sqrt(oklab[1] * oklab[1] + oklab[2] * oklab[2]),
+                toHue<Scalar>(Math::hueDegrees(static_cast<double>(oklab[1]), static_cast<double>(oklab[2])))};
+        }
+
+        template <typename Math, typename Scalar>
+        constexpr BasicPolarOklab<Scalar> oklabToPolar(const BasicOklab<Scalar> &oklab)
+        {
+            if (isAchromatic(oklab))
+            {
+                return BasicPolarOklab<Scalar>{oklab[0], 0, 0, 0};
+            }
+
+            Scalar chroma = Math::sqrt(oklab[1] * oklab[1] + oklab[2] * oklab[2]);
+            return BasicPolarOklab<Scalar>{oklab[0], chroma, oklab[1] / chroma, oklab[2] / chroma};
+        }
+
+        template <typename Math, typename Scalar>
+        constexpr BasicPolarOklab<Scalar> oklchToPolar(const BasicOklch<Scalar> &oklch)
+        {
+            if (isNaN(oklch[2]))
+            {
+                return BasicPolarOklab<Scalar>{oklch[0], oklch[1], 0, 0};
+            }
+
+            double sine = 0;
+            double cosine = 0;
+            Math::sinCosDegrees(static_cast<double>(oklch[2]), sine, cosine);
+            return BasicPolarOklab<Scalar>{oklch[0], oklch[1], static_cast<Scalar>(cosine), static_cast<Scalar>(sine)};
+        }
+
+        template <typename Math, typename Scalar>
+        constexpr BasicOklch<Scalar> polarToOklch(const BasicPolarOklab<Scalar> &polar)
+        {
+            if (polar.cosine == 0 && polar.sine == 0)
+            {
+                return BasicOklch<Scalar>{polar.lightness, polar.chroma, std::numeric_limits<Scalar>::quiet_NaN()};
+            }
+            return BasicOklch<Scalar>{
+                polar.lightness,
+                polar.chroma,
+                toHue<Scalar>(Math::hueDegrees(static_cast<double>(polar.cosine), static_cast<double>(polar.sine)))};
+        }
+    } // namespace formulas
+} // namespace oklab
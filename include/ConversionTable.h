@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "ColorTypes.h"
+#include "ColorBatchConversions.h"
+
+/**
+ * @file ConversionTable.h
+ * @brief Provides precomputed 8-bit conversion tables, memory-mapped from disk.
+ *
+ * For 8-bit inputs, `p3ToRgb` and `rgbToP3` are pure functions of 2^24 possible colors. A
+ * conversion table stores the result for each of them (3 bytes per entry, about 48 MB), so a
+ * conversion is one indexed load instead of the Oklab round trip and the gamut mapping loop.
+ *
+ * Tables are built once with `ConversionTable::build` (or the `buildTable` command of the
+ * example CLI) and opened read-only with `mmap`: every process opening the same file shares
+ * the same page-cache copy and nothing is recomputed at startup.
+ *
+ * The file header records the library version and the mapping algorithm the table was built
+ * with; `open` rejects tables that do not match the running library.
+ */
+
+namespace oklab
+{
+    /**
+     * @brief Conversion stored in a table file.
+     */
+    enum class ConversionTableDirection : std::uint32_t
+    {
+        P3ToRgb = 1,
+        RgbToP3 = 2,
+    };
+
+    /**
+     * @brief Header at the start of a table file, in host byte order.
+     *
+     * The entries start at `dataOffset` (page aligned): entry `(c0 << 16) | (c1 << 8) | c2` holds
+     * the 3 output channels of input color `{c0, c1, c2}`.
+     */
+    struct ConversionTableHeader
+    {
+        char magic[8];
+        std::uint32_t formatVersion;
+        std::uint32_t direction;
+        char libraryVersion[16];
+        char mappingAlgorithm[16];
+        std::uint64_t entryCount;
+        std::uint64_t dataOffset;
+    };
+
+    /**
+     * @brief Read-only, memory-mapped table of every 8-bit `InputType -> OutputType` conversion.
+     *
+     * Available for `ConversionTable<P3, RGB>` and `ConversionTable<RGB, P3>`. Lookups are
+     * thread-safe; the mapping is released when the table is destroyed.
+     */
+    template <typename InputType, typename OutputType>
+    class ConversionTable
+    {
+    public:
+        static constexpr std::size_t ENTRY_COUNT = std::size_t{1} << 24;
+        static constexpr std::size_t ENTRY_SIZE = 3;
+
+        /**
+         * @brief Computes every conversion and writes the table to `path`.
+         *
+         * The work is split across `threadCount` threads (the hardware concurrency when 0). The
+         * file is written next to `path` and renamed into place, so processes opening `path`
+         * concurrently never see a partial table.
+         * @return false if the file could not be written.
+         */
+        static bool build(const std::string &path, unsigned threadCount = 0);
+
+        /**
+         * @brief Maps the table stored at `path`.
+         * @return nullptr if the file is missing or truncated, or was built for another
+         * direction, library version or mapping algorithm.
+         */
+        static std::unique_ptr<ConversionTable> open(const std::string &path);
+
+        ~ConversionTable();
+
+        ConversionTable(const ConversionTable &) = delete;
+        ConversionTable &operator=(const ConversionTable &) = delete;
+
+        /**
+         * @brief Converts one color; its channels must be in [0, 255].
+         */
+        OutputType convert(const InputType &color) const
+        {
+            assert(color[0] >= 0 && color[0] <= 255 && color[1] >= 0 && color[1] <= 255 && color[2] >= 0 && color[2] <= 255);
+            const unsigned char *entry = entries_ + ENTRY_SIZE * ((static_cast<std::size_t>(color[0]) << 16) |
+                                                                  (static_cast<std::size_t>(color[1]) << 8) |
+                                                                  static_cast<std::size_t>(color[2]));
+            return OutputType{entry[0], entry[1], entry[2]};
+        }
+
+        /**
+         * @brief Converts a buffer of colors.
+         * @throws std::invalid_argument If the spans differ in size.
+         */
+        void convert(Span<const InputType> input, Span<OutputType> output) const
+        {
+            if (input.size() != output.size())
+            {
+                throw std::invalid_argument("input and output sizes differ");
+            }
+            for (std::size_t i = 0; i < input.size(); ++i)
+            {
+                output[i] = convert(input[i]);
+            }
+        }
+
+    private:
+        ConversionTable(void *mapping, std::size_t mappingSize, const unsigned char *entries)
+            : mapping_(mapping), mappingSize_(mappingSize), entries_(entries) {}
+
+        void *mapping_;
+        std::size_t mappingSize_;
+        const unsigned char *entries_;
+    };
+
+    using P3ToRgbTable = ConversionTable<P3, RGB>;
+    using RgbToP3Table = ConversionTable<RGB, P3>;
+} // namespace oklab
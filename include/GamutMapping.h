@@ -0,0 +1,50 @@
+#pragma once
+
+/**
+ * @file GamutMapping.h
+ * @brief Lists the gamut mapping algorithms the conversions into RGB and P3 can apply.
+ *
+ * The conversions without a `GamutMapping` argument apply `defaultGamutMapping()`, chosen when
+ * building the library with the MAPPING_ALGORITHM CMake option. Their overloads taking one
+ * select the algorithm per call, e.g. clamping for previews and CSS4 for final renders in the
+ * same process.
+ */
+
+namespace oklab
+{
+    /**
+     * @brief Algorithm bringing out-of-gamut colors into the target gamut.
+     */
+    enum class GamutMapping
+    {
+        /** CSS Color 4 chroma reduction, stopping when clipping is not noticeable. */
+        Css4,
+        /** Analytic chroma reduction to the gamut boundary (see gamutMapping/Cusp.h). */
+        Cusp,
+        /** Each linear channel clamped to [0, 1]. */
+        Clamp,
+        /** No mapping: out-of-gamut colors encode to codes outside [0, 255]. */
+        None
+    };
+
+    /**
+     * @brief The algorithm applied by the conversions without a `GamutMapping` argument.
+     */
+    GamutMapping defaultGamutMapping();
+
+    /**
+     * @brief Compile-time value of `defaultGamutMapping()`, for the constexpr conversions.
+     *
+     * The MAPPING_* definition is public on the library target, so code linking it sees the
+     * algorithm the library was built with.
+     */
+#ifdef MAPPING_CSS4
+    constexpr GamutMapping DEFAULT_GAMUT_MAPPING = GamutMapping::Css4;
+#elif MAPPING_CUSP
+    constexpr GamutMapping DEFAULT_GAMUT_MAPPING = GamutMapping::Cusp;
+#elif MAPPING_CLAMP
+    constexpr GamutMapping DEFAULT_GAMUT_MAPPING = GamutMapping::Clamp;
+#else
+    constexpr GamutMapping DEFAULT_GAMUT_MAPPING = GamutMapping::None;
+#endif
+} // namespace oklab
@@ -0,0 +1,396 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+
+#include "ColorTypes.h"
+#include "ColorMatrices.h"
+#include "ConversionFormulas.h"
+
+/**
+ * @file GamutMappingFormulas.h
+ * @brief Contains the gamut mapping algorithms shared by the runtime and constexpr conversions.
+ *
+ * Each algorithm is a constexpr template over a `Space` policy, a type describing the target
+ * color space with:
+ * - `Color`, `LinearColor` and `Scalar`, the types of the result, of its linear color and of
+ *   the computations;
+ * - `toLinear(oklab)`, `toOklab(linearColor)` and `toPolar(oklab)`, the conversions;
+ * - `isInGamut(linearColor)`, `clip(linearColor)` and `encode(linearColor)`, the last one
+ *   returning a `Color`;
+ * - `deltaE(oklab1, oklab2)`, `sqrt(x)` and `cbrt(x)`.
+ *
+ * The library binds them to its conversion functions (gamutMapping/CSS4.h), ConstexprConversions.h
+ * to the formulas of ConversionFormulas.h evaluated by the compiler.
+ */
+
+namespace oklab
+{
+    namespace formulas
+    {
+        namespace css4
+        {
+            constexpr double JUST_NON_DISCERNIBLE = 0.02;
+            constexpr double EPSILON = 0.0001;
+
+            /**
+             * @brief How the CSS4 gamut mapping of a color ends.
+             */
+            enum class Exit
+            {
+                White,
+                Black,
+                InGamut,
+                // Clipping is not noticeable
+                Clip,
+                // A chroma search is needed
+                Search,
+                // The search narrowed the chroma down to EPSILON
+                Converged,
+                // The search met a candidate just below the noticeable difference
+                Threshold
+            };
+
+            /**
+             * @brief The exits of the CSS4 gamut mapping before its chroma search.
+             *
+             * Returns the exit with the mapped `color` for white, black, colors in gamut and colors
+             * whose clipping is not noticeable. Otherwise returns `Exit::Search` with the `polar` form
+             * of the color, whose chroma line the search follows, and its clipped linear color, the
+             * result of a search deciding no candidate.
+             */
+            template <typename Space>
+            constexpr Exit mapWithoutSearch(const BasicOklab<typename Space::Scalar> &oklab, typename Space::Color &color,
+                                            BasicPolarOklab<typename Space::Scalar> &polar, typename Space::LinearColor &clippedLinearColor)
+            {
+                using Scalar = typename Space::Scalar;
+                using LinearColor = typename Space::LinearColor;
+
+                polar = Space::toPolar(oklab);
+
+                // White and black, encoded by the target color type (8-bit or not)
+                if (polar.lightness >= 1)
+                {
+                    color = Space::encode(LinearColor{1, 1, 1});
+                    return Exit::White;
+                }
+
+                if (polar.lightness <= 0)
+                {
+                    color = Space::encode(LinearColor{0, 0, 0});
+                    return Exit::Black;
+                }
+
+                LinearColor linearColor = Space::toLinear(oklab);
+
+                if (Space::isInGamut(linearColor))
+                {
+                    color = Space::encode(linearColor);
+                    return Exit::InGamut;
+                }
+
+                clippedLinearColor = Space::clip(linearColor);
+
+                // Measured from the clipped linear color itself, not from its Oklab conversion, as
+                // the reference implementation does
+                Scalar E = Space::deltaE(BasicOklab<Scalar>(clippedLinearColor), oklab);
+
+                if (E < static_cast<Scalar>(JUST_NON_DISCERNIBLE))
+                {
+                    color = Space::encode(clippedLinearColor);
+                    return Exit::Clip;
+                }
+
+                return Exit::Search;
+            }
+
+            /**
+             * @brief The chroma bisection of CSS Color 4 on the chroma line of `polar`, from 0 to its chroma.
+             *
+             * `clippedLinearColor` holds the clipped linear color of the whole color on input, of the
+             * last clipped candidate on output; the mapped color is its clipping. Adds the number of
+             * candidates to `iterations` and returns `Exit::Converged` or `Exit::Threshold`.
+             */
+            template <typename Space>
+            constexpr Exit bisect(const BasicPolarOklab<typename Space::Scalar> &polar, typename Space::LinearColor &clippedLinearColor,
+                                  int &iterations)
+            {
+                using Scalar = typename Space::Scalar;
+                using OklabType = BasicOklab<Scalar>;
+                using LinearColor = typename Space::LinearColor;
+
+                const Scalar JND = static_cast<Scalar>(JUST_NON_DISCERNIBLE);
+                const Scalar EPS = static_cast<Scalar>(EPSILON);
+
+                Scalar minChroma = 0;
+                Scalar maxChroma = polar.chroma;
+
+                bool isMinChromaInGamut = true;
+
+                while (maxChroma - minChroma > EPS)
+                {
+                    ++iterations;
+                    Scalar optimisedChroma = (minChroma + maxChroma) / 2;
+
+                    OklabType optimisedOklab = polar.at(optimisedChroma);
+                    LinearColor optimisedLinearColor = Space::toLinear(optimisedOklab);
+
+                    if (isMinChromaInGamut && Space::isInGamut(optimisedLinearColor))
+                    {
+                        minChroma = optimisedChroma;
+                        continue;
+                    }
+
+                    clippedLinearColor = Space::clip(optimisedLinearColor);
+                    OklabType clippedOklab = Space::toOklab(clippedLinearColor);
+
+                    Scalar E = Space::deltaE(clippedOklab, optimisedOklab);
+
+                    if (E < JND)
+                    {
+                        if (JND - E < EPS)
+                        {
+                            return Exit::Threshold;
+                        }
+                        isMinChromaInGamut = false;
+                        minChroma = optimisedChroma;
+                    }
+                    else
+                    {
+                        maxChroma = optimisedChroma;
+                    }
+                }
+
+                return Exit::Converged;
+            }
+
+            /**
+             * @brief The CSS Color 4 gamut mapping: the largest chroma, at the same lightness and hue,
+             * whose clipping is not noticeable.
+             */
+            template <typename Space>
+            constexpr typename Space::Color map(const BasicOklab<typename Space::Scalar> &oklab)
+            {
+                typename Space::Color color{};
+                BasicPolarOklab<typename Space::Scalar> polar{};
+                typename Space::LinearColor clippedLinearColor{};
+                if (mapWithoutSearch<Space>(oklab, color, polar, clippedLinearColor) != Exit::Search)
+                {
+                    return color;
+                }
+
+                int iterations = 0;
+                bisect<Space>(polar, clippedLinearColor, iterations);
+                return Space::encode(Space::clip(clippedLinearColor));
+            }
+        } // namespace css4
+
+        namespace cusp
+        {
+            /**
+             * @brief Gamut boundary description of a linear color space, for the cusp mapping.
+             *
+             * For hue direction `(a, b)`, the channel reaching 0 first is `0` if
+             * `CHANNEL_LINES[0] . (a, b) > 1`, else `1` if `CHANNEL_LINES[1] . (a, b) > 1`, else `2`.
+             * Its maximum saturation `C / L` is approximated by `k0 + k1 a + k2 b + k3 a^2 + k4 a b`.
+             * The coefficients follow the form of Ottosson's published ones, fitted by least squares
+             * against the matrices of ColorMatrices.h.
+             */
+            template <typename LinearColorType>
+            struct GamutBoundary;
+
+            template <typename Scalar>
+            struct GamutBoundary<BasicLinearSRGB<Scalar>>
+            {
+                static constexpr const double (*LMS_TO_LINEAR)[3] = LMS_TO_RGB;
+                static constexpr double CHANNEL_LINES[2][2] = {
+                    {-1.88483921, -0.81369065},
+                    {1.81212947, -1.18921503}};
+                static constexpr double MAX_SATURATION[3][5] = {
+                    {1.14080389, 1.68973322, 0.55024241, 0.73122529, 0.51613403},
+                    {0.73191438, -0.43905148, 0.07672174, 0.11218462, -0.13604559},
+                    {1.28299346, -0.00394103, -1.07732370, -0.46176451, 0.00047009}};
+            };
+
+            template <typename Scalar>
+            struct GamutBoundary<BasicLinearP3<Scalar>>
+            {
+                static constexpr const double (*LMS_TO_LINEAR)[3] = LMS_TO_P3;
+                static constexpr double CHANNEL_LINES[2][2] = {
+                    {-1.77213892, -0.82072056},
+                    {1.80290866, -1.19331921}};
+                static constexpr double MAX_SATURATION[3][5] = {
+                    {1.46162704, 2.05688238, 0.73689505, 0.84067713, 0.67053665},
+                    {0.77611578, -0.45674873, 0.11780841, 0.13693035, -0.17368687},
+                    {1.47789607, -0.03110101, -1.24045419, -0.53148295, 0.02536473}};
+            };
+
+            constexpr int HALLEY_STEPS = 2;
+
+            /**
+             * @brief Lightness and chroma of the cusp for hue direction `(a, b)`, `a^2 + b^2 = 1`.
+             */
+            template <typename Space>
+            constexpr void findCusp(typename Space::Scalar a, typename Space::Scalar b,
+                                    typename Space::Scalar &cuspLightness, typename Space::Scalar &cuspChroma)
+            {
+                using Scalar = typename Space::Scalar;
+                using Boundary = GamutBoundary<typename Space::LinearColor>;
+
+                int channel = 2;
+                if (Boundary::CHANNEL_LINES[0][0] * a + Boundary::CHANNEL_LINES[0][1] * b > 1)
+                {
+                    channel = 0;
+                }
+                else if (Boundary::CHANNEL_LINES[1][0] * a + Boundary::CHANNEL_LINES[1][1] * b > 1)
+                {
+                    channel = 1;
+                }
+
+                const double *k = Boundary::MAX_SATURATION[channel];
+                Scalar saturation = static_cast<Scalar>(k[0] + k[1] * a + k[2] * b + k[3] * a * a + k[4] * a * b);
+
+                // Halley steps on f(S) = channel of the linear color of Oklab (1, S a, S b). Next to the
+                // blue primary, one step leaves up to 5% of error; two bring it below 0.5%.
+                Scalar kl = static_cast<Scalar>(OKLAB_TO_LMSG[0][1] * a + OKLAB_TO_LMSG[0][2] * b);
+                Scalar km = static_cast<Scalar>(OKLAB_TO_LMSG[1][1] * a + OKLAB_TO_LMSG[1][2] * b);
+                Scalar ks = static_cast<Scalar>(OKLAB_TO_LMSG[2][1] * a + OKLAB_TO_LMSG[2][2] * b);
+                Scalar wl = static_cast<Scalar>(Boundary::LMS_TO_LINEAR[channel][0]);
+                Scalar wm = static_cast<Scalar>(Boundary::LMS_TO_LINEAR[channel][1]);
+                Scalar ws = static_cast<Scalar>(Boundary::LMS_TO_LINEAR[channel][2]);
+
+                for (int step = 0; step < HALLEY_STEPS; ++step)
+                {
+                    Scalar l_ = 1 + saturation * kl;
+                    Scalar m_ = 1 + saturation * km;
+                    Scalar s_ = 1 + saturation * ks;
+
+                    Scalar f = wl * l_ * l_ * l_ + wm * m_ * m_ * m_ + ws * s_ * s_ * s_;
+                    Scalar f1 = 3 * (wl * kl * l_ * l_ + wm * km * m_ * m_ + ws * ks * s_ * s_);
+                    Scalar f2 = 6 * (wl * kl * kl * l_ + wm * km * km * m_ + ws * ks * ks * s_);
+                    saturation -= f * f1 / (f1 * f1 - Scalar{0.5} * f * f2);
+                }
+
+                // Scale the color of maximum saturation so that its largest channel is 1
+                typename Space::LinearColor linearColor = Space::toLinear(BasicOklab<Scalar>{1, saturation * a, saturation * b});
+                Scalar largest = std::max({linearColor[0], linearColor[1], linearColor[2]});
+                cuspLightness = Space::cbrt(1 / largest);
+                cuspChroma = cuspLightness * saturation;
+            }
+
+            /**
+             * @brief Position `t` of the gamut boundary on the segment from `(lightness0, 0)` to
+             * `(lightness, chroma)` in the plane of hue direction `(a, b)`.
+             */
+            template <typename Space>
+            constexpr typename Space::Scalar findGamutIntersection(typename Space::Scalar a, typename Space::Scalar b,
+                                                                   typename Space::Scalar lightness, typename Space::Scalar chroma,
+                                                                   typename Space::Scalar lightness0)
+            {
+                using Scalar = typename Space::Scalar;
+                using Boundary = GamutBoundary<typename Space::LinearColor>;
+
+                Scalar cuspLightness = 0;
+                Scalar cuspChroma = 0;
+                findCusp<Space>(a, b, cuspLightness, cuspChroma);
+
+                if ((lightness - lightness0) * cuspChroma - (cuspLightness - lightness0) * chroma <= 0)
+                {
+                    // Lower half: the boundary is the line from black to the cusp
+                    return cuspChroma * lightness0 / (chroma * cuspLightness + cuspChroma * (lightness0 - lightness));
+                }
+
+                // Upper half: intersect the line from the cusp to white, then one Halley step per channel
+                Scalar t = cuspChroma * (lightness0 - 1) / (chroma * (cuspLightness - 1) + cuspChroma * (lightness0 - lightness));
+
+                Scalar kl = static_cast<Scalar>(OKLAB_TO_LMSG[0][1] * a + OKLAB_TO_LMSG[0][2] * b);
+                Scalar km = static_cast<Scalar>(OKLAB_TO_LMSG[1][1] * a + OKLAB_TO_LMSG[1][2] * b);
+                Scalar ks = static_cast<Scalar>(OKLAB_TO_LMSG[2][1] * a + OKLAB_TO_LMSG[2][2] * b);
+
+                Scalar ldt = (lightness - lightness0) + chroma * kl;
+                Scalar mdt = (lightness - lightness0) + chroma * km;
+                Scalar sdt = (lightness - lightness0) + chroma * ks;
+
+                Scalar currentLightness = lightness0 * (1 - t) + t * lightness;
+                Scalar currentChroma = t * chroma;
+
+                Scalar l_ = currentLightness + currentChroma * kl;
+                Scalar m_ = currentLightness + currentChroma * km;
+                Scalar s_ = currentLightness + currentChroma * ks;
+
+                Scalar lms[3] = {l_ * l_ * l_, m_ * m_ * m_, s_ * s_ * s_};
+                Scalar lms1[3] = {3 * ldt * l_ * l_, 3 * mdt * m_ * m_, 3 * sdt * s_ * s_};
+                Scalar lms2[3] = {6 * ldt * ldt * l_, 6 * mdt * mdt * m_, 6 * sdt * sdt * s_};
+
+                Scalar step = std::numeric_limits<Scalar>::max();
+                for (int channel = 0; channel < 3; ++channel)
+                {
+                    const double *w = Boundary::LMS_TO_LINEAR[channel];
+                    Scalar f = static_cast<Scalar>(w[0]) * lms[0] + static_cast<Scalar>(w[1]) * lms[1] + static_cast<Scalar>(w[2]) * lms[2] - 1;
+                    Scalar f1 = static_cast<Scalar>(w[0]) * lms1[0] + static_cast<Scalar>(w[1]) * lms1[1] + static_cast<Scalar>(w[2]) * lms1[2];
+                    Scalar f2 = static_cast<Scalar>(w[0]) * lms2[0] + static_cast<Scalar>(w[1]) * lms2[1] + static_cast<Scalar>(w[2]) * lms2[2];
+
+                    // Only channels increasing along the segment can reach 1
+                    Scalar u = f1 / (f1 * f1 - Scalar{0.5} * f * f2);
+                    if (u >= 0)
+                    {
+                        step = std::min(step, -f * u);
+                    }
+                }
+
+                return t + step;
+            }
+
+            /**
+             * @brief The analytic cusp-based gamut mapping (see gamutMapping/Cusp.h).
+             */
+            template <typename Space>
+            constexpr typename Space::Color map(const BasicOklab<typename Space::Scalar> &oklab)
+            {
+                using Scalar = typename Space::Scalar;
+                using LinearColor = typename Space::LinearColor;
+
+                Scalar lightness = oklab[0];
+
+                if (lightness >= 1)
+                {
+                    return Space::encode(LinearColor{1, 1, 1});
+                }
+
+                if (lightness <= 0)
+                {
+                    return Space::encode(LinearColor{0, 0, 0});
+                }
+
+                LinearColor linearColor = Space::toLinear(oklab);
+
+                if (Space::isInGamut(linearColor))
+                {
+                    return Space::encode(linearColor);
+                }
+
+                // Colors out of gamut by rounding only are clipped: next to the blue primary, the boundary
+                // of a constant hue plane folds and the cusp of a nearby hue can be far from the color.
+                const Scalar NEAR_GAMUT = static_cast<Scalar>(0.0001);
+                if (std::min({linearColor[0], linearColor[1], linearColor[2]}) > -NEAR_GAMUT &&
+                    std::max({linearColor[0], linearColor[1], linearColor[2]}) < 1 + NEAR_GAMUT)
+                {
+                    return Space::encode(Space::clip(linearColor));
+                }
+
+                // Reduce chroma at constant lightness and hue, down to the gamut boundary
+                const Scalar EPSILON = static_cast<Scalar>(0.00001);
+                Scalar chroma = std::max(EPSILON, Space::sqrt(oklab[1] * oklab[1] + oklab[2] * oklab[2]));
+                Scalar a = oklab[1] / chroma;
+                Scalar b = oklab[2] / chroma;
+
+                // Never increase chroma: colors just out of gamut may land beyond an approximated boundary
+                Scalar t = std::min(Scalar{1}, findGamutIntersection<Space>(a, b, lightness, chroma, lightness));
+                Scalar mappedChroma = t * chroma;
+
+                LinearColor mappedLinearColor = Space::toLinear(BasicOklab<Scalar>{lightness, mappedChroma * a, mappedChroma * b});
+                return Space::encode(Space::clip(mappedLinearColor));
+            }
+        } // namespace cusp
+    } // namespace formulas
+} // namespace oklab
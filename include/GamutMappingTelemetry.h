@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @file GamutMappingTelemetry.h
+ * @brief Provides counters of the CSS4 gamut mapping, to see where conversion time goes.
+ *
+ * Every color mapped with `GamutMapping::Css4` ends in exactly one of the exits below. In-gamut
+ * colors skipped by the fast paths of the batch conversions and of `p3ToRgb` / `rgbToP3` are
+ * counted as in-gamut exits too, so `calls` covers every converted color.
+ *
+ * Each thread increments its own counters without atomic read-modify-write; snapshots sum them
+ * without locking. The counters are compiled in with the OKLAB_TELEMETRY CMake option (on by
+ * default); without it, snapshots are all zeros and the mapping has no counting code at all.
+ */
+
+namespace oklab
+{
+    /**
+     * @brief Counts of the CSS4 gamut mapping since the start of the process or the last reset.
+     */
+    struct GamutMappingTelemetry
+    {
+        /** Buckets of the iteration histogram; the last one counts longer searches too. */
+        static constexpr std::size_t ITERATION_BUCKETS = 24;
+
+        /** Colors mapped, the sum of the exits below. */
+        std::uint64_t calls;
+
+        /** Lightness at least 1: white. */
+        std::uint64_t whiteExits;
+        /** Lightness at most 0: black. */
+        std::uint64_t blackExits;
+        /** Already in gamut. */
+        std::uint64_t inGamutExits;
+        /** Out of gamut, but clipping it is not noticeable (deltaE below 0.02). */
+        std::uint64_t clipExits;
+
+        /** Colors going through the chroma search, the sum of the two search exits. */
+        std::uint64_t searches;
+        /** Searches ended by the chroma interval becoming smaller than its tolerance. */
+        std::uint64_t convergedExits;
+        /** Searches ended by a clipped candidate at the noticeable difference, within tolerance. */
+        std::uint64_t thresholdExits;
+
+        /**
+         * Searches by number of iterations, counted as clipped deltaE evaluations. The batch
+         * conversions run the searches in SIMD lanes, evaluating every step of the bisection.
+         */
+        std::uint64_t iterations[ITERATION_BUCKETS];
+        /** Iterations of all searches. */
+        std::uint64_t totalIterations;
+    };
+
+    /**
+     * @brief Whether the library was built with the counters.
+     */
+    bool gamutMappingTelemetryEnabled();
+
+    /**
+     * @brief Sums the counters of all threads.
+     *
+     * Counts updated while the snapshot is taken may or may not be included.
+     */
+    GamutMappingTelemetry gamutMappingTelemetry();
+
+    /**
+     * @brief Restarts the counts from zero for the following snapshots.
+     */
+    void resetGamutMappingTelemetry();
+} // namespace oklab
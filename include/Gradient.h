@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "ColorBatchConversions.h"
+#include "ColorTypes.h"
+#include "GamutMapping.h"
+#include "ImageConversion.h"
+
+/**
+ * @file Gradient.h
+ * @brief Provides multi-stop gradients interpolated in Oklab or Oklch, rendered in batch.
+ *
+ * A `Gradient` converts its stops once, when it is built, into the interpolation space; each
+ * sample then costs a segment lookup and a linear interpolation. Ramps, per-pixel positions and
+ * linear gradient images are interpolated block by block into Oklab, and converted to their
+ * output type with the batch conversions, gamut mapping included.
+ *
+ * Stops follow CSS Color 4 / CSS Images 3: a stop positioned before a previous one is moved to
+ * the previous position; before the first stop and after the last, samples take the color of the
+ * nearest stop; at a position shared by two stops (a hard stop), samples take the later color.
+ * In Oklch, the hue of an achromatic stop is powerless and takes the hue of the other end of
+ * the segment.
+ */
+
+namespace oklab
+{
+    /**
+     * @brief Color space of the interpolation.
+     */
+    enum class GradientSpace
+    {
+        /** Rectangular: L, a and b interpolated linearly. */
+        Oklab,
+        /** Polar: L, C and h interpolated linearly, the hue according to a `HueInterpolation`. */
+        Oklch
+    };
+
+    /**
+     * @brief Path of the hue between two Oklch stops, as the CSS Color 4 hue interpolation methods.
+     */
+    enum class HueInterpolation
+    {
+        /** The arc of at most 180 degrees. */
+        Shorter,
+        /** The arc of at least 180 degrees. */
+        Longer,
+        /** The arc of increasing hue. */
+        Increasing,
+        /** The arc of decreasing hue. */
+        Decreasing
+    };
+
+    /**
+     * @brief A color of a gradient, at a position of its line (usually in [0, 1]).
+     */
+    struct GradientStop
+    {
+        Oklab color;
+        double position;
+    };
+
+    /**
+     * @brief Line of a linear gradient image, in pixels: position 0 at `start`, 1 at `end`.
+     *
+     * Pixels take the position of their center projected on the line.
+     */
+    struct GradientLine
+    {
+        double startX;
+        double startY;
+        double endX;
+        double endY;
+    };
+
+    /**
+     * @brief Multi-stop gradient, immutable once built; sampling is thread-safe.
+     *
+     * The batch functions are available for `Oklab` (no mapping), `RGB`, `P3`, `GammaSRGB` and
+     * `GammaP3` outputs, e.g. `gradient.fillRamp<RGB>(ramp)`.
+     */
+    class Gradient
+    {
+    public:
+        /**
+         * @brief Builds a gradient from at least one stop.
+         * @param stops Colors and positions, in order along the line.
+         * @throws std::invalid_argument If `stops` is empty.
+         */
+        explicit Gradient(Span<const GradientStop> stops, GradientSpace space = GradientSpace::Oklab,
+                          HueInterpolation hueInterpolation = HueInterpolation::Shorter);
+
+        /**
+         * @brief Returns the color of the gradient at a position.
+         */
+        Oklab sample(double position) const;
+
+        /**
+         * @brief Samples the gradient at a position per output color.
+         * @param positions Positions along the line; NaN samples the first stop.
+         * @param output Receives the colors; must have the same size as the positions.
+         * @param mapping Gamut mapping of `RGB`, `P3`, `GammaSRGB` and `GammaP3` outputs.
+         * @throws std::invalid_argument If the spans differ in size.
+         */
+        template <typename ColorType>
+        void sample(Span<const double> positions, Span<ColorType> output, GamutMapping mapping = defaultGamutMapping()) const;
+
+        /**
+         * @brief Fills a ramp: `output[i]` takes the color at position `i / (output.size() - 1)`.
+         */
+        template <typename ColorType>
+        void fillRamp(Span<ColorType> output, GamutMapping mapping = defaultGamutMapping()) const;
+
+        /**
+         * @brief Fills an image with the linear gradient along `line`.
+         */
+        template <typename ColorType>
+        void fillLinear(ImageView<ColorType> image, const GradientLine &line, GamutMapping mapping = defaultGamutMapping()) const;
+
+        GradientSpace space() const { return space_; }
+
+    private:
+        // Stops of a segment in the interpolation space, hues already set on their arc
+        struct Segment
+        {
+            double start;
+            double end;
+            double from[3];
+            double to[3];
+        };
+
+        void interpolate(const double *positions, std::size_t count, Oklab *output) const;
+
+        template <typename ColorType, typename PositionAt>
+        void render(Span<ColorType> output, GamutMapping mapping, PositionAt positionAt) const;
+
+        GradientSpace space_;
+        std::vector<Segment> segments_;
+        Oklab first_;
+        Oklab last_;
+        double firstPosition_;
+        double lastPosition_;
+    };
+} // namespace oklab
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+#include "ColorTypes.h"
+#include "GamutMapping.h"
+#include "ThreadPool.h"
+
+/**
+ * @file ImageConversion.h
+ * @brief Provides conversions of whole images between P3 and sRGB, in parallel.
+ *
+ * An image is split into tiles of `IMAGE_TILE_WIDTH x IMAGE_TILE_HEIGHT` pixels, small enough
+ * for their input and output to stay in the L2 cache. The tiles are converted with the batch
+ * conversions on a `ThreadPool`, whose work stealing balances the tiles of out-of-gamut colors,
+ * much slower to map. Results are identical to `p3ToRgb` / `rgbToP3` on each pixel.
+ */
+
+namespace oklab
+{
+    constexpr std::size_t IMAGE_TILE_WIDTH = 256;
+    constexpr std::size_t IMAGE_TILE_HEIGHT = 16;
+
+    /**
+     * @brief Non-owning view over the pixels of an image, row after row.
+     *
+     * Rows start `stride` pixels apart (at least `width`), so that views can cover padded rows
+     * or a region of a larger image.
+     */
+    template <typename T>
+    struct ImageView
+    {
+        T *pixels;
+        std::size_t width;
+        std::size_t height;
+        std::size_t stride;
+
+        ImageView(T *pixels, std::size_t width, std::size_t height) : pixels(pixels), width(width), height(height), stride(width) {}
+
+        ImageView(T *pixels, std::size_t width, std::size_t height, std::size_t stride)
+            : pixels(pixels), width(width), height(height), stride(stride) {}
+
+        // Allow ImageView<T> -> ImageView<const T>
+        template <typename U>
+        ImageView(const ImageView<U> &other) : pixels(other.pixels), width(other.width), height(other.height), stride(other.stride) {}
+
+        T *row(std::size_t y) const { return pixels + y * stride; }
+    };
+
+    /**
+     * @brief Flag stopping image conversions in progress, settable from any thread.
+     */
+    class CancellationToken
+    {
+    public:
+        void cancel() { isCancelled_.store(true, std::memory_order_relaxed); }
+
+        bool isCancelled() const { return isCancelled_.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<bool> isCancelled_{false};
+    };
+
+    struct ImageConversionOptions
+    {
+        GamutMapping mapping = defaultGamutMapping();
+        /** Pool converting the tiles; `ThreadPool::shared()` when null. */
+        ThreadPool *pool = nullptr;
+        /** Checked before each tile; once cancelled, the tiles not started are left unconverted. */
+        const CancellationToken *cancellation = nullptr;
+    };
+
+    /**
+     * @brief Converts an image of P3 colors to RGB.
+     * @param output Receives the RGB colors; must have the same width and height as the input.
+     * @return false if the conversion was cancelled, leaving part of the output unconverted.
+     * @throws std::invalid_argument If the sizes differ, or a stride is below its image width.
+     */
+    bool p3ToRgb(ImageView<const P3> input, ImageView<RGB> output, const ImageConversionOptions &options = {});
+
+    /**
+     * @brief Converts an image of RGB colors to P3.
+     * @param output Receives the P3 colors; must have the same width and height as the input.
+     * @return false if the conversion was cancelled, leaving part of the output unconverted.
+     * @throws std::invalid_argument If the sizes differ, or a stride is below its image width.
+     */
+    bool rgbToP3(ImageView<const RGB> input, ImageView<P3> output, const ImageConversionOptions &options = {});
+} // namespace oklab
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+#include "ColorBatchConversions.h"
+#include "GamutMapping.h"
+
+/**
+ * @file PixelFormats.h
+ * @brief Provides conversions between P3 and sRGB over packed framebuffer pixel formats.
+ *
+ * The conversions read and write the packed pixels directly: unpacking, channel shuffles and
+ * alpha handling run in the same block loops as the transfer functions, on the way into and out
+ * of the Oklab conversion, without intermediate `RGB` / `P3` buffers.
+ *
+ * Integer formats decode and encode through the transfer tables of their depth, so their colors
+ * are identical to the conversions of `RGB` / `P3` codes of that depth (`BitDepth`) on each
+ * pixel; 8-bit formats to `rgbToP3` / `p3ToRgb`. Half floats, and premultiplied colors, whose
+ * unpremultiplied values fall between codes, run the `TransferAccuracy::Precise` transfer
+ * functions instead.
+ */
+
+namespace oklab
+{
+    /**
+     * @brief Packed pixel layouts.
+     */
+    enum class PixelFormat
+    {
+        /** 4 bytes: R, G, B, A. */
+        RGBA8,
+        /** 4 bytes: B, G, R, A. */
+        BGRA8,
+        /** 32-bit word: R in bits 0-9, G in bits 10-19, B in bits 20-29, A in bits 30-31. */
+        RGB10A2,
+        /** 4 16-bit words: R, G, B, A. */
+        RGBA16,
+        /** 4 IEEE 754 half-precision values: R, G, B, A, gamma-encoded, 1.0 being full scale. */
+        RGBAHalf
+    };
+
+    struct RGBA8
+    {
+        static constexpr PixelFormat FORMAT = PixelFormat::RGBA8;
+        std::uint8_t r, g, b, a;
+    };
+
+    struct BGRA8
+    {
+        static constexpr PixelFormat FORMAT = PixelFormat::BGRA8;
+        std::uint8_t b, g, r, a;
+    };
+
+    struct RGB10A2
+    {
+        static constexpr PixelFormat FORMAT = PixelFormat::RGB10A2;
+        std::uint32_t bits;
+    };
+
+    struct RGBA16
+    {
+        static constexpr PixelFormat FORMAT = PixelFormat::RGBA16;
+        std::uint16_t r, g, b, a;
+    };
+
+    struct RGBAHalf
+    {
+        static constexpr PixelFormat FORMAT = PixelFormat::RGBAHalf;
+        std::uint16_t r, g, b, a;
+    };
+
+    /**
+     * @brief How the color channels of pixels relate to their alpha.
+     */
+    enum class AlphaMode
+    {
+        /** Colors independent of alpha. */
+        Straight,
+        /**
+         * Gamma-encoded colors multiplied by alpha. Colors are divided by alpha before the
+         * conversion and multiplied by it after; pixels of zero alpha come out black.
+         */
+        Premultiplied
+    };
+
+    /**
+     * @brief Conversion run by `convertPixels`.
+     */
+    enum class PixelConversion
+    {
+        P3ToRgb,
+        RgbToP3
+    };
+
+    /**
+     * @brief Converts `size` packed pixels, with the formats given at run time.
+     *
+     * Alpha passes through, rescaled to the output format. Input and output may not overlap.
+     */
+    void convertPixels(PixelConversion conversion, PixelFormat inputFormat, const void *input, PixelFormat outputFormat,
+                       void *output, std::size_t size, GamutMapping mapping = defaultGamutMapping(),
+                       AlphaMode alphaMode = AlphaMode::Straight);
+
+    /**
+     * @brief Converts P3 pixels to sRGB pixels, in any pair of packed formats.
+     * @param output Receives the converted pixels; must have the same size as the input.
+     * @throws std::invalid_argument If the spans differ in size.
+     */
+    template <typename InputPixel, typename OutputPixel>
+    void p3ToRgb(Span<const InputPixel> input, Span<OutputPixel> output, GamutMapping mapping = defaultGamutMapping(),
+                 AlphaMode alphaMode = AlphaMode::Straight)
+    {
+        if (input.size() != output.size())
+        {
+            throw std::invalid_argument("input and output sizes differ");
+        }
+        convertPixels(PixelConversion::P3ToRgb, InputPixel::FORMAT, input.data(), OutputPixel::FORMAT, output.data(), input.size(),
+                      mapping, alphaMode);
+    }
+
+    /**
+     * @brief Converts sRGB pixels to P3 pixels, in any pair of packed formats.
+     * @param output Receives the converted pixels; must have the same size as the input.
+     * @throws std::invalid_argument If the spans differ in size.
+     */
+    template <typename InputPixel, typename OutputPixel>
+    void rgbToP3(Span<const InputPixel> input, Span<OutputPixel> output, GamutMapping mapping = defaultGamutMapping(),
+                 AlphaMode alphaMode = AlphaMode::Straight)
+    {
+        if (input.size() != output.size())
+        {
+            throw std::invalid_argument("input and output sizes differ");
+        }
+        convertPixels(PixelConversion::RgbToP3, InputPixel::FORMAT, input.data(), OutputPixel::FORMAT, output.data(), input.size(),
+                      mapping, alphaMode);
+    }
+} // namespace oklab
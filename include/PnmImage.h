@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "ImageConversion.h"
+
+/**
+ * @file PnmImage.h
+ * @brief Provides memory-mapped binary PPM and PAM images, and their conversions.
+ *
+ * Supports binary PPM (`P6`, RGB) and PAM (`P7`, tuple types `RGB` and `RGB_ALPHA`) images with
+ * 8-bit samples (maximum value up to 255) or 16-bit big-endian samples (up to 65535).
+ *
+ * Images are mapped with `mmap` rather than read: `open` parses the header and serves the samples
+ * from the page cache, and `create` maps the output file, so that conversions read the input
+ * mapping and write straight into the output mapping, without intermediate copies.
+ */
+
+namespace oklab
+{
+    enum class PnmFormat
+    {
+        /** Binary PPM, `P6`: RGB without alpha. */
+        Ppm,
+        /** PAM, `P7`: RGB with or without alpha. */
+        Pam
+    };
+
+    /**
+     * @brief PPM or PAM image mapped from a file, read-only when opened and writable when created.
+     *
+     * Rows of samples are interleaved (R, G, B and alpha if any), 1 byte per sample when the
+     * maximum value is at most 255 and 2 big-endian bytes otherwise. The mapping is released when
+     * the image is destroyed.
+     */
+    class PnmImage
+    {
+    public:
+        /**
+         * @brief Maps the image stored at `path`.
+         * @return nullptr if the file is missing, truncated, or not a binary PPM or an RGB PAM.
+         */
+        static std::unique_ptr<PnmImage> open(const std::string &path);
+
+        /**
+         * @brief Creates the file `path` for an image of the given size, with unset samples.
+         * @return nullptr if the file could not be written, or for a PPM with alpha.
+         */
+        static std::unique_ptr<PnmImage> create(const std::string &path, PnmFormat format, std::size_t width, std::size_t height,
+                                                unsigned maxValue = 255, bool hasAlpha = false);
+
+        ~PnmImage();
+
+        PnmImage(const PnmImage &) = delete;
+        PnmImage &operator=(const PnmImage &) = delete;
+
+        PnmFormat format() const { return format_; }
+        std::size_t width() const { return width_; }
+        std::size_t height() const { return height_; }
+        unsigned maxValue() const { return maxValue_; }
+        bool hasAlpha() const { return hasAlpha_; }
+        bool isWritable() const { return isWritable_; }
+
+        std::size_t channelCount() const { return hasAlpha_ ? 4 : 3; }
+        std::size_t sampleSize() const { return maxValue_ > 255 ? 2 : 1; }
+        std::size_t rowSize() const { return width_ * channelCount() * sampleSize(); }
+
+        const unsigned char *row(std::size_t y) const { return samples_ + y * rowSize(); }
+
+        /**
+         * @brief Samples of row `y`, to be written only in created images.
+         */
+        unsigned char *row(std::size_t y) { return samples_ + y * rowSize(); }
+
+        /**
+         * @brief Writes the samples of a created image back to its file.
+         * @return false if the file could not be written.
+         */
+        bool flush();
+
+    private:
+        PnmImage(void *mapping, std::size_t mappingSize, std::size_t headerSize, PnmFormat format, std::size_t width,
+                 std::size_t height, unsigned maxValue, bool hasAlpha, bool isWritable);
+
+        void *mapping_;
+        std::size_t mappingSize_;
+        unsigned char *samples_;
+        PnmFormat format_;
+        std::size_t width_;
+        std::size_t height_;
+        unsigned maxValue_;
+        bool hasAlpha_;
+        bool isWritable_;
+    };
+
+    /**
+     * @brief Converts a P3 image to RGB, from the input mapping into the output mapping.
+     *
+     * The images must have the same width and height. Samples are rescaled from the input maximum
+     * value to the working depth, converted as by `p3ToRgb` at that depth, and rescaled to the
+     * output maximum value. The working depth is 16 bits when either image has 16-bit samples,
+     * 8 bits otherwise. Alpha is copied (rescaled) when both images have it, and opaque when only
+     * the output has it.
+     * @return false if the conversion was cancelled, leaving part of the output unconverted.
+     * @throws std::invalid_argument If the sizes differ or the output was opened read-only.
+     */
+    bool p3ToRgb(const PnmImage &input, PnmImage &output, const ImageConversionOptions &options = {});
+
+    /**
+     * @brief Converts an RGB image to P3, as `p3ToRgb` does for P3 images.
+     */
+    bool rgbToP3(const PnmImage &input, PnmImage &output, const ImageConversionOptions &options = {});
+} // namespace oklab
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "ColorTypes.h"
+#include "ColorBatchConversions.h"
+#include "GamutMapping.h"
+#include "ThreadPool.h"
+
+/**
+ * @file ScanlineStream.h
+ * @brief Provides streaming conversions of images too large to be held in memory.
+ *
+ * The caller pushes the rows of an image, one or several at a time, and receives the converted
+ * rows in order, either by pulling them or through a sink. The rows go through a ring of strips
+ * of `stripHeight()` rows: while a strip is filled by the caller (decoding), the previous one is
+ * converted on a background thread, and the one before is drained (encoding). Pushing blocks
+ * once every strip is in use, so the working memory stays within
+ * `ScanlineStreamOptions::maxWorkingMemory` whatever the size of the image.
+ *
+ * Strips are converted with the batch conversions, so results are identical to `p3ToRgb`,
+ * `rgbToP3`, `oklabToRgb` and `oklabToP3` on each pixel.
+ */
+
+namespace oklab
+{
+    struct ScanlineStreamOptions
+    {
+        GamutMapping mapping = defaultGamutMapping();
+        /** Bound on the memory of the strips, in bytes; two strips of one row at least. */
+        std::size_t maxWorkingMemory = std::size_t{16} << 20;
+        /** Preferred rows per strip, lowered when two strips would not fit in the memory bound. */
+        std::size_t stripHeight = 16;
+        /** Pool converting each strip; `ThreadPool::shared()` when null. */
+        ThreadPool *pool = nullptr;
+    };
+
+    /**
+     * @brief Streaming conversion of the rows of an image of `width` pixels.
+     *
+     * Available for `ScanlineStream<P3, RGB>`, `<RGB, P3>`, `<Oklab, RGB>` and `<Oklab, P3>`.
+     * Rows are pushed and pulled interleaved or planar, independently of each other.
+     *
+     * Without a sink, the caller pulls the converted rows. Since pushing blocks while the strips
+     * are full and pulling blocks until rows are converted, pushing and pulling must happen on
+     * different threads, typically a decoder and an encoder. With a sink, a background thread
+     * passes the converted rows to the sink and a single thread can push everything.
+     */
+    template <typename InputType, typename OutputType>
+    class ScanlineStream
+    {
+    public:
+        using InputComponent = typename InputType::value_type;
+        using OutputComponent = typename OutputType::value_type;
+
+        /**
+         * @brief Receives converted rows, `rows.size() / width` of them starting at row `firstRow`.
+         * Called in row order on a background thread; the rows are valid until it returns.
+         */
+        using RowSink = std::function<void(std::size_t firstRow, Span<const OutputType> rows)>;
+
+        /**
+         * @brief Starts a stream whose converted rows are pulled with `pull`.
+         * @throws std::invalid_argument If `width` or `options.stripHeight` is 0.
+         */
+        explicit ScanlineStream(std::size_t width, const ScanlineStreamOptions &options = {});
+
+        /**
+         * @brief Starts a stream whose converted rows are passed to `sink`.
+         */
+        ScanlineStream(std::size_t width, RowSink sink, const ScanlineStreamOptions &options = {});
+
+        /**
+         * @brief Stops the background threads; rows not converted or not pulled yet are dropped.
+         */
+        ~ScanlineStream();
+
+        ScanlineStream(const ScanlineStream &) = delete;
+        ScanlineStream &operator=(const ScanlineStream &) = delete;
+
+        /**
+         * @brief Appends whole rows to the image: `rows.size()` must be a multiple of the width.
+         * Blocks while every strip is in use.
+         * @throws std::invalid_argument If it is not, or the planes of `rows` differ in size.
+         */
+        void push(Span<const InputType> rows);
+        void push(Planar<const InputComponent> rows);
+
+        /**
+         * @brief Ends the image, converting the rows of a partial last strip.
+         *
+         * With a sink, returns once the sink has received every row.
+         */
+        void finish();
+
+        /**
+         * @brief Copies converted rows to `rows`, as many as are converted and fit in it.
+         *
+         * Blocks until a row is converted. Not available with a sink.
+         * @return the number of rows copied, 0 once every row of a finished image was pulled.
+         * @throws std::invalid_argument If `rows.size()` is not a multiple of the width, or its
+         * planes differ in size.
+         */
+        std::size_t pull(Span<OutputType> rows);
+        std::size_t pull(Planar<OutputComponent> rows);
+
+        std::size_t width() const { return width_; }
+        std::size_t stripHeight() const { return stripHeight_; }
+        std::size_t stripCount() const { return stripCount_; }
+
+        /**
+         * @brief Memory of the strips once all are in use, in bytes.
+         */
+        std::size_t workingMemory() const { return stripCount_ * stripHeight_ * width_ * (sizeof(InputType) + sizeof(OutputType)); }
+
+    private:
+        struct Strip;
+
+        // Starts filling the next strip, allocated on first use; waits while it is in use
+        Strip &beginFilling();
+
+        // Hands the strip being filled to the conversion thread
+        void endFilling();
+
+        // Next converted strip, waiting for it if `isBlocking`; null once every strip was drained
+        Strip *nextConverted(bool isBlocking);
+
+        // Releases the strip drained to the sink or pulled, for push to fill it again
+        void endDraining();
+
+        template <typename CopyRows>
+        void pushRows(std::size_t rowCount, CopyRows copyRows);
+
+        template <typename CopyRows>
+        std::size_t pullRows(std::size_t rowCount, CopyRows copyRows);
+
+        void convert();
+        void drainToSink();
+
+        std::size_t width_;
+        std::size_t stripHeight_;
+        std::size_t stripCount_;
+        GamutMapping mapping_;
+        ThreadPool *pool_;
+        RowSink sink_;
+
+        std::unique_ptr<Strip[]> strips_;
+
+        // Rows pushed to the strip being filled, owned by the pushing thread
+        std::size_t filledRows_ = 0;
+        // Rows pulled from the strip being pulled, owned by the pulling thread
+        std::size_t pulledRows_ = 0;
+
+        // Guard the fields below
+        std::mutex mutex_;
+        std::condition_variable stripFilled_;
+        std::condition_variable stripConverted_;
+        std::condition_variable stripDrained_;
+        // Strips handed to the conversion thread, converted and drained since the start
+        std::size_t filled_ = 0;
+        std::size_t converted_ = 0;
+        std::size_t drained_ = 0;
+        bool isFinished_ = false;
+        bool isStopping_ = false;
+
+        std::thread converter_;
+        std::thread drainer_;
+    };
+
+    using P3ToRgbStream = ScanlineStream<P3, RGB>;
+    using RgbToP3Stream = ScanlineStream<RGB, P3>;
+    using OklabToRgbStream = ScanlineStream<Oklab, RGB>;
+    using OklabToP3Stream = ScanlineStream<Oklab, P3>;
+} // namespace oklab
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @file ThreadPool.h
+ * @brief Provides the pool of threads running the image conversions, with work stealing.
+ *
+ * `parallelFor` splits its index range evenly between the threads of the pool, the calling
+ * thread included. Each thread runs its own range in order; a thread whose range is empty steals
+ * the back half of the range of another thread. Tasks of uneven cost, such as tiles full of
+ * out-of-gamut colors, thus keep every thread busy until the end, while neighbouring indices
+ * mostly run on the same thread. Ranges are claimed with compare-and-swap, without locks.
+ */
+
+namespace oklab
+{
+    class ThreadPool
+    {
+    public:
+        /**
+         * @brief Starts a pool where `threadCount` threads run the tasks: the calling thread and
+         * `threadCount - 1` workers. The hardware concurrency when 0.
+         */
+        explicit ThreadPool(unsigned threadCount = 0);
+
+        /**
+         * @brief Stops and joins the workers; no `parallelFor` may be running.
+         */
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        /**
+         * @brief Threads running the tasks, the calling thread included.
+         */
+        unsigned threadCount() const { return static_cast<unsigned>(workers_.size()) + 1; }
+
+        /**
+         * @brief Runs `task(index)` for each index in [0, count) and returns once all have run.
+         *
+         * Calls from several threads run one after the other. Tasks must not call `parallelFor`
+         * on the same pool.
+         * @throws std::invalid_argument If `count` is 2^32 or more.
+         */
+        void parallelFor(std::size_t count, const std::function<void(std::size_t)> &task);
+
+        /**
+         * @brief Pool of the hardware concurrency, started on first use, used by the image
+         * conversions given no pool.
+         */
+        static ThreadPool &shared();
+
+    private:
+        struct Job;
+
+        void work(unsigned slot);
+
+        std::vector<std::thread> workers_;
+
+        // One parallelFor at a time
+        std::mutex callMutex_;
+
+        // Guard the fields below
+        std::mutex mutex_;
+        std::condition_variable jobStarted_;
+        std::condition_variable workersLeft_;
+        Job *job_ = nullptr;
+        std::uint64_t generation_ = 0;
+        unsigned joinedWorkers_ = 0;
+        bool isStopping_ = false;
+    };
+} // namespace oklab
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "ColorBatchConversions.h"
+#include "GamutMapping.h"
+
+/**
+ * @file TransferFunctions.h
+ * @brief Provides the sRGB / Display P3 transfer functions with selectable accuracy.
+ *
+ * Both color spaces share the same transfer function. Besides the exact pow-based version,
+ * branchless polynomial approximations trade accuracy for throughput on floating-point inputs;
+ * the batch versions run on the SIMD kernels.
+ *
+ * The batch conversions of gamma-encoded `GammaSRGB` / `GammaP3` buffers (double or float) run
+ * the transfer functions at the selected accuracy; with `TransferAccuracy::Exact`, they give the
+ * results of `gammaSRGBToOklab` / `oklabToGammaSRGB` (and P3) on each color.
+ *
+ * As in ColorBatchConversions.h, the batch functions throw `std::invalid_argument` when the output
+ * and input sizes differ.
+ */
+
+namespace oklab
+{
+    /**
+     * @brief Accuracy tiers of the transfer functions.
+     *
+     * Maximum absolute error over [-1, 1] versus the exact functions:
+     *
+     * | Tier     | gammaToLinear | linearToGamma |
+     * |----------|---------------|---------------|
+     * | Exact    | 0             | 0             |
+     * | Precise  | 3.1e-8        | 1.1e-8        |
+     * | EightBit | 6.4e-5        | 4.2e-5        |
+     *
+     * `Precise` stays below 1e-7. `EightBit` stays below 0.02 of an 8-bit step, so 8-bit
+     * results only differ on values within that distance of a rounding boundary.
+     */
+    enum class TransferAccuracy
+    {
+        Exact,
+        Precise,
+        EightBit
+    };
+
+    /**
+     * @brief Converts a gamma-encoded value to a linear light value.
+     * @tparam Accuracy Accuracy tier, selected at compile time.
+     * @param value The gamma-encoded value, typically in the range [0, 1]; must be finite.
+     * @return The linearized value.
+     */
+    template <TransferAccuracy Accuracy>
+    double gammaToLinear(double value);
+
+    /**
+     * @brief Converts a linear light value to a gamma-encoded value.
+     * @tparam Accuracy Accuracy tier, selected at compile time.
+     * @param value The linear light value, typically in the range [0, 1]; must be finite.
+     * @return The gamma-encoded value.
+     */
+    template <TransferAccuracy Accuracy>
+    double linearToGamma(double value);
+
+    /**
+     * @brief Converts a gamma-encoded value to a linear light value.
+     * @param value The gamma-encoded value, typically in the range [0, 1]; must be finite.
+     * @param accuracy Accuracy tier.
+     * @return The linearized value.
+     */
+    double gammaToLinear(double value, TransferAccuracy accuracy);
+
+    /**
+     * @brief Converts a linear light value to a gamma-encoded value.
+     * @param value The linear light value, typically in the range [0, 1]; must be finite.
+     * @param accuracy Accuracy tier.
+     * @return The gamma-encoded value.
+     */
+    double linearToGamma(double value, TransferAccuracy accuracy);
+
+    /**
+     * @brief Converts a buffer of gamma-encoded values to linear light values.
+     * @param input Gamma-encoded values; must be finite.
+     * @param output Receives the linear values; must have the same size as the input.
+     * @param accuracy Accuracy tier.
+     */
+    void gammaToLinear(Span<const double> input, Span<double> output, TransferAccuracy accuracy);
+
+    /**
+     * @brief Converts a buffer of linear light values to gamma-encoded values.
+     * @param input Linear values; must be finite.
+     * @param output Receives the gamma-encoded values; must have the same size as the input.
+     * @param accuracy Accuracy tier.
+     */
+    void linearToGamma(Span<const double> input, Span<double> output, TransferAccuracy accuracy);
+
+    /**
+     * @brief Converts a buffer of gamma-encoded sRGB colors to Oklab.
+     * @param input Colors with channels in [0, 1]; must be finite.
+     * @param output Receives the Oklab colors; must have the same size as the input.
+     * @param accuracy Accuracy tier of the decoding.
+     */
+    void gammaSRGBToOklab(Span<const GammaSRGB> input, Span<Oklab> output, TransferAccuracy accuracy = TransferAccuracy::Exact);
+    void gammaSRGBToOklab(Span<const GammaSRGBf> input, Span<Oklab> output, TransferAccuracy accuracy = TransferAccuracy::Exact);
+
+    /**
+     * @brief Converts a buffer of Oklab colors to gamma-encoded sRGB colors, without quantization.
+     * @param output Receives the colors; must have the same size as the input.
+     * @param mapping Gamut mapping, applied in linear light before the encoding.
+     * @param accuracy Accuracy tier of the encoding.
+     */
+    void oklabToGammaSRGB(Span<const Oklab> input, Span<GammaSRGB> output, GamutMapping mapping = defaultGamutMapping(),
+                          TransferAccuracy accuracy = TransferAccuracy::Exact);
+    void oklabToGammaSRGB(Span<const Oklab> input, Span<GammaSRGBf> output, GamutMapping mapping = defaultGamutMapping(),
+                          TransferAccuracy accuracy = TransferAccuracy::Exact);
+
+    /**
+     * @brief Converts a buffer of gamma-encoded P3 colors to Oklab.
+     * @param input Colors with channels in [0, 1]; must be finite.
+     * @param output Receives the Oklab colors; must have the same size as the input.
+     * @param accuracy Accuracy tier of the decoding.
+     */
+    void gammaP3ToOklab(Span<const GammaP3> input, Span<Oklab> output, TransferAccuracy accuracy = TransferAccuracy::Exact);
+    void gammaP3ToOklab(Span<const GammaP3f> input, Span<Oklab> output, TransferAccuracy accuracy = TransferAccuracy::Exact);
+
+    /**
+     * @brief Converts a buffer of Oklab colors to gamma-encoded P3 colors, without quantization.
+     * @param output Receives the colors; must have the same size as the input.
+     * @param mapping Gamut mapping, applied in linear light before the encoding.
+     * @param accuracy Accuracy tier of the encoding.
+     */
+    void oklabToGammaP3(Span<const Oklab> input, Span<GammaP3> output, GamutMapping mapping = defaultGamutMapping(),
+                        TransferAccuracy accuracy = TransferAccuracy::Exact);
+    void oklabToGammaP3(Span<const Oklab> input, Span<GammaP3f> output, GamutMapping mapping = defaultGamutMapping(),
+                        TransferAccuracy accuracy = TransferAccuracy::Exact);
+} // namespace oklab
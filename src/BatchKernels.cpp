@@ -0,0 +1,172 @@
+#include "BatchKernels.h"
+
+#include <algorithm>
+
+#include "TransferTables.h"
+#include "simd/SimdKernels.h"
+
+namespace oklab
+{
+    void storeBlock(const BlockPlanes &block, std::size_t count, StridedChannels<double> destination, std::size_t offset)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                destination.at(c, offset + i) = block.channels[c][i];
+            }
+        }
+    }
+
+    void loadDecodedBlock(StridedChannels<const int> source, std::size_t offset, std::size_t count, BlockPlanes &block)
+    {
+        const TransferTables8Bit &tables = transferTables8Bit();
+        for (int c = 0; c < 3; ++c)
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                block.channels[c][i] = gammaToLinear8Bit(tables, source.at(c, offset + i));
+            }
+            for (std::size_t i = count; i < paddedCount(count); ++i)
+            {
+                block.channels[c][i] = 0.0;
+            }
+        }
+    }
+
+    void encodeGammaBlock(const BlockPlanes &linear, std::size_t count, StridedChannels<int> destination, std::size_t offset)
+    {
+        const KernelTable &table = kernels();
+        alignas(64) int encoded[BATCH_BLOCK_SIZE];
+
+        for (int c = 0; c < 3; ++c)
+        {
+            table.encodeGamma(linear.channels[c], encoded, count);
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                destination.at(c, offset + i) = encoded[i];
+            }
+        }
+    }
+
+    void loadDecodedBlock(StridedChannels<const int> source, std::size_t offset, std::size_t count, const TransferTablesNBit &tables,
+                          BlockPlanes &block)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                block.channels[c][i] = gammaToLinearNBit(tables, source.at(c, offset + i));
+            }
+            for (std::size_t i = count; i < paddedCount(count); ++i)
+            {
+                block.channels[c][i] = 0.0;
+            }
+        }
+    }
+
+    void encodeGammaBlock(const BlockPlanes &linear, std::size_t count, const TransferTablesNBit &tables, StridedChannels<int> destination,
+                          std::size_t offset)
+    {
+        const KernelTable &table = kernels();
+        alignas(64) double estimates[BATCH_BLOCK_SIZE];
+
+        for (int c = 0; c < 3; ++c)
+        {
+            std::copy(linear.channels[c], linear.channels[c] + paddedCount(count), estimates);
+            table.linearToGamma(estimates, count, TransferAccuracy::Precise);
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                destination.at(c, offset + i) = linearToGammaNBit(tables, linear.channels[c][i], estimates[i]);
+            }
+        }
+    }
+
+    namespace
+    {
+        template <typename T>
+        void loadLinearized(StridedChannels<const T> source, std::size_t offset, std::size_t count, TransferAccuracy accuracy, BlockPlanes &block)
+        {
+            const KernelTable &table = kernels();
+            for (int c = 0; c < 3; ++c)
+            {
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    block.channels[c][i] = source.at(c, offset + i);
+                }
+                for (std::size_t i = count; i < paddedCount(count); ++i)
+                {
+                    block.channels[c][i] = 0.0;
+                }
+                table.gammaToLinear(block.channels[c], count, accuracy);
+            }
+        }
+
+        template <typename T>
+        void storeEncoded(BlockPlanes &linear, std::size_t count, TransferAccuracy accuracy, StridedChannels<T> destination, std::size_t offset)
+        {
+            const KernelTable &table = kernels();
+            for (int c = 0; c < 3; ++c)
+            {
+                table.linearToGamma(linear.channels[c], count, accuracy);
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    destination.at(c, offset + i) = static_cast<T>(linear.channels[c][i]);
+                }
+            }
+        }
+    } // namespace
+
+    void loadLinearizedBlock(StridedChannels<const double> source, std::size_t offset, std::size_t count, TransferAccuracy accuracy,
+                             BlockPlanes &block)
+    {
+        loadLinearized(source, offset, count, accuracy, block);
+    }
+
+    void loadLinearizedBlock(StridedChannels<const float> source, std::size_t offset, std::size_t count, TransferAccuracy accuracy,
+                             BlockPlanes &block)
+    {
+        loadLinearized(source, offset, count, accuracy, block);
+    }
+
+    void storeEncodedBlock(BlockPlanes &linear, std::size_t count, TransferAccuracy accuracy, StridedChannels<double> destination,
+                           std::size_t offset)
+    {
+        storeEncoded(linear, count, accuracy, destination, offset);
+    }
+
+    void storeEncodedBlock(BlockPlanes &linear, std::size_t count, TransferAccuracy accuracy, StridedChannels<float> destination,
+                           std::size_t offset)
+    {
+        storeEncoded(linear, count, accuracy, destination, offset);
+    }
+
+    void clipBlock(BlockPlanes &linear, std::size_t count)
+    {
+        const KernelTable &table = kernels();
+        for (int c = 0; c < 3; ++c)
+        {
+            table.clipToUnit(linear.channels[c], count);
+        }
+    }
+
+    void inGamutBlock(const BlockPlanes &linear, unsigned char *mask, std::size_t count)
+    {
+        kernels().inGamut(linear, mask, count);
+    }
+
+    void adjustOklabBlock(const OklabAdjustment &adjustment, BlockPlanes &oklab, std::size_t count)
+    {
+        kernels().adjustOklab(adjustment, oklab, count);
+    }
+
+    void searchCss4Block(const double fromLms[3][3], const double toLms[3][3], Css4Searches &searches)
+    {
+        kernels().css4Search(fromLms, toLms, searches);
+    }
+
+    void multiplyMatrixBlock(const double matrix[3][3], const BlockPlanes &input, BlockPlanes &output, std::size_t count)
+    {
+        kernels().multiplyMatrix(matrix, input, output, count);
+    }
+} // namespace oklab
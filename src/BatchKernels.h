@@ -0,0 +1,444 @@
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+
+#include "ColorTypes.h"
+#include "ColorBatchConversions.h"
+#include "ColorMatrices.h"
+
+#include "ColorUtils.h"
+#include "TransferFunctions.h"
+#include "gamutMapping/GamutMappingPolicy.h"
+
+/**
+ * @file BatchKernels.h
+ * @brief Provides the block-wise building blocks used by the batch conversion functions.
+ *
+ * Batch conversions copy a block of pixels into structure-of-arrays planes and run each
+ * conversion stage as a plain loop over the block. Every stage performs exactly the same
+ * floating-point operations, in the same order, as the single-color functions, so batch
+ * results are bit-identical to the per-pixel ones.
+ */
+
+namespace oklab
+{
+    struct TransferTablesNBit;
+
+    /**
+     * @brief Number of pixels converted per block (three planes of doubles fit in L1).
+     */
+    constexpr std::size_t BATCH_BLOCK_SIZE = 256;
+
+    /**
+     * @brief Structure-of-arrays scratch block: one plane of doubles per channel.
+     */
+    struct BlockPlanes
+    {
+        alignas(64) double channels[3][BATCH_BLOCK_SIZE];
+    };
+
+    /**
+     * @brief Strided access to the three channels of a color buffer.
+     *
+     * Describes both interleaved buffers (stride 3) and planar buffers (stride 1),
+     * so the batch functions share a single implementation for both layouts.
+     */
+    template <typename T>
+    struct StridedChannels
+    {
+        T *channels[3];
+        std::size_t stride;
+
+        T &at(int channel, std::size_t index) const { return channels[channel][index * stride]; }
+    };
+
+    template <typename T, typename Tag>
+    StridedChannels<T> stridedChannels(Span<TaggedArray<T, 3, Tag>> colors)
+    {
+        static_assert(sizeof(TaggedArray<T, 3, Tag>) == 3 * sizeof(T), "Colors must be tightly packed");
+        T *base = colors.empty() ? nullptr : colors.data()->data();
+        return {{base, base + 1, base + 2}, 3};
+    }
+
+    template <typename T, typename Tag>
+    StridedChannels<const T> stridedChannels(Span<const TaggedArray<T, 3, Tag>> colors)
+    {
+        static_assert(sizeof(TaggedArray<T, 3, Tag>) == 3 * sizeof(T), "Colors must be tightly packed");
+        const T *base = colors.empty() ? nullptr : colors.data()->data();
+        return {{base, base + 1, base + 2}, 3};
+    }
+
+    template <typename T>
+    StridedChannels<T> stridedChannels(Planar<T> planes)
+    {
+        return {{planes.channels[0].data(), planes.channels[1].data(), planes.channels[2].data()}, 1};
+    }
+
+    /**
+     * @brief Number of colors of a planar buffer.
+     * @throws std::invalid_argument If its three planes differ in size.
+     */
+    template <typename T>
+    std::size_t planarSize(Planar<T> planes)
+    {
+        std::size_t size = planes.channels[0].size();
+        if (planes.channels[1].size() != size || planes.channels[2].size() != size)
+        {
+            throw std::invalid_argument("planar channels differ in size");
+        }
+        return size;
+    }
+
+    /**
+     * @brief Number of colors converted from `input` to `output`, checked in release builds too:
+     * the public batch functions write through caller buffers.
+     * @throws std::invalid_argument If the buffers, or the planes of a planar buffer, differ in size.
+     */
+    template <typename Input, typename Output>
+    std::size_t batchSize(Span<Input> input, Span<Output> output)
+    {
+        if (input.size() != output.size())
+        {
+            throw std::invalid_argument("input and output sizes differ");
+        }
+        return input.size();
+    }
+
+    template <typename Input, typename Output>
+    std::size_t batchSize(Planar<Input> input, Planar<Output> output)
+    {
+        std::size_t size = planarSize(input);
+        if (planarSize(output) != size)
+        {
+            throw std::invalid_argument("input and output sizes differ");
+        }
+        return size;
+    }
+
+    /**
+     * @brief Calls `convertBlock(offset, count)` for each consecutive block of a buffer.
+     */
+    template <typename Function>
+    void forEachBlock(std::size_t size, Function convertBlock)
+    {
+        for (std::size_t offset = 0; offset < size; offset += BATCH_BLOCK_SIZE)
+        {
+            std::size_t count = size - offset < BATCH_BLOCK_SIZE ? size - offset : BATCH_BLOCK_SIZE;
+            convertBlock(offset, count);
+        }
+    }
+
+    /**
+     * @brief Number of elements the block kernels are allowed to process at once.
+     *
+     * Kernels work on whole vectors and may process up to `paddedCount(count)` elements of a
+     * block; the padding lanes are zero-filled when loading and their results are ignored.
+     */
+    constexpr std::size_t BATCH_LANE_PADDING = 16;
+
+    inline std::size_t paddedCount(std::size_t count)
+    {
+        return (count + BATCH_LANE_PADDING - 1) / BATCH_LANE_PADDING * BATCH_LANE_PADDING;
+    }
+
+    /**
+     * @brief Copies `count` colors starting at `offset` into the planes of a block.
+     */
+    template <typename T>
+    void loadBlock(StridedChannels<const T> source, std::size_t offset, std::size_t count, BlockPlanes &block)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                block.channels[c][i] = source.at(c, offset + i);
+            }
+            for (std::size_t i = count; i < paddedCount(count); ++i)
+            {
+                block.channels[c][i] = 0.0;
+            }
+        }
+    }
+
+    /**
+     * @brief Copies the first `count` colors of a block to the destination, starting at `offset`.
+     */
+    void storeBlock(const BlockPlanes &block, std::size_t count, StridedChannels<double> destination, std::size_t offset);
+
+    /**
+     * @brief Loads `count` 8-bit gamma-encoded colors starting at `offset` as linear light values.
+     *
+     * Block equivalent of `gammaToLinear(value / 255.0)`, read from the 8-bit decoding table.
+     */
+    void loadDecodedBlock(StridedChannels<const int> source, std::size_t offset, std::size_t count, BlockPlanes &block);
+
+    /**
+     * @brief Encodes linear light values into 0-255 values and stores them in the destination.
+     *
+     * Block equivalent of `linearRgbToRgb` / `linearP3ToP3`.
+     */
+    void encodeGammaBlock(const BlockPlanes &linear, std::size_t count, StridedChannels<int> destination, std::size_t offset);
+
+    /**
+     * @brief Loads `count` gamma-encoded codes of the tables' depth as linear light values.
+     *
+     * Block equivalent of `gammaToLinear(value / double(maxCode))`, read from the decoding table.
+     */
+    void loadDecodedBlock(StridedChannels<const int> source, std::size_t offset, std::size_t count, const TransferTablesNBit &tables,
+                          BlockPlanes &block);
+
+    /**
+     * @brief Encodes linear light values into codes of the tables' depth and stores them in the destination.
+     *
+     * Block equivalent of `std::round(linearToGamma(value) * maxCode)`: the `TransferAccuracy::Precise`
+     * kernel estimates each code, which the exact thresholds then settle.
+     */
+    void encodeGammaBlock(const BlockPlanes &linear, std::size_t count, const TransferTablesNBit &tables, StridedChannels<int> destination,
+                          std::size_t offset);
+
+    /**
+     * @brief Loads `count` gamma-encoded floating-point colors as linear light values.
+     *
+     * Block equivalent of `gammaToLinear<Accuracy>` on each channel.
+     */
+    void loadLinearizedBlock(StridedChannels<const double> source, std::size_t offset, std::size_t count, TransferAccuracy accuracy,
+                             BlockPlanes &block);
+    void loadLinearizedBlock(StridedChannels<const float> source, std::size_t offset, std::size_t count, TransferAccuracy accuracy,
+                             BlockPlanes &block);
+
+    /**
+     * @brief Gamma-encodes linear light values and stores them in the destination.
+     *
+     * Block equivalent of `linearToGamma<Accuracy>` on each channel; the block is encoded in place.
+     */
+    void storeEncodedBlock(BlockPlanes &linear, std::size_t count, TransferAccuracy accuracy, StridedChannels<double> destination,
+                           std::size_t offset);
+    void storeEncodedBlock(BlockPlanes &linear, std::size_t count, TransferAccuracy accuracy, StridedChannels<float> destination,
+                           std::size_t offset);
+
+    /**
+     * @brief Clamps every channel of a block to [0, 1], in place.
+     *
+     * Block equivalent of `clipToGamut`.
+     */
+    void clipBlock(BlockPlanes &linear, std::size_t count);
+
+    /**
+     * @brief Sets `mask[i]` to 1 when color `i` of a linear block is in gamut, 0 otherwise.
+     *
+     * Block equivalent of `isInGamut`; `mask` must hold `paddedCount(count)` entries.
+     */
+    void inGamutBlock(const BlockPlanes &linear, unsigned char *mask, std::size_t count);
+
+    /**
+     * @brief Multiplies each color of a block by a 3x3 matrix.
+     *
+     * Block equivalent of `multiplyMatrix`.
+     */
+    void multiplyMatrixBlock(const double matrix[3][3], const BlockPlanes &input, BlockPlanes &output, std::size_t count);
+
+    /**
+     * @brief Converts a block of LMS colors to Oklab.
+     *
+     * Block equivalent of `lmsToOklab`; the LMS planes are used as scratch space.
+     */
+    void lmsToOklabBlock(BlockPlanes &lms, BlockPlanes &oklab, std::size_t count);
+
+    /**
+     * @brief Converts a block of Oklab colors to LMS.
+     *
+     * Block equivalent of `oklabToLms`.
+     */
+    void oklabToLmsBlock(const BlockPlanes &oklab, BlockPlanes &lms, std::size_t count);
+
+    /**
+     * @brief Converts a block of Oklch colors to Oklab, in place.
+     *
+     * Block equivalent of `oklchToOklab`.
+     */
+    void oklchToOklabBlock(BlockPlanes &block, std::size_t count);
+
+    /**
+     * @brief Lightness, chroma and hue adjustment of Oklab colors, see `OklchAdjustment`.
+     *
+     * Lightness becomes `std::min(1.0, L + (1 - L) * lightness)` when `isLightening`, else
+     * `L * (1 - lightness)`; (a, b) is multiplied by `matrix`, the hue rotation scaled by the
+     * chroma factor.
+     */
+    struct OklabAdjustment
+    {
+        bool isLightening;
+        double lightness;
+        double matrix[2][2];
+    };
+
+    /**
+     * @brief Adjusts a block of Oklab colors in place.
+     */
+    void adjustOklabBlock(const OklabAdjustment &adjustment, BlockPlanes &oklab, std::size_t count);
+
+    /**
+     * @brief Matrices between LMS and the linear color space `LinearColorType`.
+     */
+    template <typename LinearColorType>
+    struct LinearSpaceMatrices;
+
+    template <>
+    struct LinearSpaceMatrices<LinearSRGB>
+    {
+        static constexpr const double (&FROM_LMS)[3][3] = LMS_TO_RGB;
+        static constexpr const double (&TO_LMS)[3][3] = RGB_TO_LMS;
+    };
+
+    template <>
+    struct LinearSpaceMatrices<LinearP3>
+    {
+        static constexpr const double (&FROM_LMS)[3][3] = LMS_TO_P3;
+        static constexpr const double (&TO_LMS)[3][3] = P3_TO_LMS;
+    };
+
+    /**
+     * @brief The CSS4 chroma searches of a block, one per color that needs one.
+     *
+     * Each search runs the bisection of `performCssGamutMapping` on the chroma line of its color,
+     * from 0 to `chroma`.
+     */
+    struct Css4Searches
+    {
+        std::size_t count = 0;
+        // Chroma lines: lightness, cos(h) and sin(h), as a `PolarOklab`
+        alignas(64) double lightness[BATCH_BLOCK_SIZE];
+        alignas(64) double cosine[BATCH_BLOCK_SIZE];
+        alignas(64) double sine[BATCH_BLOCK_SIZE];
+        alignas(64) double chroma[BATCH_BLOCK_SIZE];
+        // The clipped linear color: of the whole color on input, of the result on output
+        BlockPlanes clipped;
+        // Outputs, for the telemetry
+        int iterations[BATCH_BLOCK_SIZE];
+        bool isThresholdExit[BATCH_BLOCK_SIZE];
+    };
+
+    /**
+     * @brief Runs the searches of a block, vectorized across searches.
+     *
+     * Block equivalent of the chroma search of `performCssGamutMapping<ColorType, LinearColorType>`,
+     * with `fromLms` and `toLms` the matrices of `LinearColorType`.
+     */
+    void searchCss4Block(const double fromLms[3][3], const double toLms[3][3], Css4Searches &searches);
+
+    // Mapping to the linear color type itself: the batch conversions map whole blocks in linear
+    // light and encode them afterwards, to 8-bit codes or to other pixel formats
+    template <>
+    inline LinearSRGB linearColorToColor<LinearSRGB, LinearSRGB>(const LinearSRGB &linearRgb)
+    {
+        return linearRgb;
+    }
+
+    template <>
+    inline LinearP3 linearColorToColor<LinearP3, LinearP3>(const LinearP3 &linearP3)
+    {
+        return linearP3;
+    }
+
+    /**
+     * @brief Gamut maps a block of colors in place, in the linear target space.
+     *
+     * Applies `Mapping` with the same per-pixel semantics as `oklabToRgb` / `oklabToP3` before
+     * their encoding, which `encodeGammaBlock` then performs. With CSS4 or CUSP, pixels whose
+     * lightness is outside (0, 1) or whose linear color is out of gamut are overwritten with the
+     * result of `mapToGamut`; with CSS4, the chroma searches of the block run together in
+     * `searchCss4Block`. Except with `GamutMapping::None`, every channel ends in [0, 1].
+     *
+     * @param oklab The Oklab block.
+     * @param linear The same block converted to the linear target space; receives the mapped colors.
+     */
+    template <typename LinearColorType, GamutMapping Mapping>
+    void mapBlockToGamut(const BlockPlanes &oklab, BlockPlanes &linear, std::size_t count)
+    {
+        auto storeColor = [&](std::size_t i, const LinearColorType &color)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                linear.channels[c][i] = color[c];
+            }
+        };
+
+        if constexpr (Mapping == GamutMapping::Css4)
+        {
+            alignas(64) unsigned char inGamut[BATCH_BLOCK_SIZE];
+            inGamutBlock(linear, inGamut, count);
+
+            Css4Searches searches;
+            std::size_t searchedPixels[BATCH_BLOCK_SIZE];
+
+            std::size_t skipped = 0;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                double lightness = oklab.channels[0][i];
+                if (lightness < 1 && lightness > 0 && inGamut[i]) [[likely]]
+                {
+                    ++skipped;
+                    continue;
+                }
+
+                Oklab pixel{oklab.channels[0][i], oklab.channels[1][i], oklab.channels[2][i]};
+                LinearColorType color;
+                PolarOklab polar;
+                LinearColorType clippedLinearColor;
+                if (css4::mapWithoutSearch(pixel, color, polar, clippedLinearColor))
+                {
+                    storeColor(i, color);
+                    continue;
+                }
+
+                std::size_t search = searches.count++;
+                searchedPixels[search] = i;
+                searches.lightness[search] = polar.lightness;
+                searches.cosine[search] = polar.cosine;
+                searches.sine[search] = polar.sine;
+                searches.chroma[search] = polar.chroma;
+                for (int c = 0; c < 3; ++c)
+                {
+                    searches.clipped.channels[c][search] = clippedLinearColor[c];
+                }
+            }
+
+            searchCss4Block(LinearSpaceMatrices<LinearColorType>::FROM_LMS, LinearSpaceMatrices<LinearColorType>::TO_LMS, searches);
+
+            for (std::size_t search = 0; search < searches.count; ++search)
+            {
+                LinearColorType clippedLinearColor{searches.clipped.channels[0][search],
+                                                   searches.clipped.channels[1][search],
+                                                   searches.clipped.channels[2][search]};
+                storeColor(searchedPixels[search], clipToGamut<LinearColorType>(clippedLinearColor));
+
+                telemetry::recordSearch(searches.isThresholdExit[search] ? telemetry::THRESHOLD_EXITS : telemetry::CONVERGED_EXITS,
+                                        searches.iterations[search]);
+            }
+
+            telemetry::record(telemetry::IN_GAMUT_EXITS, skipped);
+        }
+        else if constexpr (Mapping == GamutMapping::Cusp)
+        {
+            alignas(64) unsigned char inGamut[BATCH_BLOCK_SIZE];
+            inGamutBlock(linear, inGamut, count);
+
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                double lightness = oklab.channels[0][i];
+                if (lightness < 1 && lightness > 0 && inGamut[i]) [[likely]]
+                {
+                    continue;
+                }
+
+                Oklab pixel{oklab.channels[0][i], oklab.channels[1][i], oklab.channels[2][i]};
+                storeColor(i, mapToGamut<Mapping, LinearColorType, LinearColorType>(pixel));
+            }
+        }
+        else if constexpr (Mapping == GamutMapping::Clamp)
+        {
+            clipBlock(linear, count);
+        }
+    }
+} // namespace oklab
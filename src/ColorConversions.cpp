@@ -1,19 +1,158 @@
 #include "ColorConversions.h"
 #include "ColorConversionsInternal.h"
 
-#include "gamutMapping/CSS4.h"
+#include <array>
+
+#include "ColorMatrices.h"
+#include "MathUtils.h"
+#include "TransferTables.h"
+#include "gamutMapping/GamutMappingPolicy.h"
 
 namespace oklab
 {
+    namespace
+    {
+        struct Matrix3x3
+        {
+            double values[3][3];
+        };
+
+        constexpr Matrix3x3 multiplyMatrices(const double (&left)[3][3], const double (&right)[3][3])
+        {
+            Matrix3x3 result{};
+            for (int i = 0; i < 3; ++i)
+            {
+                for (int j = 0; j < 3; ++j)
+                {
+                    for (int k = 0; k < 3; ++k)
+                    {
+                        result.values[i][j] += left[i][k] * right[k][j];
+                    }
+                }
+            }
+            return result;
+        }
+
+        // Direct linear transforms, skipping the cube root / cube of the Oklab round trip.
+        constexpr Matrix3x3 LINEAR_RGB_TO_LINEAR_P3 = multiplyMatrices(LMS_TO_P3, RGB_TO_LMS);
+        constexpr Matrix3x3 LINEAR_P3_TO_LINEAR_RGB = multiplyMatrices(LMS_TO_RGB, P3_TO_LMS);
+
+        // Over all 8-bit inputs, the direct transforms differ from the Oklab round trip by less
+        // than 1e-14. Colors at least this far from the gamut edges and from the 8-bit rounding
+        // thresholds are therefore in gamut on both paths and encode to the same codes.
+        constexpr double DIRECT_TRANSFORM_TOLERANCE = 1e-12;
+
+        /**
+         * @brief Converts an in-gamut 8-bit color with a single linear transform.
+         *
+         * Returns false, leaving `output` unspecified, when the color is out of gamut or too close
+         * to an edge or a rounding threshold: the caller must then take the Oklab route.
+         */
+        template <typename OutputType, typename InputType>
+        bool convertInGamutDirectly(const Matrix3x3 &matrix, const InputType &input, OutputType &output)
+        {
+            const TransferTables8Bit &tables = transferTables8Bit();
+            std::array<double, 3> decoded = {gammaToLinear8Bit(tables, input[0]),
+                                             gammaToLinear8Bit(tables, input[1]),
+                                             gammaToLinear8Bit(tables, input[2])};
+            std::array<double, 3> linear = multiplyMatrix(matrix.values, decoded);
+
+            for (int c = 0; c < 3; ++c)
+            {
+                double value = linear[c];
+                if (!(value >= DIRECT_TRANSFORM_TOLERANCE && value <= 1.0 - DIRECT_TRANSFORM_TOLERANCE))
+                {
+                    return false;
+                }
+
+                int code = linearToGamma8Bit(tables, value);
+                if (value - tables.encodeThresholds[code] < DIRECT_TRANSFORM_TOLERANCE ||
+                    tables.encodeThresholds[code + 1] - value < DIRECT_TRANSFORM_TOLERANCE)
+                {
+                    return false;
+                }
+                output[c] = code;
+            }
+            return true;
+        }
+
+        // The direct conversions skip the gamut mapping, which would have found the color in gamut
+        inline void recordDirectConversion(GamutMapping mapping)
+        {
+            if (mapping == GamutMapping::Css4)
+            {
+                telemetry::record(telemetry::IN_GAMUT_EXITS);
+            }
+        }
+    } // namespace
+
+    template <typename Scalar>
     P3 rgbToP3(const RGB &rgb)
     {
-        Oklab oklab = rgbToOklab(rgb);
+        BasicOklab<Scalar> oklab = rgbToOklab<Scalar>(rgb);
         return oklabToP3(oklab);
     }
 
+    template <typename Scalar>
     RGB p3ToRgb(const P3 &p3)
     {
-        Oklab oklab = p3ToOklab(p3);
+        BasicOklab<Scalar> oklab = p3ToOklab<Scalar>(p3);
         return oklabToRgb(oklab);
     }
-}
\ No newline at end of file
+
+    template P3 rgbToP3<double>(const RGB &rgb);
+    template P3 rgbToP3<float>(const RGB &rgb);
+    template RGB p3ToRgb<double>(const P3 &p3);
+    template RGB p3ToRgb<float>(const P3 &p3);
+
+    P3 rgbToP3(const RGB &rgb)
+    {
+        // sRGB lies inside P3: only colors on the edge of the P3 gamut take the Oklab route.
+        P3 p3;
+        if (convertInGamutDirectly(LINEAR_RGB_TO_LINEAR_P3, rgb, p3)) [[likely]]
+        {
+            recordDirectConversion(DEFAULT_GAMUT_MAPPING);
+            return p3;
+        }
+        return rgbToP3<double>(rgb);
+    }
+
+    RGB p3ToRgb(const P3 &p3)
+    {
+        RGB rgb;
+        if (convertInGamutDirectly(LINEAR_P3_TO_LINEAR_RGB, p3, rgb))
+        {
+            recordDirectConversion(DEFAULT_GAMUT_MAPPING);
+            return rgb;
+        }
+        return p3ToRgb<double>(p3);
+    }
+
+    P3 rgbToP3(const RGB &rgb, GamutMapping mapping)
+    {
+        // In-gamut colors are left untouched by every mapping
+        P3 p3;
+        if (convertInGamutDirectly(LINEAR_RGB_TO_LINEAR_P3, rgb, p3)) [[likely]]
+        {
+            recordDirectConversion(mapping);
+            return p3;
+        }
+        return oklabToP3(rgbToOklab(rgb), mapping);
+    }
+
+    RGB p3ToRgb(const P3 &p3, GamutMapping mapping)
+    {
+        RGB rgb;
+        if (convertInGamutDirectly(LINEAR_P3_TO_LINEAR_RGB, p3, rgb))
+        {
+            recordDirectConversion(mapping);
+            return rgb;
+        }
+        return oklabToRgb(p3ToOklab(p3), mapping);
+    }
+
+    GamutMapping defaultGamutMapping()
+    {
+        return DEFAULT_GAMUT_MAPPING;
+    }
+}
@@ -1,8 +1,8 @@
 #pragma once
 
-#include "ColorTypes.h"
+#include "ColorConversions.h"
 
 namespace oklab
 {
     RGB convertP3ToRgbInternal(const P3 &p3, bool applyGamutCorrection);
-}
\ No newline at end of file
+}
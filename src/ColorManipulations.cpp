@@ -0,0 +1,95 @@
+#include "ColorManipulations.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "BatchKernels.h"
+
+namespace oklab
+{
+    namespace
+    {
+        // Both channels of (a, b) turn by the hue rotation and scale by the chroma factor
+        OklabAdjustment makeOklabAdjustment(const OklchAdjustment &adjustment)
+        {
+            double scale = std::max(0.0, 1 + adjustment.chroma);
+            double angle = adjustment.hue * M_PI / 180.0;
+            double cosine = std::cos(angle) * scale;
+            double sine = std::sin(angle) * scale;
+
+            OklabAdjustment oklabAdjustment{};
+            oklabAdjustment.isLightening = adjustment.lightness > 0;
+            oklabAdjustment.lightness = std::abs(adjustment.lightness);
+            oklabAdjustment.matrix[0][0] = cosine;
+            oklabAdjustment.matrix[0][1] = -sine;
+            oklabAdjustment.matrix[1][0] = sine;
+            oklabAdjustment.matrix[1][1] = cosine;
+            return oklabAdjustment;
+        }
+
+        template <typename ColorType>
+        struct LinearColorOf;
+
+        template <>
+        struct LinearColorOf<RGB>
+        {
+            using Type = LinearSRGB;
+        };
+
+        template <>
+        struct LinearColorOf<P3>
+        {
+            using Type = LinearP3;
+        };
+
+        template <typename ColorType, GamutMapping Mapping>
+        void adjustEncodedColors(StridedChannels<const int> input, StridedChannels<int> output, std::size_t size,
+                                 const OklabAdjustment &adjustment)
+        {
+            using Matrices = LinearSpaceMatrices<typename LinearColorOf<ColorType>::Type>;
+
+            forEachBlock(size, [&](std::size_t offset, std::size_t count)
+            {
+                BlockPlanes oklab;
+                BlockPlanes lms;
+                BlockPlanes linear;
+                loadDecodedBlock(input, offset, count, linear);
+                multiplyMatrixBlock(Matrices::TO_LMS, linear, lms, count);
+                lmsToOklabBlock(lms, oklab, count);
+                adjustOklabBlock(adjustment, oklab, count);
+                oklabToLmsBlock(oklab, lms, count);
+                multiplyMatrixBlock(Matrices::FROM_LMS, lms, linear, count);
+                mapBlockToGamut<typename LinearColorOf<ColorType>::Type, Mapping>(oklab, linear, count);
+                encodeGammaBlock(linear, count, output, offset);
+            });
+        }
+    }
+
+    template <typename ColorType>
+    void adjustColors(Span<const ColorType> input, Span<ColorType> output, const OklchAdjustment &adjustment, GamutMapping mapping)
+    {
+        std::size_t size = batchSize(input, output);
+        OklabAdjustment oklabAdjustment = makeOklabAdjustment(adjustment);
+        dispatchGamutMapping(mapping, [&](auto constant)
+        {
+            adjustEncodedColors<ColorType, decltype(constant)::value>(stridedChannels(input), stridedChannels(output), size,
+                                                                      oklabAdjustment);
+        });
+    }
+
+    template <>
+    void adjustColors<Oklab>(Span<const Oklab> input, Span<Oklab> output, const OklchAdjustment &adjustment, GamutMapping)
+    {
+        OklabAdjustment oklabAdjustment = makeOklabAdjustment(adjustment);
+        forEachBlock(batchSize(input, output), [&](std::size_t offset, std::size_t count)
+        {
+            BlockPlanes oklab;
+            loadBlock(stridedChannels(input), offset, count, oklab);
+            adjustOklabBlock(oklabAdjustment, oklab, count);
+            storeBlock(oklab, count, stridedChannels(output), offset);
+        });
+    }
+
+    template void adjustColors(Span<const RGB>, Span<RGB>, const OklchAdjustment &, GamutMapping);
+    template void adjustColors(Span<const P3>, Span<P3>, const OklchAdjustment &, GamutMapping);
+} // namespace oklab
@@ -2,6 +2,12 @@
 
 #include "ColorTypes.h"
 #include "ColorUtils.h"
+#include "ConversionFormulas.h"
+#include "MathUtils.h"
+#include "TransferFunctions.h"
+#include "TransferApprox.h"
+#include "BatchKernels.h"
+#include "simd/SimdKernels.h"
 
 /**
  * @file ColorUtils.h
@@ -13,16 +19,7 @@ namespace oklab
     // Converts a linear light value to a gamma-encoded value.
     double gammaToLinear(double value)
     {
-        double absValue = std::abs(value);
-
-        if (absValue <= 0.04045)
-        {
-            return value / 12.92;
-        }
-        else
-        {
-            return std::copysign(std::pow((absValue + 0.055) / 1.055, 2.4), value);
-        }
+        return formulas::gammaToLinear<LibraryMath>(value);
     }
 
     // NOTE: We may optimize this by doing a branchless version and precomputing the constants.
@@ -44,15 +41,102 @@ namespace oklab
     // Converts a gamma-encoded light value to a linear value.
     double linearToGamma(double value)
     {
-        double absValue = std::abs(value);
+        return formulas::linearToGamma<LibraryMath>(value);
+    }
+
+    template <>
+    double gammaToLinear<TransferAccuracy::Exact>(double value)
+    {
+        return gammaToLinear(value);
+    }
+
+    template <>
+    double gammaToLinear<TransferAccuracy::Precise>(double value)
+    {
+        return transferApprox::gammaToLinear<TransferAccuracy::Precise>(value);
+    }
+
+    template <>
+    double gammaToLinear<TransferAccuracy::EightBit>(double value)
+    {
+        return transferApprox::gammaToLinear<TransferAccuracy::EightBit>(value);
+    }
+
+    template <>
+    double linearToGamma<TransferAccuracy::Exact>(double value)
+    {
+        return linearToGamma(value);
+    }
+
+    template <>
+    double linearToGamma<TransferAccuracy::Precise>(double value)
+    {
+        return transferApprox::linearToGamma<TransferAccuracy::Precise>(value);
+    }
+
+    template <>
+    double linearToGamma<TransferAccuracy::EightBit>(double value)
+    {
+        return transferApprox::linearToGamma<TransferAccuracy::EightBit>(value);
+    }
+
+    double gammaToLinear(double value, TransferAccuracy accuracy)
+    {
+        switch (accuracy)
+        {
+        case TransferAccuracy::Precise:
+            return gammaToLinear<TransferAccuracy::Precise>(value);
+        case TransferAccuracy::EightBit:
+            return gammaToLinear<TransferAccuracy::EightBit>(value);
+        default:
+            return gammaToLinear(value);
+        }
+    }
 
-        if (absValue <= 0.0031308)
+    double linearToGamma(double value, TransferAccuracy accuracy)
+    {
+        switch (accuracy)
         {
-            return 12.92 * value;
+        case TransferAccuracy::Precise:
+            return linearToGamma<TransferAccuracy::Precise>(value);
+        case TransferAccuracy::EightBit:
+            return linearToGamma<TransferAccuracy::EightBit>(value);
+        default:
+            return linearToGamma(value);
         }
-        else
+    }
+
+    namespace
+    {
+        // Runs a transfer kernel over a buffer, one padded block plane at a time.
+        void transformInBlocks(Span<const double> input, Span<double> output, TransferAccuracy accuracy,
+                               void (*kernel)(double *plane, std::size_t count, TransferAccuracy accuracy))
         {
-            return std::copysign(1.055 * std::pow(absValue, 1.0 / 2.4) - 0.055, value);
+            forEachBlock(batchSize(input, output), [&](std::size_t offset, std::size_t count)
+            {
+                alignas(64) double plane[BATCH_BLOCK_SIZE];
+                for (std::size_t i = 0; i < paddedCount(count); ++i)
+                {
+                    plane[i] = i < count ? input[offset + i] : 0.0;
+                }
+
+                kernel(plane, count, accuracy);
+
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    output[offset + i] = plane[i];
+                }
+            });
         }
+    } // namespace
+
+    void gammaToLinear(Span<const double> input, Span<double> output, TransferAccuracy accuracy)
+    {
+        transformInBlocks(input, output, accuracy, kernels().gammaToLinear);
+    }
+
+    void linearToGamma(Span<const double> input, Span<double> output, TransferAccuracy accuracy)
+    {
+        transformInBlocks(input, output, accuracy, kernels().linearToGamma);
     }
 } // namespace oklab
\ No newline at end of file
@@ -0,0 +1,194 @@
+#include "ConversionCache.h"
+#include "ColorConversions.h"
+#include "BatchKernels.h"
+
+#include <cassert>
+#include <vector>
+
+namespace oklab
+{
+    namespace
+    {
+        // Address marking a block claimed by a thread that is computing it
+        const unsigned char FILLING_MARKER = 0;
+        const unsigned char *const FILLING_BLOCK = &FILLING_MARKER;
+
+        std::size_t threadCounterSlot(std::size_t slotCount)
+        {
+            static std::atomic<std::size_t> nextSlot{0};
+            thread_local std::size_t slot = nextSlot.fetch_add(1, std::memory_order_relaxed);
+            return slot % slotCount;
+        }
+
+        template <typename InputType, typename OutputType>
+        struct CacheTraits;
+
+        template <>
+        struct CacheTraits<P3, RGB>
+        {
+            static RGB convert(const P3 &p3) { return p3ToRgb(p3); }
+
+            static void convert(Span<const P3> input, Span<Oklab> oklab, Span<RGB> output)
+            {
+                p3ToOklab(input, oklab);
+                oklabToRgb(oklab, output);
+            }
+        };
+
+        template <>
+        struct CacheTraits<RGB, P3>
+        {
+            static P3 convert(const RGB &rgb) { return rgbToP3(rgb); }
+
+            static void convert(Span<const RGB> input, Span<Oklab> oklab, Span<P3> output)
+            {
+                rgbToOklab(input, oklab);
+                oklabToP3(oklab, output);
+            }
+        };
+
+        inline std::size_t blockIndex(int c0, int c1, int c2)
+        {
+            return (static_cast<std::size_t>(c0 >> 4) << 8) | (static_cast<std::size_t>(c1 >> 4) << 4) | static_cast<std::size_t>(c2 >> 4);
+        }
+
+        inline std::size_t entryIndex(int c0, int c1, int c2)
+        {
+            return (static_cast<std::size_t>(c0 & 15) << 8) | (static_cast<std::size_t>(c1 & 15) << 4) | static_cast<std::size_t>(c2 & 15);
+        }
+    } // namespace
+
+    template <typename InputType, typename OutputType>
+    ConversionCache<InputType, OutputType>::ConversionCache(std::size_t memoryLimit)
+        : maxBlocks_(memoryLimit / BLOCK_BYTES)
+    {
+        for (std::atomic<const unsigned char *> &block : blocks_)
+        {
+            block.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    template <typename InputType, typename OutputType>
+    ConversionCache<InputType, OutputType>::~ConversionCache()
+    {
+        for (std::atomic<const unsigned char *> &block : blocks_)
+        {
+            const unsigned char *entries = block.load(std::memory_order_acquire);
+            if (entries != nullptr && entries != FILLING_BLOCK)
+            {
+                delete[] entries;
+            }
+        }
+    }
+
+    template <typename InputType, typename OutputType>
+    const unsigned char *ConversionCache<InputType, OutputType>::fillBlock(std::size_t block, CounterSlot &counters)
+    {
+        // Reserve memory first, so concurrent fills never exceed the limit
+        if (allocatedBlocks_.fetch_add(1, std::memory_order_relaxed) >= maxBlocks_)
+        {
+            allocatedBlocks_.fetch_sub(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        const unsigned char *expected = nullptr;
+        if (!blocks_[block].compare_exchange_strong(expected, FILLING_BLOCK, std::memory_order_acquire))
+        {
+            allocatedBlocks_.fetch_sub(1, std::memory_order_relaxed);
+            return expected == FILLING_BLOCK ? nullptr : expected;
+        }
+
+        const int base0 = static_cast<int>(block >> 8) << 4;
+        const int base1 = static_cast<int>((block >> 4) & 15) << 4;
+        const int base2 = static_cast<int>(block & 15) << 4;
+
+        std::vector<InputType> input;
+        input.reserve(BLOCK_ENTRIES);
+        for (int c0 = 0; c0 < 16; ++c0)
+        {
+            for (int c1 = 0; c1 < 16; ++c1)
+            {
+                for (int c2 = 0; c2 < 16; ++c2)
+                {
+                    input.push_back(InputType{base0 + c0, base1 + c1, base2 + c2});
+                }
+            }
+        }
+        std::vector<Oklab> oklab(BLOCK_ENTRIES);
+        std::vector<OutputType> output(BLOCK_ENTRIES);
+        CacheTraits<InputType, OutputType>::convert(input, oklab, output);
+
+        unsigned char *entries = new unsigned char[BLOCK_BYTES];
+        for (std::size_t i = 0; i < BLOCK_ENTRIES; ++i)
+        {
+            entries[3 * i] = static_cast<unsigned char>(output[i][0]);
+            entries[3 * i + 1] = static_cast<unsigned char>(output[i][1]);
+            entries[3 * i + 2] = static_cast<unsigned char>(output[i][2]);
+        }
+
+        blocks_[block].store(entries, std::memory_order_release);
+        counters.blockFills.fetch_add(1, std::memory_order_relaxed);
+        return entries;
+    }
+
+    template <typename InputType, typename OutputType>
+    OutputType ConversionCache<InputType, OutputType>::convert(const InputType &color)
+    {
+        assert(color[0] >= 0 && color[0] <= 255 && color[1] >= 0 && color[1] <= 255 && color[2] >= 0 && color[2] <= 255);
+
+        CounterSlot &counters = counters_[threadCounterSlot(COUNTER_SLOTS)];
+        const std::size_t block = blockIndex(color[0], color[1], color[2]);
+
+        const unsigned char *entries = blocks_[block].load(std::memory_order_acquire);
+        if (entries != nullptr && entries != FILLING_BLOCK) [[likely]]
+        {
+            counters.hits.fetch_add(1, std::memory_order_relaxed);
+        }
+        else
+        {
+            counters.misses.fetch_add(1, std::memory_order_relaxed);
+            entries = entries == nullptr ? fillBlock(block, counters) : nullptr;
+            if (entries == nullptr)
+            {
+                counters.bypasses.fetch_add(1, std::memory_order_relaxed);
+                return CacheTraits<InputType, OutputType>::convert(color);
+            }
+        }
+
+        const unsigned char *entry = entries + 3 * entryIndex(color[0], color[1], color[2]);
+        return OutputType{entry[0], entry[1], entry[2]};
+    }
+
+    template <typename InputType, typename OutputType>
+    void ConversionCache<InputType, OutputType>::convert(Span<const InputType> input, Span<OutputType> output)
+    {
+        std::size_t size = batchSize(input, output);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            output[i] = convert(input[i]);
+        }
+    }
+
+    template <typename InputType, typename OutputType>
+    CacheStatistics ConversionCache<InputType, OutputType>::statistics() const
+    {
+        CacheStatistics statistics{0, 0, 0, 0};
+        for (const CounterSlot &slot : counters_)
+        {
+            statistics.hits += slot.hits.load(std::memory_order_relaxed);
+            statistics.misses += slot.misses.load(std::memory_order_relaxed);
+            statistics.blockFills += slot.blockFills.load(std::memory_order_relaxed);
+            statistics.bypasses += slot.bypasses.load(std::memory_order_relaxed);
+        }
+        return statistics;
+    }
+
+    template <typename InputType, typename OutputType>
+    std::size_t ConversionCache<InputType, OutputType>::memoryUsage() const
+    {
+        return allocatedBlocks_.load(std::memory_order_relaxed) * BLOCK_BYTES;
+    }
+
+    template class ConversionCache<P3, RGB>;
+    template class ConversionCache<RGB, P3>;
+} // namespace oklab
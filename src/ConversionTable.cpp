@@ -0,0 +1,216 @@
+#include "ConversionTable.h"
+#include "ColorConversions.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace oklab
+{
+    namespace
+    {
+        constexpr char TABLE_MAGIC[8] = {'O', 'K', 'L', 'A', 'B', 'L', 'U', 'T'};
+        constexpr std::uint32_t TABLE_FORMAT_VERSION = 1;
+        constexpr std::size_t TABLE_DATA_OFFSET = 4096;
+        // Entries sharing their first channel, the unit of work of the build threads
+        constexpr std::size_t SLICE_COUNT = 256;
+        constexpr std::size_t SLICE_SIZE = std::size_t{1} << 16;
+
+#ifdef OKLAB_VERSION
+        constexpr const char *LIBRARY_VERSION = OKLAB_VERSION;
+#else
+        constexpr const char *LIBRARY_VERSION = "unknown";
+#endif
+
+        const char *gamutMappingName(GamutMapping mapping)
+        {
+            switch (mapping)
+            {
+            case GamutMapping::Css4:
+                return "CSS4";
+            case GamutMapping::Cusp:
+                return "CUSP";
+            case GamutMapping::Clamp:
+                return "CLAMP";
+            case GamutMapping::None:
+            default:
+                return "NONE";
+            }
+        }
+
+        template <typename InputType, typename OutputType>
+        struct TableTraits;
+
+        template <>
+        struct TableTraits<P3, RGB>
+        {
+            static constexpr ConversionTableDirection DIRECTION = ConversionTableDirection::P3ToRgb;
+            static RGB convert(const P3 &p3) { return p3ToRgb(p3); }
+        };
+
+        template <>
+        struct TableTraits<RGB, P3>
+        {
+            static constexpr ConversionTableDirection DIRECTION = ConversionTableDirection::RgbToP3;
+            static P3 convert(const RGB &rgb) { return rgbToP3(rgb); }
+        };
+
+        ConversionTableHeader expectedHeader(ConversionTableDirection direction)
+        {
+            ConversionTableHeader header{};
+            std::memcpy(header.magic, TABLE_MAGIC, sizeof(header.magic));
+            header.formatVersion = TABLE_FORMAT_VERSION;
+            header.direction = static_cast<std::uint32_t>(direction);
+            std::strncpy(header.libraryVersion, LIBRARY_VERSION, sizeof(header.libraryVersion) - 1);
+            std::strncpy(header.mappingAlgorithm, gamutMappingName(defaultGamutMapping()), sizeof(header.mappingAlgorithm) - 1);
+            header.entryCount = std::size_t{1} << 24;
+            header.dataOffset = TABLE_DATA_OFFSET;
+            return header;
+        }
+
+        bool headersMatch(const ConversionTableHeader &actual, const ConversionTableHeader &expected)
+        {
+            return std::memcmp(actual.magic, expected.magic, sizeof(actual.magic)) == 0 &&
+                   actual.formatVersion == expected.formatVersion &&
+                   actual.direction == expected.direction &&
+                   std::strncmp(actual.libraryVersion, expected.libraryVersion, sizeof(actual.libraryVersion)) == 0 &&
+                   std::strncmp(actual.mappingAlgorithm, expected.mappingAlgorithm, sizeof(actual.mappingAlgorithm)) == 0 &&
+                   actual.entryCount == expected.entryCount &&
+                   actual.dataOffset == expected.dataOffset;
+        }
+
+        // Fills the entries with a pool of threads pulling slices from a shared counter:
+        // out-of-gamut colors are not spread evenly, so fixed ranges would leave threads idle.
+        template <typename InputType, typename OutputType>
+        void fillEntries(unsigned char *entries, unsigned threadCount)
+        {
+            std::atomic<std::size_t> nextSlice{0};
+            auto worker = [&]()
+            {
+                for (std::size_t slice = nextSlice++; slice < SLICE_COUNT; slice = nextSlice++)
+                {
+                    for (std::size_t index = slice * SLICE_SIZE; index < (slice + 1) * SLICE_SIZE; ++index)
+                    {
+                        InputType input{static_cast<int>(index >> 16), static_cast<int>((index >> 8) & 0xff), static_cast<int>(index & 0xff)};
+                        OutputType output = TableTraits<InputType, OutputType>::convert(input);
+                        unsigned char *entry = entries + 3 * index;
+                        entry[0] = static_cast<unsigned char>(output[0]);
+                        entry[1] = static_cast<unsigned char>(output[1]);
+                        entry[2] = static_cast<unsigned char>(output[2]);
+                    }
+                }
+            };
+
+            std::vector<std::thread> threads;
+            for (unsigned i = 1; i < threadCount; ++i)
+            {
+                threads.emplace_back(worker);
+            }
+            worker();
+            for (std::thread &thread : threads)
+            {
+                thread.join();
+            }
+        }
+    } // namespace
+
+    template <typename InputType, typename OutputType>
+    bool ConversionTable<InputType, OutputType>::build(const std::string &path, unsigned threadCount)
+    {
+        if (threadCount == 0)
+        {
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        const std::size_t fileSize = TABLE_DATA_OFFSET + ENTRY_COUNT * ENTRY_SIZE;
+        const std::string temporaryPath = path + ".tmp" + std::to_string(getpid());
+
+        int fd = ::open(temporaryPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        void *mapping = MAP_FAILED;
+        if (ftruncate(fd, static_cast<off_t>(fileSize)) == 0)
+        {
+            mapping = mmap(nullptr, fileSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        if (mapping == MAP_FAILED)
+        {
+            close(fd);
+            unlink(temporaryPath.c_str());
+            return false;
+        }
+
+        unsigned char *bytes = static_cast<unsigned char *>(mapping);
+        ConversionTableHeader header = expectedHeader(TableTraits<InputType, OutputType>::DIRECTION);
+        std::memcpy(bytes, &header, sizeof(header));
+        fillEntries<InputType, OutputType>(bytes + TABLE_DATA_OFFSET, threadCount);
+
+        bool written = msync(mapping, fileSize, MS_SYNC) == 0;
+        munmap(mapping, fileSize);
+        written = close(fd) == 0 && written;
+
+        if (!written || std::rename(temporaryPath.c_str(), path.c_str()) != 0)
+        {
+            unlink(temporaryPath.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    template <typename InputType, typename OutputType>
+    std::unique_ptr<ConversionTable<InputType, OutputType>> ConversionTable<InputType, OutputType>::open(const std::string &path)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            return nullptr;
+        }
+
+        const std::size_t fileSize = TABLE_DATA_OFFSET + ENTRY_COUNT * ENTRY_SIZE;
+        struct stat status;
+        if (fstat(fd, &status) != 0 || static_cast<std::size_t>(status.st_size) != fileSize)
+        {
+            close(fd);
+            return nullptr;
+        }
+
+        // Shared read-only mapping: the pages are backed by the page cache, not copied per process
+        void *mapping = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED)
+        {
+            return nullptr;
+        }
+
+        ConversionTableHeader header;
+        std::memcpy(&header, mapping, sizeof(header));
+        if (!headersMatch(header, expectedHeader(TableTraits<InputType, OutputType>::DIRECTION)))
+        {
+            munmap(mapping, fileSize);
+            return nullptr;
+        }
+
+        const unsigned char *entries = static_cast<const unsigned char *>(mapping) + TABLE_DATA_OFFSET;
+        return std::unique_ptr<ConversionTable>(new ConversionTable(mapping, fileSize, entries));
+    }
+
+    template <typename InputType, typename OutputType>
+    ConversionTable<InputType, OutputType>::~ConversionTable()
+    {
+        munmap(mapping_, mappingSize_);
+    }
+
+    template class ConversionTable<P3, RGB>;
+    template class ConversionTable<RGB, P3>;
+} // namespace oklab
@@ -0,0 +1,135 @@
+#include "GamutMappingTelemetry.h"
+#include "gamutMapping/Telemetry.h"
+
+namespace oklab
+{
+    namespace telemetry
+    {
+#ifdef OKLAB_TELEMETRY
+        thread_local CounterBlock *threadBlock = nullptr;
+#endif
+
+        namespace
+        {
+            // Blocks of all threads, pushed at the head and never removed
+            std::atomic<CounterBlock *> blocks{nullptr};
+
+            // Totals at the last reset, subtracted from the snapshots
+            std::atomic<std::uint64_t> baseline[COUNTER_COUNT];
+
+            // Hands the block over to a later thread when its owner exits
+            struct BlockRelease
+            {
+                CounterBlock *block = nullptr;
+
+                ~BlockRelease()
+                {
+                    if (block != nullptr)
+                    {
+                        block->inUse.store(false, std::memory_order_release);
+                    }
+                }
+            };
+
+            void readTotals(std::uint64_t (&totals)[COUNTER_COUNT])
+            {
+                for (std::uint64_t &total : totals)
+                {
+                    total = 0;
+                }
+                for (CounterBlock *block = blocks.load(std::memory_order_acquire); block != nullptr; block = block->next)
+                {
+                    for (std::size_t c = 0; c < COUNTER_COUNT; ++c)
+                    {
+                        totals[c] += block->counters[c].load(std::memory_order_relaxed);
+                    }
+                }
+            }
+        } // namespace
+
+#ifdef OKLAB_TELEMETRY
+        CounterBlock *claimBlock()
+        {
+            // A block's counts stay in the totals: the new owner keeps incrementing them
+            CounterBlock *block = blocks.load(std::memory_order_acquire);
+            for (; block != nullptr; block = block->next)
+            {
+                bool expected = false;
+                if (!block->inUse.load(std::memory_order_relaxed) &&
+                    block->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire))
+                {
+                    break;
+                }
+            }
+
+            if (block == nullptr)
+            {
+                block = new CounterBlock();
+                for (std::atomic<std::uint64_t> &counter : block->counters)
+                {
+                    counter.store(0, std::memory_order_relaxed);
+                }
+                block->inUse.store(true, std::memory_order_relaxed);
+                block->next = blocks.load(std::memory_order_relaxed);
+                while (!blocks.compare_exchange_weak(block->next, block, std::memory_order_release, std::memory_order_relaxed))
+                {
+                }
+            }
+
+            thread_local BlockRelease release;
+            release.block = block;
+            threadBlock = block;
+            return block;
+        }
+#endif
+    } // namespace telemetry
+
+    bool gamutMappingTelemetryEnabled()
+    {
+#ifdef OKLAB_TELEMETRY
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    GamutMappingTelemetry gamutMappingTelemetry()
+    {
+        using namespace telemetry;
+
+        std::uint64_t totals[COUNTER_COUNT];
+        readTotals(totals);
+        for (std::size_t c = 0; c < COUNTER_COUNT; ++c)
+        {
+            totals[c] -= baseline[c].load(std::memory_order_relaxed);
+        }
+
+        GamutMappingTelemetry snapshot{};
+        snapshot.whiteExits = totals[WHITE_EXITS];
+        snapshot.blackExits = totals[BLACK_EXITS];
+        snapshot.inGamutExits = totals[IN_GAMUT_EXITS];
+        snapshot.clipExits = totals[CLIP_EXITS];
+        snapshot.convergedExits = totals[CONVERGED_EXITS];
+        snapshot.thresholdExits = totals[THRESHOLD_EXITS];
+        snapshot.searches = snapshot.convergedExits + snapshot.thresholdExits;
+        snapshot.calls = snapshot.whiteExits + snapshot.blackExits + snapshot.inGamutExits + snapshot.clipExits + snapshot.searches;
+        for (std::size_t bucket = 0; bucket < GamutMappingTelemetry::ITERATION_BUCKETS; ++bucket)
+        {
+            snapshot.iterations[bucket] = totals[ITERATIONS + bucket];
+        }
+        snapshot.totalIterations = totals[TOTAL_ITERATIONS];
+        return snapshot;
+    }
+
+    void resetGamutMappingTelemetry()
+    {
+        using namespace telemetry;
+
+        std::uint64_t totals[COUNTER_COUNT];
+        readTotals(totals);
+        for (std::size_t c = 0; c < COUNTER_COUNT; ++c)
+        {
+            baseline[c].store(totals[c], std::memory_order_relaxed);
+        }
+    }
+} // namespace oklab
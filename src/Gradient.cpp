@@ -0,0 +1,275 @@
+#include "Gradient.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+#include <type_traits>
+
+#include "BatchKernels.h"
+#include "OkLxx.h"
+#include "TransferFunctions.h"
+
+namespace oklab
+{
+    namespace
+    {
+        // Coordinates of a stop in the interpolation space
+        std::array<double, 3> toSpace(const Oklab &color, GradientSpace space)
+        {
+            if (space == GradientSpace::Oklab)
+            {
+                return {color[0], color[1], color[2]};
+            }
+            Oklch oklch = oklabToOklch(color);
+            return {oklch[0], oklch[1], oklch[2]};
+        }
+
+        // Moves the hues of a segment on the arc of the method, as CSS Color 4 hue fixup
+        void fixHues(double &from, double &to, HueInterpolation hueInterpolation)
+        {
+            if (std::isnan(from) && std::isnan(to))
+            {
+                from = to = 0.0;
+            }
+            else if (std::isnan(from))
+            {
+                from = to;
+            }
+            else if (std::isnan(to))
+            {
+                to = from;
+            }
+
+            double delta = to - from;
+            switch (hueInterpolation)
+            {
+            case HueInterpolation::Shorter:
+                if (delta > 180)
+                {
+                    from += 360;
+                }
+                else if (delta < -180)
+                {
+                    to += 360;
+                }
+                break;
+            case HueInterpolation::Longer:
+                if (delta > 0 && delta < 180)
+                {
+                    from += 360;
+                }
+                else if (delta > -180 && delta <= 0)
+                {
+                    to += 360;
+                }
+                break;
+            case HueInterpolation::Increasing:
+                if (delta < 0)
+                {
+                    to += 360;
+                }
+                break;
+            case HueInterpolation::Decreasing:
+                if (delta > 0)
+                {
+                    from += 360;
+                }
+                break;
+            }
+        }
+
+        void convertOklab(Span<const Oklab> oklab, Span<RGB> output, GamutMapping mapping)
+        {
+            oklabToRgb(oklab, output, mapping);
+        }
+
+        void convertOklab(Span<const Oklab> oklab, Span<P3> output, GamutMapping mapping)
+        {
+            oklabToP3(oklab, output, mapping);
+        }
+
+        void convertOklab(Span<const Oklab> oklab, Span<GammaSRGB> output, GamutMapping mapping)
+        {
+            oklabToGammaSRGB(oklab, output, mapping);
+        }
+
+        void convertOklab(Span<const Oklab> oklab, Span<GammaP3> output, GamutMapping mapping)
+        {
+            oklabToGammaP3(oklab, output, mapping);
+        }
+    } // namespace
+
+    Gradient::Gradient(Span<const GradientStop> stops, GradientSpace space, HueInterpolation hueInterpolation) : space_(space)
+    {
+        if (stops.empty())
+        {
+            throw std::invalid_argument("a gradient needs at least one stop");
+        }
+
+        std::vector<double> positions;
+        for (const GradientStop &stop : stops)
+        {
+            positions.push_back(positions.empty() ? stop.position : std::max(stop.position, positions.back()));
+        }
+
+        first_ = stops[0].color;
+        last_ = stops[stops.size() - 1].color;
+        firstPosition_ = positions.front();
+        lastPosition_ = positions.back();
+
+        for (std::size_t i = 0; i + 1 < stops.size(); ++i)
+        {
+            std::array<double, 3> from = toSpace(stops[i].color, space);
+            std::array<double, 3> to = toSpace(stops[i + 1].color, space);
+            if (space == GradientSpace::Oklch)
+            {
+                fixHues(from[2], to[2], hueInterpolation);
+            }
+            segments_.push_back(Segment{positions[i], positions[i + 1], {from[0], from[1], from[2]}, {to[0], to[1], to[2]}});
+        }
+    }
+
+    void Gradient::interpolate(const double *positions, std::size_t count, Oklab *output) const
+    {
+        assert(count <= BATCH_BLOCK_SIZE);
+
+        // Oklch samples, converted together once interpolated
+        BlockPlanes oklch;
+        std::size_t oklchSamples[BATCH_BLOCK_SIZE];
+        std::size_t oklchCount = 0;
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            double position = positions[i];
+            if (!(position > firstPosition_))
+            {
+                output[i] = first_;
+                continue;
+            }
+            if (position >= lastPosition_)
+            {
+                output[i] = last_;
+                continue;
+            }
+
+            // The last segment starting at or before the position: past the hard stops there
+            auto segment = std::upper_bound(segments_.begin(), segments_.end(), position,
+                                            [](double value, const Segment &candidate) { return value < candidate.start; }) - 1;
+            double t = (position - segment->start) / (segment->end - segment->start);
+            double values[3];
+            for (int c = 0; c < 3; ++c)
+            {
+                values[c] = segment->from[c] * (1 - t) + segment->to[c] * t;
+            }
+            if (space_ == GradientSpace::Oklab)
+            {
+                output[i] = Oklab{values[0], values[1], values[2]};
+                continue;
+            }
+
+            std::size_t sample = oklchCount++;
+            oklchSamples[sample] = i;
+            for (int c = 0; c < 3; ++c)
+            {
+                oklch.channels[c][sample] = values[c];
+            }
+        }
+
+        if (oklchCount == 0)
+        {
+            return;
+        }
+        for (int c = 0; c < 3; ++c)
+        {
+            std::fill(oklch.channels[c] + oklchCount, oklch.channels[c] + paddedCount(oklchCount), 0.0);
+        }
+        oklchToOklabBlock(oklch, oklchCount);
+        for (std::size_t sample = 0; sample < oklchCount; ++sample)
+        {
+            output[oklchSamples[sample]] = Oklab{oklch.channels[0][sample], oklch.channels[1][sample], oklch.channels[2][sample]};
+        }
+    }
+
+    Oklab Gradient::sample(double position) const
+    {
+        Oklab color;
+        interpolate(&position, 1, &color);
+        return color;
+    }
+
+    template <typename ColorType, typename PositionAt>
+    void Gradient::render(Span<ColorType> output, GamutMapping mapping, PositionAt positionAt) const
+    {
+        forEachBlock(output.size(), [&](std::size_t offset, std::size_t count)
+        {
+            double positions[BATCH_BLOCK_SIZE];
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                positions[i] = positionAt(offset + i);
+            }
+
+            if constexpr (std::is_same_v<ColorType, Oklab>)
+            {
+                interpolate(positions, count, output.data() + offset);
+            }
+            else
+            {
+                std::array<Oklab, BATCH_BLOCK_SIZE> oklab;
+                interpolate(positions, count, oklab.data());
+                convertOklab(Span<const Oklab>(oklab.data(), count), output.subspan(offset, count), mapping);
+            }
+        });
+    }
+
+    template <typename ColorType>
+    void Gradient::sample(Span<const double> positions, Span<ColorType> output, GamutMapping mapping) const
+    {
+        batchSize(positions, output);
+        render(output, mapping, [&](std::size_t index) { return positions[index]; });
+    }
+
+    template <typename ColorType>
+    void Gradient::fillRamp(Span<ColorType> output, GamutMapping mapping) const
+    {
+        const double last = output.size() > 1 ? static_cast<double>(output.size() - 1) : 1.0;
+        render(output, mapping, [&](std::size_t index) { return static_cast<double>(index) / last; });
+    }
+
+    template <typename ColorType>
+    void Gradient::fillLinear(ImageView<ColorType> image, const GradientLine &line, GamutMapping mapping) const
+    {
+        const double dx = line.endX - line.startX;
+        const double dy = line.endY - line.startY;
+        const double lengthSquared = dx * dx + dy * dy;
+
+        for (std::size_t y = 0; y < image.height; ++y)
+        {
+            // Pixel centers projected on the line
+            const double offsetY = (y + 0.5 - line.startY) * dy;
+            render(Span<ColorType>(image.row(y), image.width), mapping, [&](std::size_t x)
+            {
+                return lengthSquared > 0 ? ((x + 0.5 - line.startX) * dx + offsetY) / lengthSquared : 0.0;
+            });
+        }
+    }
+
+    template void Gradient::sample(Span<const double>, Span<Oklab>, GamutMapping) const;
+    template void Gradient::sample(Span<const double>, Span<RGB>, GamutMapping) const;
+    template void Gradient::sample(Span<const double>, Span<P3>, GamutMapping) const;
+    template void Gradient::sample(Span<const double>, Span<GammaSRGB>, GamutMapping) const;
+    template void Gradient::sample(Span<const double>, Span<GammaP3>, GamutMapping) const;
+
+    template void Gradient::fillRamp(Span<Oklab>, GamutMapping) const;
+    template void Gradient::fillRamp(Span<RGB>, GamutMapping) const;
+    template void Gradient::fillRamp(Span<P3>, GamutMapping) const;
+    template void Gradient::fillRamp(Span<GammaSRGB>, GamutMapping) const;
+    template void Gradient::fillRamp(Span<GammaP3>, GamutMapping) const;
+
+    template void Gradient::fillLinear(ImageView<Oklab>, const GradientLine &, GamutMapping) const;
+    template void Gradient::fillLinear(ImageView<RGB>, const GradientLine &, GamutMapping) const;
+    template void Gradient::fillLinear(ImageView<P3>, const GradientLine &, GamutMapping) const;
+    template void Gradient::fillLinear(ImageView<GammaSRGB>, const GradientLine &, GamutMapping) const;
+    template void Gradient::fillLinear(ImageView<GammaP3>, const GradientLine &, GamutMapping) const;
+} // namespace oklab
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @file HalfFloat.h
+ * @brief Provides conversions between IEEE 754 half-precision values and floats.
+ *
+ * Portable integer implementations: subnormals, infinities and NaNs are preserved, and
+ * `floatToHalf` rounds to nearest, ties to even, as the F16C instructions do.
+ */
+
+namespace oklab
+{
+    inline float halfToFloat(std::uint16_t half)
+    {
+        std::uint32_t sign = static_cast<std::uint32_t>(half & 0x8000u) << 16;
+        std::uint32_t exponent = (half >> 10) & 0x1fu;
+        std::uint32_t mantissa = half & 0x3ffu;
+
+        std::uint32_t bits;
+        if (exponent == 0x1f)
+        {
+            bits = sign | 0x7f800000u | (mantissa << 13);
+        }
+        else if (exponent != 0)
+        {
+            bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+        }
+        else if (mantissa == 0)
+        {
+            bits = sign;
+        }
+        else
+        {
+            // Subnormal: normalize the mantissa
+            exponent = 113;
+            while ((mantissa & 0x400u) == 0)
+            {
+                mantissa <<= 1;
+                --exponent;
+            }
+            bits = sign | (exponent << 23) | ((mantissa & 0x3ffu) << 13);
+        }
+
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    inline std::uint16_t floatToHalf(float value)
+    {
+        std::uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        std::uint16_t sign = static_cast<std::uint16_t>((bits >> 16) & 0x8000u);
+        std::uint32_t magnitude = bits & 0x7fffffffu;
+
+        if (magnitude >= 0x7f800000u)
+        {
+            // Infinity, or NaN kept quiet
+            return sign | 0x7c00u | (magnitude > 0x7f800000u ? 0x200u : 0);
+        }
+        if (magnitude >= 0x477ff000u)
+        {
+            // Rounds above the largest half, 65504
+            return sign | 0x7c00u;
+        }
+        if (magnitude < 0x38800000u)
+        {
+            // Subnormal half, or zero: align the mantissa on 2^-24 and round to nearest even
+            if (magnitude < 0x33000000u)
+            {
+                return sign;
+            }
+            std::uint32_t exponent = magnitude >> 23;
+            std::uint32_t mantissa = (magnitude & 0x7fffffu) | 0x800000u;
+            std::uint32_t shift = 126 - exponent;
+            std::uint32_t half = mantissa >> shift;
+            std::uint32_t remainder = mantissa & ((1u << shift) - 1);
+            std::uint32_t halfway = 1u << (shift - 1);
+            if (remainder > halfway || (remainder == halfway && (half & 1u)))
+            {
+                ++half;
+            }
+            return sign | static_cast<std::uint16_t>(half);
+        }
+
+        // Normal half: rebias the exponent, round the 13 dropped bits to nearest even
+        std::uint32_t half = (magnitude - 0x38000000u) >> 13;
+        std::uint32_t remainder = magnitude & 0x1fffu;
+        if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u)))
+        {
+            ++half;
+        }
+        return sign | static_cast<std::uint16_t>(half);
+    }
+} // namespace oklab
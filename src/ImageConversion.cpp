@@ -0,0 +1,49 @@
+#include "ImageConversion.h"
+
+#include <array>
+#include <stdexcept>
+
+#include "ColorBatchConversions.h"
+#include "ImageTiles.h"
+
+namespace oklab
+{
+    namespace
+    {
+        template <typename InputType, typename OutputType, typename ToOklab, typename FromOklab>
+        bool convertImage(ImageView<const InputType> input, ImageView<OutputType> output, const ImageConversionOptions &options,
+                          ToOklab toOklab, FromOklab fromOklab)
+        {
+            if (input.width != output.width || input.height != output.height)
+            {
+                throw std::invalid_argument("input and output images differ in size");
+            }
+            if (input.stride < input.width || output.stride < output.width)
+            {
+                throw std::invalid_argument("image stride below its width");
+            }
+
+            return forEachTileSegment(input.width, input.height, options, [&](std::size_t x, std::size_t y, std::size_t width)
+            {
+                std::array<Oklab, IMAGE_TILE_WIDTH> oklab;
+                Span<Oklab> oklabRow(oklab.data(), width);
+                toOklab(Span<const InputType>(input.row(y) + x, width), oklabRow);
+                fromOklab(Span<const Oklab>(oklabRow), Span<OutputType>(output.row(y) + x, width), options.mapping);
+            });
+        }
+    } // namespace
+
+    bool p3ToRgb(ImageView<const P3> input, ImageView<RGB> output, const ImageConversionOptions &options)
+    {
+        return convertImage(input, output, options,
+                            [](Span<const P3> p3, Span<Oklab> oklab) { p3ToOklab(p3, oklab); },
+                            [](Span<const Oklab> oklab, Span<RGB> rgb, GamutMapping mapping) { oklabToRgb(oklab, rgb, mapping); });
+    }
+
+    bool rgbToP3(ImageView<const RGB> input, ImageView<P3> output, const ImageConversionOptions &options)
+    {
+        return convertImage(input, output, options,
+                            [](Span<const RGB> rgb, Span<Oklab> oklab) { rgbToOklab(rgb, oklab); },
+                            [](Span<const Oklab> oklab, Span<P3> p3, GamutMapping mapping) { oklabToP3(oklab, p3, mapping); });
+    }
+} // namespace oklab
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+
+#include "ImageConversion.h"
+
+namespace oklab
+{
+    /**
+     * @brief Runs `convertSegment(x, y, width)` on the row segments of every tile of an image,
+     * on the pool of `options`, until all are converted or the conversion is cancelled.
+     * @return false if the conversion was cancelled.
+     */
+    template <typename ConvertSegment>
+    bool forEachTileSegment(std::size_t width, std::size_t height, const ImageConversionOptions &options, ConvertSegment convertSegment)
+    {
+        const std::size_t tileColumns = (width + IMAGE_TILE_WIDTH - 1) / IMAGE_TILE_WIDTH;
+        const std::size_t tileRows = (height + IMAGE_TILE_HEIGHT - 1) / IMAGE_TILE_HEIGHT;
+        std::atomic<bool> isCancelled{false};
+
+        ThreadPool &pool = options.pool != nullptr ? *options.pool : ThreadPool::shared();
+
+        // Tiles in row-major order: the range of each thread is a band of the image
+        pool.parallelFor(tileColumns * tileRows, [&](std::size_t tile)
+        {
+            if (options.cancellation != nullptr && options.cancellation->isCancelled())
+            {
+                isCancelled.store(true, std::memory_order_relaxed);
+                return;
+            }
+
+            std::size_t x = tile % tileColumns * IMAGE_TILE_WIDTH;
+            std::size_t y = tile / tileColumns * IMAGE_TILE_HEIGHT;
+            std::size_t segmentWidth = std::min(IMAGE_TILE_WIDTH, width - x);
+            std::size_t endY = std::min(y + IMAGE_TILE_HEIGHT, height);
+            for (; y < endY; ++y)
+            {
+                convertSegment(x, y, segmentWidth);
+            }
+        });
+
+        return !isCancelled.load(std::memory_order_relaxed);
+    }
+} // namespace oklab
@@ -0,0 +1,149 @@
+#include "Lut3D.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "OkLxx.h"
+#include "BatchKernels.h"
+#include "LutInterpolation.h"
+#include "ColorConversionsInternal.h"
+#include "simd/SimdKernels.h"
+
+namespace oklab
+{
+    namespace
+    {
+        template <typename InputType, typename OutputType>
+        struct LutTraits;
+
+        template <>
+        struct LutTraits<GammaP3, GammaSRGB>
+        {
+            static Oklab inputToOklab(const GammaP3 &p3) { return gammaP3ToOklab(p3); }
+            static Oklab outputToOklab(const GammaSRGB &rgb) { return gammaSRGBToOklab(rgb); }
+            static GammaSRGB oklabToOutput(const Oklab &oklab) { return oklabToGammaSRGB(oklab); }
+        };
+
+        template <>
+        struct LutTraits<GammaSRGB, GammaP3>
+        {
+            static Oklab inputToOklab(const GammaSRGB &rgb) { return gammaSRGBToOklab(rgb); }
+            static Oklab outputToOklab(const GammaP3 &p3) { return gammaP3ToOklab(p3); }
+            static GammaP3 oklabToOutput(const Oklab &oklab) { return oklabToGammaP3(oklab); }
+        };
+
+        template <typename InputType, typename OutputType>
+        OutputType convertExactly(const InputType &color)
+        {
+            using Traits = LutTraits<InputType, OutputType>;
+            return Traits::oklabToOutput(Traits::inputToOklab(color));
+        }
+
+        // Checked before the node vector is sized from it
+        std::size_t checkedLutSize(std::size_t size)
+        {
+            if (size < 2)
+            {
+                throw std::invalid_argument("a 3D LUT needs at least 2 nodes per axis");
+            }
+            return size;
+        }
+
+        void lookupBlocks(const LutGrid &grid, LutInterpolation interpolation, StridedChannels<const double> input,
+                          StridedChannels<double> output, std::size_t size)
+        {
+            const KernelTable &table = kernels();
+            forEachBlock(size, [&](std::size_t offset, std::size_t count)
+            {
+                BlockPlanes colors;
+                BlockPlanes result;
+                loadBlock(input, offset, count, colors);
+                table.lut3D(grid, interpolation, colors, result, count);
+                storeBlock(result, count, output, offset);
+            });
+        }
+    } // namespace
+
+    template <typename InputType, typename OutputType>
+    Lut3D<InputType, OutputType>::Lut3D(std::size_t size) : size_(checkedLutSize(size)), nodes_(3 * size * size * size)
+    {
+        const double step = 1.0 / static_cast<double>(size - 1);
+        float *node = nodes_.data();
+        for (std::size_t x = 0; x < size; ++x)
+        {
+            for (std::size_t y = 0; y < size; ++y)
+            {
+                for (std::size_t z = 0; z < size; ++z)
+                {
+                    InputType input{static_cast<double>(x) * step, static_cast<double>(y) * step, static_cast<double>(z) * step};
+                    OutputType output = convertExactly<InputType, OutputType>(input);
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        *node++ = static_cast<float>(output[c]);
+                    }
+                }
+            }
+        }
+    }
+
+    template <typename InputType, typename OutputType>
+    OutputType Lut3D<InputType, OutputType>::lookup(const InputType &color, LutInterpolation interpolation) const
+    {
+        LutGrid grid{nodes_.data(), static_cast<std::int64_t>(size_)};
+        double result[3];
+        lutInterpolation::interpolate(grid, interpolation, color[0], color[1], color[2], result);
+        return OutputType{result[0], result[1], result[2]};
+    }
+
+    template <typename InputType, typename OutputType>
+    void Lut3D<InputType, OutputType>::lookup(Span<const InputType> input, Span<OutputType> output, LutInterpolation interpolation) const
+    {
+        std::size_t size = batchSize(input, output);
+        LutGrid grid{nodes_.data(), static_cast<std::int64_t>(size_)};
+        lookupBlocks(grid, interpolation, stridedChannels(input), stridedChannels(output), size);
+    }
+
+    template <typename InputType, typename OutputType>
+    void Lut3D<InputType, OutputType>::lookup(Planar<const double> input, Planar<double> output, LutInterpolation interpolation) const
+    {
+        std::size_t size = batchSize(input, output);
+        LutGrid grid{nodes_.data(), static_cast<std::int64_t>(size_)};
+        lookupBlocks(grid, interpolation, stridedChannels(input), stridedChannels(output), size);
+    }
+
+    template <typename InputType, typename OutputType>
+    LutError Lut3D<InputType, OutputType>::measureError(std::size_t samplesPerAxis, LutInterpolation interpolation) const
+    {
+        using Traits = LutTraits<InputType, OutputType>;
+
+        if (samplesPerAxis == 0)
+        {
+            throw std::invalid_argument("the error is measured on at least 1 sample per axis");
+        }
+
+        LutError error{0.0, 0.0};
+        const double step = 1.0 / static_cast<double>(samplesPerAxis);
+        for (std::size_t x = 0; x < samplesPerAxis; ++x)
+        {
+            for (std::size_t y = 0; y < samplesPerAxis; ++y)
+            {
+                for (std::size_t z = 0; z < samplesPerAxis; ++z)
+                {
+                    InputType input{(static_cast<double>(x) + 0.5) * step, (static_cast<double>(y) + 0.5) * step, (static_cast<double>(z) + 0.5) * step};
+                    Oklab exact = Traits::outputToOklab(convertExactly<InputType, OutputType>(input));
+                    Oklab approximated = Traits::outputToOklab(lookup(input, interpolation));
+
+                    double distance = deltaE(exact, approximated);
+                    error.maxDeltaE = std::max(error.maxDeltaE, distance);
+                    error.meanDeltaE += distance;
+                }
+            }
+        }
+
+        error.meanDeltaE /= static_cast<double>(samplesPerAxis * samplesPerAxis * samplesPerAxis);
+        return error;
+    }
+
+    template class Lut3D<GammaP3, GammaSRGB>;
+    template class Lut3D<GammaSRGB, GammaP3>;
+} // namespace oklab
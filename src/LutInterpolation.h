@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "TransferApprox.h"
+#include "simd/SimdKernels.h"
+
+/**
+ * @file LutInterpolation.h
+ * @brief Provides the branchless 3D LUT interpolation shared by `Lut3D::lookup` and the kernels.
+ *
+ * Each channel is scaled to the lattice and split into a cell index (rounded down with the
+ * rounding-magic trick of TransferApprox.h) and a position in the cell. Tetrahedral
+ * interpolation sorts the three positions with selects: the enclosing tetrahedron goes from the
+ * cell origin along the axis of the largest position, then the middle one, to the opposite
+ * corner. Node values are gathered lane by lane.
+ *
+ * Generic over `Value`, either `double` or a GCC/Clang vector of doubles, with internal linkage
+ * for the same reasons as TransferApprox.h.
+ */
+
+namespace oklab
+{
+    namespace
+    {
+        namespace lutInterpolation
+        {
+            using transferApprox::bitCast;
+            using transferApprox::IntegerOf;
+
+            template <typename Value, typename Integer>
+            inline Value gather(const float *nodes, const Integer &index)
+            {
+                if constexpr (std::is_arithmetic<Value>::value)
+                {
+                    return nodes[index];
+                }
+                else
+                {
+                    Value result;
+                    for (std::size_t l = 0; l < sizeof(Value) / sizeof(double); ++l)
+                    {
+                        result[l] = nodes[index[l]];
+                    }
+                    return result;
+                }
+            }
+
+            template <typename Value>
+            inline Value minimum(Value a, Value b)
+            {
+                return (b < a) ? b : a;
+            }
+
+            template <typename Value>
+            inline Value maximum(Value a, Value b)
+            {
+                return (a < b) ? b : a;
+            }
+
+            /**
+             * @brief Splits a channel into a cell index in [0, size - 2] and a position in the cell.
+             */
+            template <typename Value>
+            inline void locate(Value value, std::int64_t size, typename IntegerOf<Value>::type &cell, Value &position)
+            {
+                const double lastCell = static_cast<double>(size - 2);
+                Value clamped = (value < 0.0) ? (Value{} + 0.0) : ((1.0 < value) ? (Value{} + 1.0) : value);
+                Value scaled = clamped * static_cast<double>(size - 1);
+
+                // Nearest integer of scaled - 1/2: the floor, or one less on exact nodes
+                Value index = ((scaled - 0.5) + transferApprox::ROUNDING_MAGIC) - transferApprox::ROUNDING_MAGIC;
+                index = (lastCell < index) ? (Value{} + lastCell) : index;
+
+                cell = bitCast<typename IntegerOf<Value>::type>(index + transferApprox::ROUNDING_MAGIC) - transferApprox::ROUNDING_MAGIC_BITS;
+                position = scaled - index;
+            }
+
+            /**
+             * @brief Interpolates the LUT at gamma-encoded color `{x, y, z}`.
+             */
+            template <typename Value>
+            inline void interpolate(const LutGrid &grid, LutInterpolation interpolation, Value x, Value y, Value z, Value output[3])
+            {
+                using Integer = typename IntegerOf<Value>::type;
+
+                Integer cellX, cellY, cellZ;
+                Value positionX, positionY, positionZ;
+                locate(x, grid.size, cellX, positionX);
+                locate(y, grid.size, cellY, positionY);
+                locate(z, grid.size, cellZ, positionZ);
+
+                const std::int64_t strideZ = 3;
+                const std::int64_t strideY = 3 * grid.size;
+                const std::int64_t strideX = 3 * grid.size * grid.size;
+                const std::int64_t strideAll = strideX + strideY + strideZ;
+                Integer origin = cellX * strideX + cellY * strideY + cellZ * strideZ;
+
+                if (interpolation == LutInterpolation::Trilinear)
+                {
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        Integer corner = origin + c;
+                        Value c000 = gather<Value>(grid.nodes, corner);
+                        Value c001 = gather<Value>(grid.nodes, corner + strideZ);
+                        Value c010 = gather<Value>(grid.nodes, corner + strideY);
+                        Value c011 = gather<Value>(grid.nodes, corner + (strideY + strideZ));
+                        Value c100 = gather<Value>(grid.nodes, corner + strideX);
+                        Value c101 = gather<Value>(grid.nodes, corner + (strideX + strideZ));
+                        Value c110 = gather<Value>(grid.nodes, corner + (strideX + strideY));
+                        Value c111 = gather<Value>(grid.nodes, corner + strideAll);
+
+                        Value c00 = c000 + positionZ * (c001 - c000);
+                        Value c01 = c010 + positionZ * (c011 - c010);
+                        Value c10 = c100 + positionZ * (c101 - c100);
+                        Value c11 = c110 + positionZ * (c111 - c110);
+                        Value c0 = c00 + positionY * (c01 - c00);
+                        Value c1 = c10 + positionY * (c11 - c10);
+                        output[c] = c0 + positionX * (c1 - c0);
+                    }
+                    return;
+                }
+
+                // Ties go to x, then y, for the largest position and to z, then y, for the smallest,
+                // so the two axes always differ.
+                auto xIsLargest = (positionX >= positionY) & (positionX >= positionZ);
+                auto yIsLargest = positionY >= positionZ;
+                auto zIsSmallest = (positionZ <= positionY) & (positionZ <= positionX);
+                auto yIsSmallest = positionY <= positionX;
+
+                Value largest = xIsLargest ? positionX : (yIsLargest ? positionY : positionZ);
+                Value smallest = zIsSmallest ? positionZ : (yIsSmallest ? positionY : positionX);
+                Value middle = maximum(minimum(positionX, positionY), minimum(maximum(positionX, positionY), positionZ));
+
+                Integer largestStride = xIsLargest ? (Integer{} + strideX) : (yIsLargest ? (Integer{} + strideY) : (Integer{} + strideZ));
+                Integer smallestStride = zIsSmallest ? (Integer{} + strideZ) : (yIsSmallest ? (Integer{} + strideY) : (Integer{} + strideX));
+
+                for (int c = 0; c < 3; ++c)
+                {
+                    Integer corner = origin + c;
+                    Value v0 = gather<Value>(grid.nodes, corner);
+                    Value v1 = gather<Value>(grid.nodes, corner + largestStride);
+                    Value v2 = gather<Value>(grid.nodes, corner + (strideAll - smallestStride));
+                    Value v3 = gather<Value>(grid.nodes, corner + strideAll);
+
+                    output[c] = v0 + largest * (v1 - v0) + middle * (v2 - v1) + smallest * (v3 - v2);
+                }
+            }
+        } // namespace lutInterpolation
+    } // namespace
+} // namespace oklab
@@ -2,12 +2,19 @@
 
 #include <cmath>
 
+#include "CbrtApprox.h"
+#include "ConversionFormulas.h"
+
 namespace oklab
 {
     double cbrt(double value)
     {
-        double sign = value < 0 ? -1.0 : 1.0;
-        return sign * std::cbrt(std::abs(value));
+        return cbrtApprox::cbrt(value);
+    }
+
+    float cbrt(float value)
+    {
+        return static_cast<float>(cbrtApprox::cbrt(static_cast<double>(value)));
     }
 
     double constrainAngle(double angle)
@@ -15,17 +22,19 @@ namespace oklab
         return std::fmod((std::fmod(angle, 360.0) + 360.0), 360.0);
     }
 
+    float constrainAngle(float angle)
+    {
+        return std::fmod((std::fmod(angle, 360.0f) + 360.0f), 360.0f);
+    }
+
     std::array<double, 3> multiplyMatrix(const double matrix[3][3], const std::array<double, 3> &vector)
     {
-        std::array<double, 3> result = {0.0, 0.0, 0.0};
-        for (int i = 0; i < 3; ++i)
-        {
-            for (int j = 0; j < 3; ++j)
-            {
-                result[i] += matrix[i][j] * vector[j];
-            }
-        }
-        return result;
+        return formulas::multiplyMatrix(matrix, vector);
+    }
+
+    std::array<float, 3> multiplyMatrix(const double matrix[3][3], const std::array<float, 3> &vector)
+    {
+        return formulas::multiplyMatrix(matrix, vector);
     }
 
 } // namespace oklab
\ No newline at end of file
@@ -14,12 +14,19 @@ namespace oklab
      * @brief Computes the cube root of a doubleing point number, retaining the sign.
      *
      * This function computes the cube root of a doubleing point number, preserving the sign of the input value.
+     * It uses a branchless approximation (see CbrtApprox.h) within 1 ulp of the exact result for
+     * normal inputs, instead of the slower `std::cbrt`.
      *
      * @param value The input value.
      * @return The cube root of the input value.
      */
     double cbrt(double value);
 
+    /**
+     * @brief Single-precision variant of `cbrt`, rounded from the double result.
+     */
+    float cbrt(float value);
+
     /**
      * @brief Constrains an angle to the range [0, 360).
      *
@@ -30,6 +37,11 @@ namespace oklab
      */
     double constrainAngle(double angle);
 
+    /**
+     * @brief Single-precision variant of `constrainAngle`.
+     */
+    float constrainAngle(float angle);
+
     /**
      * @brief Multiplies a 3x3 matrix by a 3D vector.
      *
@@ -39,4 +51,35 @@ namespace oklab
      * @param vector The 3D vector to multiply.
      */
     std::array<double, 3> multiplyMatrix(const double matrix[3][3], const std::array<double, 3> &vector);
+
+    /**
+     * @brief Single-precision variant of `multiplyMatrix`.
+     *
+     * The matrix coefficients are rounded to float, then the product is computed in float.
+     */
+    std::array<float, 3> multiplyMatrix(const double matrix[3][3], const std::array<float, 3> &vector);
+
+    /**
+     * @brief The `Math` policy of ConversionFormulas.h used by the library, trigonometry aside
+     * (OkLxx.cpp adds the approximations of TrigApprox.h).
+     */
+    struct LibraryMath
+    {
+        template <typename Scalar>
+        static Scalar sqrt(Scalar value)
+        {
+            return std::sqrt(value);
+        }
+
+        template <typename Scalar>
+        static Scalar cbrt(Scalar value)
+        {
+            return oklab::cbrt(value);
+        }
+
+        static double pow(double base, double exponent)
+        {
+            return std::pow(base, exponent);
+        }
+    };
 } // namespace oklab
\ No newline at end of file
@@ -2,92 +2,139 @@
 #include <cmath>
 
 #include "MathUtils.h"
+#include "BatchKernels.h"
+#include "TrigApprox.h"
+#include "simd/SimdKernels.h"
+#include "ColorMatrices.h"
 
 /**
  * @file ColorUtils.h
  * @brief Provides utility functions for color conversions between linear and gamma-encoded values.
  */
 
-const double PI = M_PI;
-
-const double LMSG_TO_OKLAB[3][3] = {
-    {0.2104542683093140, 0.7936177747023054, -0.0040720430116193},
-    {1.9779985324311684, -2.4285922420485799, 0.4505937096174110},
-    {0.0259040424655478, 0.7827717124575296, -0.8086757549230774}};
-
-const double OKLAB_TO_LMSG[3][3] = {
-    {1.0000000000000000, 0.3963377773761749, 0.2158037573099136},
-    {1.0000000000000000, -0.1055613458156586, -0.0638541728258133},
-    {1.0000000000000000, -0.0894841775298119, -1.2914855480194092}};
-
 namespace oklab
 {
-    Oklab oklchToOklab(const Oklch &oklch)
+    namespace
     {
-        if (std::isnan(oklch[2]))
+        // Sine, cosine and arc tangent from the polynomials of TrigApprox.h
+        struct OklchMath : LibraryMath
         {
-            return Oklab{oklch[0], 0, 0};
-        }
-        else
-        {
-            double angle = constrainAngle(oklch[2]) * PI / 180.0;
+            static void sinCosDegrees(double degrees, double &sine, double &cosine)
+            {
+                trigApprox::sinCosDegrees(degrees, sine, cosine);
+            }
 
-            return Oklab{
-                oklch[0],
-                std::cos(angle) * oklch[1],
-                std::sin(angle) * oklch[1]};
-        }
+            static double hueDegrees(double a, double b)
+            {
+                return trigApprox::hueDegrees(a, b);
+            }
+        };
+    } // namespace
+
+    Oklab oklchToOklab(const Oklch &oklch)
+    {
+        return formulas::oklchToOklab<OklchMath>(oklch);
+    }
+
+    Oklabf oklchToOklab(const Oklchf &oklch)
+    {
+        return formulas::oklchToOklab<OklchMath>(oklch);
     }
 
     Oklch oklabToOklch(const Oklab &oklab)
     {
-        double epsilon = 0.0002;
-        if (std::abs(oklab[1]) < epsilon && std::abs(oklab[2]) < epsilon)
-        {
-            return Oklch{oklab[0], 0, NAN};
-        }
-        else
-        {
-            return Oklch{
-                oklab[0],
-                std::sqrt(oklab[1] * oklab[1] + oklab[2] * oklab[2]),
-                constrainAngle(std::atan2(oklab[2], oklab[1]) * 180.0 / PI)};
-        }
+        return formulas::oklabToOklch<OklchMath>(oklab);
+    }
+
+    Oklchf oklabToOklch(const Oklabf &oklab)
+    {
+        return formulas::oklabToOklch<OklchMath>(oklab);
+    }
+
+    PolarOklab oklabToPolar(const Oklab &oklab)
+    {
+        return formulas::oklabToPolar<OklchMath>(oklab);
+    }
+
+    PolarOklabf oklabToPolar(const Oklabf &oklab)
+    {
+        return formulas::oklabToPolar<OklchMath>(oklab);
+    }
+
+    PolarOklab oklchToPolar(const Oklch &oklch)
+    {
+        return formulas::oklchToPolar<OklchMath>(oklch);
+    }
+
+    PolarOklabf oklchToPolar(const Oklchf &oklch)
+    {
+        return formulas::oklchToPolar<OklchMath>(oklch);
+    }
+
+    Oklch polarToOklch(const PolarOklab &polar)
+    {
+        return formulas::polarToOklch<OklchMath>(polar);
+    }
+
+    Oklchf polarToOklch(const PolarOklabf &polar)
+    {
+        return formulas::polarToOklch<OklchMath>(polar);
     }
 
     Oklab lmsToOklab(const LMS &lms)
     {
-        std::array<double, 3> lms_g = {cbrt(lms[0]), cbrt(lms[1]), cbrt(lms[2])};
-        Oklab oklab = multiplyMatrix(LMSG_TO_OKLAB, lms_g);
-        return oklab;
+        return formulas::lmsToOklab<OklchMath>(lms);
+    }
+
+    Oklabf lmsToOklab(const LMSf &lms)
+    {
+        return formulas::lmsToOklab<OklchMath>(lms);
     }
 
     LMS oklabToLms(const Oklab &oklab)
     {
-        std::array<double, 3> lms_g = multiplyMatrix(OKLAB_TO_LMSG, oklab);
-        LMS lms = {lms_g[0] * lms_g[0] * lms_g[0], lms_g[1] * lms_g[1] * lms_g[1], lms_g[2] * lms_g[2] * lms_g[2]};
-        return lms;
+        return formulas::oklabToLms(oklab);
     }
 
-    double deltaE(const Oklab &oklab_1, const Oklab &oklab_2)
+    LMSf oklabToLms(const Oklabf &oklab)
+    {
+        return formulas::oklabToLms(oklab);
+    }
+
+    void lmsToOklabBlock(BlockPlanes &lms, BlockPlanes &oklab, std::size_t count)
     {
-        double l1 = oklab_1[0];
-        double a1 = oklab_1[1];
-        double b1 = oklab_1[2];
+        const KernelTable &table = kernels();
+        for (int c = 0; c < 3; ++c)
+        {
+            table.cbrt(lms.channels[c], count);
+        }
 
-        double l2 = oklab_2[0];
-        double a2 = oklab_2[1];
-        double b2 = oklab_2[2];
+        multiplyMatrixBlock(LMSG_TO_OKLAB, lms, oklab, count);
+    }
 
-        double deltaL = l1 - l2;
-        // TODO: 2 is debated here: https://github.com/w3c/csswg-drafts/pull/10063
-        // However, reference implementation use 1 so we do too.
-        const double FACTOR = 1;
-        double deltaA = FACTOR * (a1 - a2);
-        double deltaB = FACTOR * (b1 - b2);
+    void oklabToLmsBlock(const BlockPlanes &oklab, BlockPlanes &lms, std::size_t count)
+    {
+        multiplyMatrixBlock(OKLAB_TO_LMSG, oklab, lms, count);
 
-        double deltaE = std::sqrt(deltaL * deltaL + deltaA * deltaA + deltaB * deltaB);
+        const KernelTable &table = kernels();
+        for (int c = 0; c < 3; ++c)
+        {
+            table.cube(lms.channels[c], count);
+        }
+    }
 
-        return deltaE;
+    void oklchToOklabBlock(BlockPlanes &block, std::size_t count)
+    {
+        kernels().oklchToOklab(block, count);
+    }
+
+    double deltaE(const Oklab &oklab_1, const Oklab &oklab_2)
+    {
+        return formulas::deltaE<OklchMath>(oklab_1, oklab_2);
+    }
+
+    float deltaE(const Oklabf &oklab_1, const Oklabf &oklab_2)
+    {
+        return formulas::deltaE<OklchMath>(oklab_1, oklab_2);
     }
-} // namespace oklab
\ No newline at end of file
+} // namespace oklab
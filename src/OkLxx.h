@@ -1,9 +1,41 @@
 #pragma once
 
 #include "ColorTypes.h"
+#include "ConversionFormulas.h"
+
+/**
+ * @file OkLxx.h
+ * @brief Provides conversions between LMS, Oklab and Oklch.
+ *
+ * Each function has a double and a single-precision (float) overload, running the formulas of
+ * ConversionFormulas.h (`BasicPolarOklab` is defined there). The Oklch conversions use the
+ * polynomial sine, cosine and arc tangent of TrigApprox.h instead of libm; single-precision
+ * colors are converted through double.
+ */
 
 namespace oklab
 {
+    /**
+     * @brief Converts a color from Oklab to its polar form: the chroma and direction of (a, b).
+     *
+     * Same chroma, and same achromatic colors, as `oklabToOklch`; the direction is (a, b) divided
+     * by the chroma, without trigonometry.
+     */
+    PolarOklab oklabToPolar(const Oklab &color);
+    PolarOklabf oklabToPolar(const Oklabf &color);
+
+    /**
+     * @brief Converts a color from Oklch to its polar form; a NaN hue gives an achromatic color.
+     */
+    PolarOklab oklchToPolar(const Oklch &color);
+    PolarOklabf oklchToPolar(const Oklchf &color);
+
+    /**
+     * @brief Converts a color from its polar form to Oklch, the hue in [0, 360) or NaN when achromatic.
+     */
+    Oklch polarToOklch(const PolarOklab &color);
+    Oklchf polarToOklch(const PolarOklabf &color);
+
     /**
      * @brief Converts a color from Oklch to Oklab color space.
      *
@@ -14,6 +46,7 @@ namespace oklab
      * @return The corresponding color in Oklab space (L, a, b).
      */
     Oklab oklchToOklab(const Oklch &color);
+    Oklabf oklchToOklab(const Oklchf &color);
 
     /**
      * @brief Converts a color from Oklab to Oklch color space.
@@ -25,6 +58,7 @@ namespace oklab
      * @return The corresponding color in Oklch space (L, C, H).
      */
     Oklch oklabToOklch(const Oklab &color);
+    Oklchf oklabToOklch(const Oklabf &color);
 
     /**
      * @brief Converts a color from LMS to Oklab color space.
@@ -35,6 +69,7 @@ namespace oklab
      * @return The corresponding color in Oklab space.
      */
     Oklab lmsToOklab(const LMS &lms);
+    Oklabf lmsToOklab(const LMSf &lms);
 
     /**
      * @brief Converts a color from Oklab to LMS color space.
@@ -43,6 +78,7 @@ namespace oklab
      * @return The corresponding color in LMS space.
      */
     LMS oklabToLms(const Oklab &Oklab);
+    LMSf oklabToLms(const Oklabf &Oklab);
 
     /**
      * @brief Calculates the perceptual difference between two colors in Oklab space.
@@ -55,4 +91,5 @@ namespace oklab
      * @return The perceptual difference between the two colors.
      */
     double deltaE(const Oklab &color1, const Oklab &color2);
+    float deltaE(const Oklabf &color1, const Oklabf &color2);
 }
\ No newline at end of file
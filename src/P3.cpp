@@ -1,4 +1,6 @@
 #include "ColorConversions.h"
+#include "ColorBatchConversions.h"
+#include "ColorConversionsInternal.h"
 
 #include <cmath>
 #include <algorithm>
@@ -6,18 +8,10 @@
 #include "OkLxx.h"
 #include "MathUtils.h"
 #include "ColorUtils.h"
-#include "gamutMapping/CSS4.h"
-
-// Define the transformation matrices as constants
-const double P3_TO_LMS[3][3] = {
-    {0.4813798527499544, 0.4621183710113182, 0.0565017762387275},
-    {0.2288319418112447, 0.6532168193835679, 0.1179512388051878},
-    {0.0839457523229932, 0.2241652709775665, 0.6918889766994405}};
-
-const double LMS_TO_P3[3][3] = {
-    {3.1277689713618742, -2.2571357625916386, 0.1293667912297653},
-    {-1.0910090184377974, 2.4133317103069212, -0.3223226918691247},
-    {-0.0260108019385704, -0.5080413317041669, 1.5340521336427371}};
+#include "TransferTables.h"
+#include "gamutMapping/GamutMappingPolicy.h"
+#include "BatchKernels.h"
+#include "ColorMatrices.h"
 
 namespace oklab
 {
@@ -33,58 +27,112 @@ namespace oklab
         return oklabToP3(oklab);
     }
 
+    template <>
+    Oklch convertToOklch<P3>(const P3 &p3)
+    {
+        return oklabToOklch(convertToOklab(p3));
+    }
+
+    template <>
+    P3 convertFromOklch<P3>(const Oklch &oklch)
+    {
+        return convertFromOklab<P3>(oklchToOklab(oklch));
+    }
+
+    namespace
+    {
+        template <typename Scalar>
+        BasicLinearP3<Scalar> clipToP3Gamut(const BasicLinearP3<Scalar> &linearP3)
+        {
+            return BasicLinearP3<Scalar>{
+                std::clamp(linearP3[0], Scalar{0}, Scalar{1}),
+                std::clamp(linearP3[1], Scalar{0}, Scalar{1}),
+                std::clamp(linearP3[2], Scalar{0}, Scalar{1})};
+        }
+
+        template <typename Scalar>
+        bool isInP3Gamut(const BasicLinearP3<Scalar> &linearP3)
+        {
+            return linearP3[0] >= 0 && linearP3[0] <= 1 &&
+                   linearP3[1] >= 0 && linearP3[1] <= 1 &&
+                   linearP3[2] >= 0 && linearP3[2] <= 1;
+        }
+    } // namespace
+
     template <>
     LinearP3 clipToGamut<LinearP3>(const LinearP3 &linearP3)
     {
-        return LinearP3{
-            std::clamp(linearP3[0], 0.0, 1.0),
-            std::clamp(linearP3[1], 0.0, 1.0),
-            std::clamp(linearP3[2], 0.0, 1.0)};
-    };
+        return clipToP3Gamut(linearP3);
+    }
+
+    template <>
+    LinearP3f clipToGamut<LinearP3f>(const LinearP3f &linearP3)
+    {
+        return clipToP3Gamut(linearP3);
+    }
 
     LinearP3 p3ToLinearP3(const P3 &p3)
     {
+        const TransferTables8Bit &tables = transferTables8Bit();
         return LinearP3{
-            gammaToLinear(p3[0] / 255.0),
-            gammaToLinear(p3[1] / 255.0),
-            gammaToLinear(p3[2] / 255.0)};
+            gammaToLinear8Bit(tables, p3[0]),
+            gammaToLinear8Bit(tables, p3[1]),
+            gammaToLinear8Bit(tables, p3[2])};
     }
 
-    P3 linearP3ToP3(const LinearP3 &linearP3)
+    template <typename Scalar>
+    P3 linearP3ToP3(const BasicLinearP3<Scalar> &linearP3)
     {
+        const TransferTables8Bit &tables = transferTables8Bit();
         return P3{
-            static_cast<int>(std::round(linearToGamma(linearP3[0]) * 255.0)),
-            static_cast<int>(std::round(linearToGamma(linearP3[1]) * 255.0)),
-            static_cast<int>(std::round(linearToGamma(linearP3[2]) * 255.0))};
+            linearToGamma8Bit(tables, linearP3[0]),
+            linearToGamma8Bit(tables, linearP3[1]),
+            linearToGamma8Bit(tables, linearP3[2])};
     }
 
-    Oklab linearP3ToOklab(const LinearP3 &linearP3)
+    template <typename Scalar>
+    BasicOklab<Scalar> linearP3ToOklab(const BasicLinearP3<Scalar> &linearP3)
     {
-        LMS lms = multiplyMatrix(P3_TO_LMS, linearP3);
-        Oklab oklab = lmsToOklab(lms);
+        BasicLMS<Scalar> lms = multiplyMatrix(P3_TO_LMS, linearP3);
+        BasicOklab<Scalar> oklab = lmsToOklab(lms);
         return oklab;
     }
 
+    template <typename Scalar>
+    BasicOklab<Scalar> p3ToOklab(const P3 &p3)
+    {
+        const TransferTables8Bit &tables = transferTables8Bit();
+        return linearP3ToOklab<Scalar>({static_cast<Scalar>(gammaToLinear8Bit(tables, p3[0])),
+                                   static_cast<Scalar>(gammaToLinear8Bit(tables, p3[1])),
+                                   static_cast<Scalar>(gammaToLinear8Bit(tables, p3[2]))});
+    }
+
+    template Oklab p3ToOklab<double>(const P3 &p3);
+    template Oklabf p3ToOklab<float>(const P3 &p3);
+
     Oklab p3ToOklab(const P3 &p3)
     {
-        return linearP3ToOklab({gammaToLinear(p3[0] / 255.0),
-                                gammaToLinear(p3[1] / 255.0),
-                                gammaToLinear(p3[2] / 255.0)});
+        return p3ToOklab<double>(p3);
     }
 
-    LinearP3 oklabToLinearP3(const Oklab &oklab)
+    template <typename Scalar>
+    BasicLinearP3<Scalar> oklabToLinearP3(const BasicOklab<Scalar> &oklab)
     {
-        LMS lms = oklabToLms(oklab);
-        LinearP3 p3 = multiplyMatrix(LMS_TO_P3, lms);
+        BasicLMS<Scalar> lms = oklabToLms(oklab);
+        BasicLinearP3<Scalar> p3 = multiplyMatrix(LMS_TO_P3, lms);
         return p3;
     }
 
     template <>
     bool isInGamut<LinearP3>(const LinearP3 &linearP3)
     {
-        return linearP3[0] >= 0.0 && linearP3[0] <= 1.0 &&
-               linearP3[1] >= 0.0 && linearP3[1] <= 1.0 &&
-               linearP3[2] >= 0.0 && linearP3[2] <= 1.0;
+        return isInP3Gamut(linearP3);
+    }
+
+    template <>
+    bool isInGamut<LinearP3f>(const LinearP3f &linearP3)
+    {
+        return isInP3Gamut(linearP3);
     }
 
     template <>
@@ -93,29 +141,300 @@ namespace oklab
         return oklabToLinearP3(oklab);
     }
 
+    template <>
+    LinearP3f oklabToLinearColor<LinearP3f>(const Oklabf &oklab)
+    {
+        return oklabToLinearP3(oklab);
+    }
+
     template <>
     P3 linearColorToColor<LinearP3, P3>(const LinearP3 &linearP3)
     {
         return linearP3ToP3(linearP3);
     }
 
+    template <>
+    P3 linearColorToColor<LinearP3f, P3>(const LinearP3f &linearP3)
+    {
+        return linearP3ToP3(linearP3);
+    }
+
+    template <>
+    GammaP3 linearColorToColor<LinearP3, GammaP3>(const LinearP3 &linearP3)
+    {
+        return GammaP3{linearToGamma(linearP3[0]), linearToGamma(linearP3[1]), linearToGamma(linearP3[2])};
+    }
+
     template <>
     Oklab linearColorToOklab<LinearP3>(const LinearP3 &linearP3)
     {
         return linearP3ToOklab(linearP3);
     }
 
+    template <>
+    Oklabf linearColorToOklab<LinearP3f>(const LinearP3f &linearP3)
+    {
+        return linearP3ToOklab(linearP3);
+    }
+
+    namespace
+    {
+        template <typename ColorType, GamutMapping Mapping = DEFAULT_GAMUT_MAPPING, typename Scalar>
+        ColorType oklabToP3Impl(const BasicOklab<Scalar> &oklab)
+        {
+            return mapToGamut<Mapping, ColorType, BasicLinearP3<Scalar>>(oklab);
+        }
+    } // namespace
+
     P3 oklabToP3(const Oklab &oklab)
     {
-#ifdef MAPPING_CSS4
-        return performCssGamutMapping<P3, LinearP3>(oklab);
-#elif MAPPING_CLAMP
-        LinearP3 linearP3 = oklabToLinearP3(oklab);
-        LinearP3 clippedLinearP3 = clipToGamut(linearP3);
-        return linearP3ToP3(clippedLinearP3);
-#else
-        LinearP3 linearP3 = oklabToLinearP3(oklab);
-        return linearP3ToP3(linearP3);
-#endif
+        return oklabToP3Impl<P3>(oklab);
+    }
+
+    P3 oklabToP3(const Oklab &oklab, GamutMapping mapping)
+    {
+        return dispatchGamutMapping(mapping, [&](auto constant)
+        {
+            return oklabToP3Impl<P3, decltype(constant)::value>(oklab);
+        });
+    }
+
+    P3 oklabToP3(const Oklabf &oklab)
+    {
+        return oklabToP3Impl<P3>(oklab);
+    }
+
+    P3 oklabToP3(const Oklabf &oklab, GamutMapping mapping)
+    {
+        return dispatchGamutMapping(mapping, [&](auto constant)
+        {
+            return oklabToP3Impl<P3, decltype(constant)::value>(oklab);
+        });
+    }
+
+    Oklab gammaP3ToOklab(const GammaP3 &gammaP3)
+    {
+        return linearP3ToOklab(LinearP3{gammaToLinear(gammaP3[0]), gammaToLinear(gammaP3[1]), gammaToLinear(gammaP3[2])});
+    }
+
+    GammaP3 oklabToGammaP3(const Oklab &oklab)
+    {
+        return oklabToP3Impl<GammaP3>(oklab);
+    }
+
+    GammaP3 oklabToGammaP3(const Oklab &oklab, GamutMapping mapping)
+    {
+        return dispatchGamutMapping(mapping, [&](auto constant)
+        {
+            return oklabToP3Impl<GammaP3, decltype(constant)::value>(oklab);
+        });
+    }
+
+    Oklab p3ToOklab(const P3 &p3, BitDepth depth)
+    {
+        const TransferTablesNBit &tables = transferTablesNBit(depth);
+        return linearP3ToOklab(LinearP3{gammaToLinearNBit(tables, p3[0]), gammaToLinearNBit(tables, p3[1]), gammaToLinearNBit(tables, p3[2])});
+    }
+
+    P3 oklabToP3(const Oklab &oklab, BitDepth depth)
+    {
+        return oklabToP3(oklab, depth, DEFAULT_GAMUT_MAPPING);
+    }
+
+    P3 oklabToP3(const Oklab &oklab, BitDepth depth, GamutMapping mapping)
+    {
+        // Mapped in linear light, as for 8-bit codes, then encoded to the depth
+        LinearP3 linearColor = dispatchGamutMapping(mapping, [&](auto constant)
+        {
+            return oklabToP3Impl<LinearP3, decltype(constant)::value>(oklab);
+        });
+        const TransferTablesNBit &tables = transferTablesNBit(depth);
+        return P3{linearToGammaNBit(tables, linearColor[0]), linearToGammaNBit(tables, linearColor[1]), linearToGammaNBit(tables, linearColor[2])};
+    }
+
+    namespace
+    {
+        // Shared by the batch entry points: `load(offset, count, linear)` fills a block of linear colors
+        template <typename Load>
+        void convertP3BlocksToOklab(StridedChannels<double> output, std::size_t size, Load load)
+        {
+            forEachBlock(size, [&](std::size_t offset, std::size_t count)
+            {
+                BlockPlanes block;
+                BlockPlanes lms;
+                load(offset, count, block);
+                multiplyMatrixBlock(P3_TO_LMS, block, lms, count);
+                lmsToOklabBlock(lms, block, count);
+                storeBlock(block, count, output, offset);
+            });
+        }
+
+        void convertP3ToOklab(StridedChannels<const int> input, StridedChannels<double> output, std::size_t size)
+        {
+            convertP3BlocksToOklab(output, size, [&](std::size_t offset, std::size_t count, BlockPlanes &block)
+            {
+                loadDecodedBlock(input, offset, count, block);
+            });
+        }
+
+        // `store(linear, offset, count)` encodes a block of mapped linear colors into the output
+        template <GamutMapping Mapping, typename Store>
+        void convertOklabBlocksToP3(StridedChannels<const double> input, std::size_t size, Store store)
+        {
+            forEachBlock(size, [&](std::size_t offset, std::size_t count)
+            {
+                BlockPlanes oklab;
+                BlockPlanes lms;
+                BlockPlanes linear;
+                loadBlock(input, offset, count, oklab);
+                oklabToLmsBlock(oklab, lms, count);
+                multiplyMatrixBlock(LMS_TO_P3, lms, linear, count);
+                mapBlockToGamut<LinearP3, Mapping>(oklab, linear, count);
+                store(linear, offset, count);
+            });
+        }
+
+        template <typename Store>
+        void convertOklabBlocksToP3(StridedChannels<const double> input, std::size_t size, GamutMapping mapping, Store store)
+        {
+            dispatchGamutMapping(mapping, [&](auto constant)
+            {
+                convertOklabBlocksToP3<decltype(constant)::value>(input, size, store);
+            });
+        }
+
+        void convertOklabToP3(StridedChannels<const double> input, StridedChannels<int> output, std::size_t size, GamutMapping mapping)
+        {
+            convertOklabBlocksToP3(input, size, mapping, [&](BlockPlanes &linear, std::size_t offset, std::size_t count)
+            {
+                encodeGammaBlock(linear, count, output, offset);
+            });
+        }
+
+        void convertP3ToOklab(StridedChannels<const int> input, StridedChannels<double> output, std::size_t size, BitDepth depth)
+        {
+            if (depth == BitDepth::Eight)
+            {
+                convertP3ToOklab(input, output, size);
+                return;
+            }
+            const TransferTablesNBit &tables = transferTablesNBit(depth);
+            convertP3BlocksToOklab(output, size, [&](std::size_t offset, std::size_t count, BlockPlanes &block)
+            {
+                loadDecodedBlock(input, offset, count, tables, block);
+            });
+        }
+
+        void convertOklabToP3(StridedChannels<const double> input, StridedChannels<int> output, std::size_t size, BitDepth depth,
+                              GamutMapping mapping)
+        {
+            if (depth == BitDepth::Eight)
+            {
+                convertOklabToP3(input, output, size, mapping);
+                return;
+            }
+            const TransferTablesNBit &tables = transferTablesNBit(depth);
+            convertOklabBlocksToP3(input, size, mapping, [&](BlockPlanes &linear, std::size_t offset, std::size_t count)
+            {
+                encodeGammaBlock(linear, count, tables, output, offset);
+            });
+        }
+
+        template <typename T>
+        void convertGammaP3ToOklab(StridedChannels<const T> input, StridedChannels<double> output, std::size_t size, TransferAccuracy accuracy)
+        {
+            convertP3BlocksToOklab(output, size, [&](std::size_t offset, std::size_t count, BlockPlanes &block)
+            {
+                loadLinearizedBlock(input, offset, count, accuracy, block);
+            });
+        }
+
+        template <typename T>
+        void convertOklabToGammaP3(StridedChannels<const double> input, StridedChannels<T> output, std::size_t size, GamutMapping mapping,
+                                 TransferAccuracy accuracy)
+        {
+            convertOklabBlocksToP3(input, size, mapping, [&](BlockPlanes &linear, std::size_t offset, std::size_t count)
+            {
+                storeEncodedBlock(linear, count, accuracy, output, offset);
+            });
+        }
+    }
+
+    void p3ToOklab(Span<const P3> input, Span<Oklab> output)
+    {
+        std::size_t size = batchSize(input, output);
+        convertP3ToOklab(stridedChannels(input), stridedChannels(output), size);
+    }
+
+    void p3ToOklab(Planar<const int> input, Planar<double> output)
+    {
+        std::size_t size = batchSize(input, output);
+        convertP3ToOklab(stridedChannels(input), stridedChannels(output), size);
+    }
+
+    void oklabToP3(Span<const Oklab> input, Span<P3> output)
+    {
+        std::size_t size = batchSize(input, output);
+        convertOklabToP3(stridedChannels(input), stridedChannels(output), size, DEFAULT_GAMUT_MAPPING);
+    }
+
+    void oklabToP3(Span<const Oklab> input, Span<P3> output, GamutMapping mapping)
+    {
+        std::size_t size = batchSize(input, output);
+        convertOklabToP3(stridedChannels(input), stridedChannels(output), size, mapping);
+    }
+
+    void oklabToP3(Planar<const double> input, Planar<int> output)
+    {
+        std::size_t size = batchSize(input, output);
+        convertOklabToP3(stridedChannels(input), stridedChannels(output), size, DEFAULT_GAMUT_MAPPING);
+    }
+
+    void oklabToP3(Planar<const double> input, Planar<int> output, GamutMapping mapping)
+    {
+        std::size_t size = batchSize(input, output);
+        convertOklabToP3(stridedChannels(input), stridedChannels(output), size, mapping);
+    }
+
+    void p3ToOklab(Span<const P3> input, Span<Oklab> output, BitDepth depth)
+    {
+        std::size_t size = batchSize(input, output);
+        convertP3ToOklab(stridedChannels(input), stridedChannels(output), size, depth);
+    }
+
+    void oklabToP3(Span<const Oklab> input, Span<P3> output, BitDepth depth)
+    {
+        std::size_t size = batchSize(input, output);
+        convertOklabToP3(stridedChannels(input), stridedChannels(output), size, depth, DEFAULT_GAMUT_MAPPING);
+    }
+
+    void oklabToP3(Span<const Oklab> input, Span<P3> output, BitDepth depth, GamutMapping mapping)
+    {
+        std::size_t size = batchSize(input, output);
+        convertOklabToP3(stridedChannels(input), stridedChannels(output), size, depth, mapping);
+    }
+
+    void gammaP3ToOklab(Span<const GammaP3> input, Span<Oklab> output, TransferAccuracy accuracy)
+    {
+        std::size_t size = batchSize(input, output);
+        convertGammaP3ToOklab(stridedChannels(input), stridedChannels(output), size, accuracy);
+    }
+
+    void gammaP3ToOklab(Span<const GammaP3f> input, Span<Oklab> output, TransferAccuracy accuracy)
+    {
+        std::size_t size = batchSize(input, output);
+        convertGammaP3ToOklab(stridedChannels(input), stridedChannels(output), size, accuracy);
+    }
+
+    void oklabToGammaP3(Span<const Oklab> input, Span<GammaP3> output, GamutMapping mapping, TransferAccuracy accuracy)
+    {
+        std::size_t size = batchSize(input, output);
+        convertOklabToGammaP3(stridedChannels(input), stridedChannels(output), size, mapping, accuracy);
+    }
+
+    void oklabToGammaP3(Span<const Oklab> input, Span<GammaP3f> output, GamutMapping mapping, TransferAccuracy accuracy)
+    {
+        std::size_t size = batchSize(input, output);
+        convertOklabToGammaP3(stridedChannels(input), stridedChannels(output), size, mapping, accuracy);
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,346 @@
+#include "PixelFormats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+#include "BatchKernels.h"
+#include "HalfFloat.h"
+#include "TransferTables.h"
+#include "simd/SimdKernels.h"
+
+namespace oklab
+{
+    namespace
+    {
+        // Unpacking and packing of each format, with gamma-encoded channels in [0, 1]
+        template <typename Pixel>
+        struct PixelCodec;
+
+        template <>
+        struct PixelCodec<RGBA8>
+        {
+            static constexpr BitDepth BIT_DEPTH = BitDepth::Eight;
+            static constexpr double MAX_VALUE = 255;
+            static constexpr double MAX_ALPHA = 255;
+
+            static void unpack(const RGBA8 &pixel, unsigned (&codes)[4])
+            {
+                codes[0] = pixel.r;
+                codes[1] = pixel.g;
+                codes[2] = pixel.b;
+                codes[3] = pixel.a;
+            }
+
+            static RGBA8 pack(const unsigned (&codes)[4])
+            {
+                return RGBA8{static_cast<std::uint8_t>(codes[0]), static_cast<std::uint8_t>(codes[1]),
+                             static_cast<std::uint8_t>(codes[2]), static_cast<std::uint8_t>(codes[3])};
+            }
+        };
+
+        template <>
+        struct PixelCodec<BGRA8>
+        {
+            static constexpr BitDepth BIT_DEPTH = BitDepth::Eight;
+            static constexpr double MAX_VALUE = 255;
+            static constexpr double MAX_ALPHA = 255;
+
+            static void unpack(const BGRA8 &pixel, unsigned (&codes)[4])
+            {
+                codes[0] = pixel.r;
+                codes[1] = pixel.g;
+                codes[2] = pixel.b;
+                codes[3] = pixel.a;
+            }
+
+            static BGRA8 pack(const unsigned (&codes)[4])
+            {
+                return BGRA8{static_cast<std::uint8_t>(codes[2]), static_cast<std::uint8_t>(codes[1]),
+                             static_cast<std::uint8_t>(codes[0]), static_cast<std::uint8_t>(codes[3])};
+            }
+        };
+
+        template <>
+        struct PixelCodec<RGB10A2>
+        {
+            static constexpr BitDepth BIT_DEPTH = BitDepth::Ten;
+            static constexpr double MAX_VALUE = 1023;
+            static constexpr double MAX_ALPHA = 3;
+
+            static void unpack(const RGB10A2 &pixel, unsigned (&codes)[4])
+            {
+                codes[0] = pixel.bits & 0x3ffu;
+                codes[1] = (pixel.bits >> 10) & 0x3ffu;
+                codes[2] = (pixel.bits >> 20) & 0x3ffu;
+                codes[3] = pixel.bits >> 30;
+            }
+
+            static RGB10A2 pack(const unsigned (&codes)[4])
+            {
+                return RGB10A2{codes[0] | (codes[1] << 10) | (codes[2] << 20) | (codes[3] << 30)};
+            }
+        };
+
+        template <>
+        struct PixelCodec<RGBA16>
+        {
+            static constexpr BitDepth BIT_DEPTH = BitDepth::Sixteen;
+            static constexpr double MAX_VALUE = 65535;
+            static constexpr double MAX_ALPHA = 65535;
+
+            static void unpack(const RGBA16 &pixel, unsigned (&codes)[4])
+            {
+                codes[0] = pixel.r;
+                codes[1] = pixel.g;
+                codes[2] = pixel.b;
+                codes[3] = pixel.a;
+            }
+
+            static RGBA16 pack(const unsigned (&codes)[4])
+            {
+                return RGBA16{static_cast<std::uint16_t>(codes[0]), static_cast<std::uint16_t>(codes[1]),
+                              static_cast<std::uint16_t>(codes[2]), static_cast<std::uint16_t>(codes[3])};
+            }
+        };
+
+        // Integer formats: channels in [0, MAX_VALUE], stored rounded to the nearest code
+        template <typename Pixel>
+        void unpackNormalized(const Pixel &pixel, double (&values)[4])
+        {
+            unsigned codes[4];
+            PixelCodec<Pixel>::unpack(pixel, codes);
+            for (int c = 0; c < 3; ++c)
+            {
+                values[c] = codes[c] / PixelCodec<Pixel>::MAX_VALUE;
+            }
+            values[3] = codes[3] / PixelCodec<Pixel>::MAX_ALPHA;
+        }
+
+        unsigned quantize(double value, double maxValue)
+        {
+            // Also maps NaN to 0
+            return value > 0 ? static_cast<unsigned>(std::round(std::min(value, 1.0) * maxValue)) : 0;
+        }
+
+        template <typename Pixel>
+        Pixel packNormalized(const double (&values)[4])
+        {
+            unsigned codes[4];
+            for (int c = 0; c < 3; ++c)
+            {
+                codes[c] = quantize(values[c], PixelCodec<Pixel>::MAX_VALUE);
+            }
+            codes[3] = quantize(values[3], PixelCodec<Pixel>::MAX_ALPHA);
+            return PixelCodec<Pixel>::pack(codes);
+        }
+
+        // Half floats: extended range, neither clamped nor quantized
+        template <>
+        void unpackNormalized<RGBAHalf>(const RGBAHalf &pixel, double (&values)[4])
+        {
+            values[0] = halfToFloat(pixel.r);
+            values[1] = halfToFloat(pixel.g);
+            values[2] = halfToFloat(pixel.b);
+            values[3] = halfToFloat(pixel.a);
+        }
+
+        template <>
+        RGBAHalf packNormalized<RGBAHalf>(const double (&values)[4])
+        {
+            return RGBAHalf{floatToHalf(static_cast<float>(values[0])), floatToHalf(static_cast<float>(values[1])),
+                            floatToHalf(static_cast<float>(values[2])), floatToHalf(static_cast<float>(values[3]))};
+        }
+
+        // Integer formats of straight alpha convert their codes through the transfer tables
+        template <typename Pixel>
+        constexpr bool hasCodes()
+        {
+            return !std::is_same_v<Pixel, RGBAHalf>;
+        }
+
+        // Unpacks `count` pixels into a linear block and their alpha, zero-filling the padding
+        template <typename Pixel>
+        void loadPixels(const void *input, std::size_t offset, std::size_t count, AlphaMode alphaMode, BlockPlanes &linear, double *alpha)
+        {
+            const Pixel *pixels = static_cast<const Pixel *>(input) + offset;
+
+            if constexpr (hasCodes<Pixel>())
+            {
+                if (alphaMode == AlphaMode::Straight)
+                {
+                    // Through the decoding table of the depth, as rgbToOklab / p3ToOklab
+                    const TransferTablesNBit &tables = transferTablesNBit(PixelCodec<Pixel>::BIT_DEPTH);
+                    for (std::size_t i = 0; i < count; ++i)
+                    {
+                        unsigned codes[4];
+                        PixelCodec<Pixel>::unpack(pixels[i], codes);
+                        for (int c = 0; c < 3; ++c)
+                        {
+                            linear.channels[c][i] = tables.decode[codes[c]];
+                        }
+                        alpha[i] = codes[3] / PixelCodec<Pixel>::MAX_ALPHA;
+                    }
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        std::fill(linear.channels[c] + count, linear.channels[c] + paddedCount(count), 0.0);
+                    }
+                    return;
+                }
+            }
+
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                double values[4];
+                unpackNormalized(pixels[i], values);
+                alpha[i] = values[3];
+
+                if (alphaMode == AlphaMode::Premultiplied)
+                {
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        values[c] = values[3] > 0 ? values[c] / values[3] : 0.0;
+                    }
+                }
+                for (int c = 0; c < 3; ++c)
+                {
+                    linear.channels[c][i] = values[c];
+                }
+            }
+
+            const KernelTable &table = kernels();
+            for (int c = 0; c < 3; ++c)
+            {
+                std::fill(linear.channels[c] + count, linear.channels[c] + paddedCount(count), 0.0);
+                table.gammaToLinear(linear.channels[c], count, TransferAccuracy::Precise);
+            }
+        }
+
+        // Encodes a mapped linear block and packs it, with its alpha, into `count` pixels
+        template <typename Pixel>
+        void storePixels(BlockPlanes &linear, const double *alpha, std::size_t count, AlphaMode alphaMode, void *output, std::size_t offset)
+        {
+            Pixel *pixels = static_cast<Pixel *>(output) + offset;
+
+            if constexpr (hasCodes<Pixel>())
+            {
+                if (alphaMode == AlphaMode::Straight)
+                {
+                    // Through the encoding of the depth, as oklabToRgb / oklabToP3
+                    alignas(64) int encoded[3][BATCH_BLOCK_SIZE];
+                    StridedChannels<int> destination{{encoded[0], encoded[1], encoded[2]}, 1};
+                    if constexpr (PixelCodec<Pixel>::BIT_DEPTH == BitDepth::Eight)
+                    {
+                        encodeGammaBlock(linear, count, destination, 0);
+                    }
+                    else
+                    {
+                        encodeGammaBlock(linear, count, transferTablesNBit(PixelCodec<Pixel>::BIT_DEPTH), destination, 0);
+                    }
+                    for (std::size_t i = 0; i < count; ++i)
+                    {
+                        unsigned codes[4] = {static_cast<unsigned>(encoded[0][i]), static_cast<unsigned>(encoded[1][i]),
+                                             static_cast<unsigned>(encoded[2][i]), quantize(alpha[i], PixelCodec<Pixel>::MAX_ALPHA)};
+                        pixels[i] = PixelCodec<Pixel>::pack(codes);
+                    }
+                    return;
+                }
+            }
+
+            const KernelTable &table = kernels();
+            for (int c = 0; c < 3; ++c)
+            {
+                table.linearToGamma(linear.channels[c], count, TransferAccuracy::Precise);
+            }
+
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                double values[4] = {linear.channels[0][i], linear.channels[1][i], linear.channels[2][i], alpha[i]};
+                if (alphaMode == AlphaMode::Premultiplied)
+                {
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        values[c] *= alpha[i];
+                    }
+                }
+                pixels[i] = packNormalized<Pixel>(values);
+            }
+        }
+
+        using LoadPixels = void (*)(const void *input, std::size_t offset, std::size_t count, AlphaMode alphaMode, BlockPlanes &linear,
+                                    double *alpha);
+        using StorePixels = void (*)(BlockPlanes &linear, const double *alpha, std::size_t count, AlphaMode alphaMode, void *output,
+                                     std::size_t offset);
+
+        template <template <typename> class Select>
+        auto selectFormat(PixelFormat format)
+        {
+            switch (format)
+            {
+            case PixelFormat::RGBA8:
+                return Select<RGBA8>::value;
+            case PixelFormat::BGRA8:
+                return Select<BGRA8>::value;
+            case PixelFormat::RGB10A2:
+                return Select<RGB10A2>::value;
+            case PixelFormat::RGBA16:
+                return Select<RGBA16>::value;
+            default:
+                return Select<RGBAHalf>::value;
+            }
+        }
+
+        template <typename Pixel>
+        struct SelectLoad
+        {
+            static constexpr LoadPixels value = loadPixels<Pixel>;
+        };
+
+        template <typename Pixel>
+        struct SelectStore
+        {
+            static constexpr StorePixels value = storePixels<Pixel>;
+        };
+
+        // Same stages as p3ToOklab + oklabToRgb (or rgbToOklab + oklabToP3), without leaving the block
+        template <typename InputLinearType, typename OutputLinearType, GamutMapping Mapping>
+        void convertPixelBlocks(LoadPixels load, const void *input, StorePixels store, void *output, std::size_t size, AlphaMode alphaMode)
+        {
+            forEachBlock(size, [&](std::size_t offset, std::size_t count)
+            {
+                BlockPlanes linear;
+                BlockPlanes lms;
+                BlockPlanes oklab;
+                alignas(64) double alpha[BATCH_BLOCK_SIZE];
+
+                load(input, offset, count, alphaMode, linear, alpha);
+                multiplyMatrixBlock(LinearSpaceMatrices<InputLinearType>::TO_LMS, linear, lms, count);
+                lmsToOklabBlock(lms, oklab, count);
+                oklabToLmsBlock(oklab, lms, count);
+                multiplyMatrixBlock(LinearSpaceMatrices<OutputLinearType>::FROM_LMS, lms, linear, count);
+                mapBlockToGamut<OutputLinearType, Mapping>(oklab, linear, count);
+                store(linear, alpha, count, alphaMode, output, offset);
+            });
+        }
+    } // namespace
+
+    void convertPixels(PixelConversion conversion, PixelFormat inputFormat, const void *input, PixelFormat outputFormat,
+                       void *output, std::size_t size, GamutMapping mapping, AlphaMode alphaMode)
+    {
+        LoadPixels load = selectFormat<SelectLoad>(inputFormat);
+        StorePixels store = selectFormat<SelectStore>(outputFormat);
+
+        dispatchGamutMapping(mapping, [&](auto constant)
+        {
+            constexpr GamutMapping Mapping = decltype(constant)::value;
+            if (conversion == PixelConversion::P3ToRgb)
+            {
+                convertPixelBlocks<LinearP3, LinearSRGB, Mapping>(load, input, store, output, size, alphaMode);
+            }
+            else
+            {
+                convertPixelBlocks<LinearSRGB, LinearP3, Mapping>(load, input, store, output, size, alphaMode);
+            }
+        });
+    }
+} // namespace oklab
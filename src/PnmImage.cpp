@@ -0,0 +1,357 @@
+#include "PnmImage.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ColorBatchConversions.h"
+#include "ImageTiles.h"
+
+namespace oklab
+{
+    namespace
+    {
+        // Bound on the width and height, keeping sizes far from overflowing
+        constexpr std::size_t MAX_DIMENSION = std::size_t{1} << 24;
+
+        struct PnmHeader
+        {
+            PnmFormat format;
+            std::size_t width = 0;
+            std::size_t height = 0;
+            std::size_t maxValue = 0;
+            bool hasAlpha = false;
+            std::size_t size = 0;
+        };
+
+        bool isSpace(char c)
+        {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+        }
+
+        // Skips whitespace and comments, which run from '#' to the end of their line
+        void skipSpaces(const char *&p, const char *end)
+        {
+            while (p < end && (isSpace(*p) || *p == '#'))
+            {
+                if (*p == '#')
+                {
+                    while (p < end && *p != '\n')
+                    {
+                        ++p;
+                    }
+                }
+                else
+                {
+                    ++p;
+                }
+            }
+        }
+
+        bool readWord(const char *&p, const char *end, std::string &word)
+        {
+            skipSpaces(p, end);
+            word.clear();
+            while (p < end && !isSpace(*p))
+            {
+                word += *p++;
+            }
+            return !word.empty();
+        }
+
+        bool readNumber(const char *&p, const char *end, std::size_t &value)
+        {
+            skipSpaces(p, end);
+            if (p == end || *p < '0' || *p > '9')
+            {
+                return false;
+            }
+            value = 0;
+            while (p < end && *p >= '0' && *p <= '9')
+            {
+                value = value * 10 + static_cast<std::size_t>(*p++ - '0');
+                if (value > MAX_DIMENSION)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // P6 <width> <height> <maxval>, then a single whitespace before the samples
+        bool parsePpmHeader(const char *&p, const char *end, PnmHeader &header)
+        {
+            header.format = PnmFormat::Ppm;
+            if (!readNumber(p, end, header.width) || !readNumber(p, end, header.height) || !readNumber(p, end, header.maxValue))
+            {
+                return false;
+            }
+            if (p == end || !isSpace(*p))
+            {
+                return false;
+            }
+            ++p;
+            return true;
+        }
+
+        // P7 followed by "<keyword> <value>" lines, up to ENDHDR
+        bool parsePamHeader(const char *&p, const char *end, PnmHeader &header)
+        {
+            header.format = PnmFormat::Pam;
+            std::size_t depth = 0;
+            std::string keyword;
+            std::string tupleType;
+            while (readWord(p, end, keyword))
+            {
+                if (keyword == "ENDHDR")
+                {
+                    if (p == end || *p != '\n')
+                    {
+                        return false;
+                    }
+                    ++p;
+
+                    header.hasAlpha = depth == 4;
+                    bool isRgb = tupleType.empty() || tupleType == (header.hasAlpha ? "RGB_ALPHA" : "RGB");
+                    return (depth == 3 || depth == 4) && isRgb;
+                }
+
+                bool isValid = keyword == "WIDTH"      ? readNumber(p, end, header.width)
+                               : keyword == "HEIGHT"   ? readNumber(p, end, header.height)
+                               : keyword == "DEPTH"    ? readNumber(p, end, depth)
+                               : keyword == "MAXVAL"   ? readNumber(p, end, header.maxValue)
+                               : keyword == "TUPLTYPE" ? readWord(p, end, tupleType)
+                                                       : false;
+                if (!isValid)
+                {
+                    return false;
+                }
+            }
+            return false;
+        }
+
+        bool parseHeader(const char *data, std::size_t size, PnmHeader &header)
+        {
+            if (size < 3 || data[0] != 'P' || (data[1] != '6' && data[1] != '7') || !isSpace(data[2]))
+            {
+                return false;
+            }
+
+            const char *p = data + 2;
+            const char *end = data + size;
+            bool isParsed = data[1] == '6' ? parsePpmHeader(p, end, header) : parsePamHeader(p, end, header);
+            header.size = static_cast<std::size_t>(p - data);
+            return isParsed && header.maxValue >= 1 && header.maxValue <= 65535;
+        }
+
+        std::string headerText(PnmFormat format, std::size_t width, std::size_t height, unsigned maxValue, bool hasAlpha)
+        {
+            if (format == PnmFormat::Ppm)
+            {
+                return "P6\n" + std::to_string(width) + " " + std::to_string(height) + "\n" + std::to_string(maxValue) + "\n";
+            }
+            return "P7\nWIDTH " + std::to_string(width) + "\nHEIGHT " + std::to_string(height) + "\nDEPTH " +
+                   std::to_string(hasAlpha ? 4 : 3) + "\nMAXVAL " + std::to_string(maxValue) + "\nTUPLTYPE " +
+                   (hasAlpha ? "RGB_ALPHA" : "RGB") + "\nENDHDR\n";
+        }
+
+        unsigned readSample(const unsigned char *sample, std::size_t sampleSize)
+        {
+            return sampleSize == 1 ? sample[0] : (static_cast<unsigned>(sample[0]) << 8) | sample[1];
+        }
+
+        void writeSample(unsigned char *sample, std::size_t sampleSize, unsigned value)
+        {
+            if (sampleSize == 1)
+            {
+                sample[0] = static_cast<unsigned char>(value);
+            }
+            else
+            {
+                sample[0] = static_cast<unsigned char>(value >> 8);
+                sample[1] = static_cast<unsigned char>(value);
+            }
+        }
+
+        // Rounds value / from * to; samples above the maximum value are clamped to it
+        unsigned rescale(unsigned value, unsigned from, unsigned to)
+        {
+            std::uint64_t clamped = value < from ? value : from;
+            return static_cast<unsigned>((clamped * to + from / 2) / from);
+        }
+
+        template <typename InputType, typename OutputType, typename ToOklab, typename FromOklab>
+        bool convertPnm(const PnmImage &input, PnmImage &output, const ImageConversionOptions &options, ToOklab toOklab, FromOklab fromOklab)
+        {
+            if (!output.isWritable())
+            {
+                throw std::invalid_argument("output image opened read-only");
+            }
+            if (input.width() != output.width() || input.height() != output.height())
+            {
+                throw std::invalid_argument("input and output images differ in size");
+            }
+
+            const std::size_t inputChannels = input.channelCount();
+            const std::size_t inputSampleSize = input.sampleSize();
+            const unsigned inputMaxValue = input.maxValue();
+            const std::size_t outputChannels = output.channelCount();
+            const std::size_t outputSampleSize = output.sampleSize();
+            const unsigned outputMaxValue = output.maxValue();
+            const BitDepth depth = std::max(inputMaxValue, outputMaxValue) > 255 ? BitDepth::Sixteen : BitDepth::Eight;
+            const unsigned workingMaxValue = static_cast<unsigned>(maxCodeValue(depth));
+
+            return forEachTileSegment(input.width(), input.height(), options, [&](std::size_t x, std::size_t y, std::size_t width)
+            {
+                std::array<InputType, IMAGE_TILE_WIDTH> colors;
+                std::array<Oklab, IMAGE_TILE_WIDTH> oklab;
+                std::array<OutputType, IMAGE_TILE_WIDTH> converted;
+
+                const unsigned char *in = input.row(y) + x * inputChannels * inputSampleSize;
+                for (std::size_t i = 0; i < width; ++i)
+                {
+                    for (std::size_t c = 0; c < 3; ++c)
+                    {
+                        unsigned sample = readSample(in + (i * inputChannels + c) * inputSampleSize, inputSampleSize);
+                        colors[i][c] = static_cast<int>(rescale(sample, inputMaxValue, workingMaxValue));
+                    }
+                }
+
+                Span<Oklab> oklabRow(oklab.data(), width);
+                toOklab(Span<const InputType>(colors.data(), width), oklabRow, depth);
+                fromOklab(Span<const Oklab>(oklabRow), Span<OutputType>(converted.data(), width), depth, options.mapping);
+
+                unsigned char *out = output.row(y) + x * outputChannels * outputSampleSize;
+                for (std::size_t i = 0; i < width; ++i)
+                {
+                    for (std::size_t c = 0; c < 3; ++c)
+                    {
+                        unsigned sample = rescale(static_cast<unsigned>(converted[i][c]), workingMaxValue, outputMaxValue);
+                        writeSample(out + (i * outputChannels + c) * outputSampleSize, outputSampleSize, sample);
+                    }
+                    if (outputChannels == 4)
+                    {
+                        unsigned alpha = inputChannels == 4
+                                             ? rescale(readSample(in + (i * 4 + 3) * inputSampleSize, inputSampleSize), inputMaxValue, outputMaxValue)
+                                             : outputMaxValue;
+                        writeSample(out + (i * 4 + 3) * outputSampleSize, outputSampleSize, alpha);
+                    }
+                }
+            });
+        }
+    } // namespace
+
+    PnmImage::PnmImage(void *mapping, std::size_t mappingSize, std::size_t headerSize, PnmFormat format, std::size_t width,
+                       std::size_t height, unsigned maxValue, bool hasAlpha, bool isWritable)
+        : mapping_(mapping), mappingSize_(mappingSize), samples_(static_cast<unsigned char *>(mapping) + headerSize), format_(format),
+          width_(width), height_(height), maxValue_(maxValue), hasAlpha_(hasAlpha), isWritable_(isWritable)
+    {
+    }
+
+    std::unique_ptr<PnmImage> PnmImage::open(const std::string &path)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            return nullptr;
+        }
+
+        struct stat status;
+        if (fstat(fd, &status) != 0 || status.st_size == 0)
+        {
+            close(fd);
+            return nullptr;
+        }
+
+        const std::size_t fileSize = static_cast<std::size_t>(status.st_size);
+        void *mapping = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED)
+        {
+            return nullptr;
+        }
+
+        PnmHeader header;
+        if (!parseHeader(static_cast<const char *>(mapping), fileSize, header))
+        {
+            munmap(mapping, fileSize);
+            return nullptr;
+        }
+
+        unsigned maxValue = static_cast<unsigned>(header.maxValue);
+        std::unique_ptr<PnmImage> image(new PnmImage(mapping, fileSize, header.size, header.format, header.width, header.height,
+                                                     maxValue, header.hasAlpha, false));
+        if (header.size + image->height() * image->rowSize() > fileSize)
+        {
+            return nullptr;
+        }
+        return image;
+    }
+
+    std::unique_ptr<PnmImage> PnmImage::create(const std::string &path, PnmFormat format, std::size_t width, std::size_t height,
+                                               unsigned maxValue, bool hasAlpha)
+    {
+        if ((format == PnmFormat::Ppm && hasAlpha) || maxValue < 1 || maxValue > 65535 || width > MAX_DIMENSION || height > MAX_DIMENSION)
+        {
+            return nullptr;
+        }
+
+        const std::string header = headerText(format, width, height, maxValue, hasAlpha);
+        const std::size_t sampleSize = maxValue > 255 ? 2 : 1;
+        const std::size_t fileSize = header.size() + height * width * (hasAlpha ? 4 : 3) * sampleSize;
+
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0)
+        {
+            return nullptr;
+        }
+
+        void *mapping = MAP_FAILED;
+        if (ftruncate(fd, static_cast<off_t>(fileSize)) == 0)
+        {
+            mapping = mmap(nullptr, fileSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+        if (mapping == MAP_FAILED)
+        {
+            unlink(path.c_str());
+            return nullptr;
+        }
+
+        std::memcpy(mapping, header.data(), header.size());
+        return std::unique_ptr<PnmImage>(new PnmImage(mapping, fileSize, header.size(), format, width, height, maxValue, hasAlpha, true));
+    }
+
+    PnmImage::~PnmImage()
+    {
+        munmap(mapping_, mappingSize_);
+    }
+
+    bool PnmImage::flush()
+    {
+        return isWritable_ && msync(mapping_, mappingSize_, MS_SYNC) == 0;
+    }
+
+    bool p3ToRgb(const PnmImage &input, PnmImage &output, const ImageConversionOptions &options)
+    {
+        return convertPnm<P3, RGB>(input, output, options,
+                                   [](Span<const P3> p3, Span<Oklab> oklab, BitDepth depth) { p3ToOklab(p3, oklab, depth); },
+                                   [](Span<const Oklab> oklab, Span<RGB> rgb, BitDepth depth, GamutMapping mapping)
+                                   { oklabToRgb(oklab, rgb, depth, mapping); });
+    }
+
+    bool rgbToP3(const PnmImage &input, PnmImage &output, const ImageConversionOptions &options)
+    {
+        return convertPnm<RGB, P3>(input, output, options,
+                                   [](Span<const RGB> rgb, Span<Oklab> oklab, BitDepth depth) { rgbToOklab(rgb, oklab, depth); },
+                                   [](Span<const Oklab> oklab, Span<P3> p3, BitDepth depth, GamutMapping mapping)
+                                   { oklabToP3(oklab, p3, depth, mapping); });
+    }
+} // namespace oklab
@@ -1,4 +1,5 @@
 #include "ColorConversions.h"
+#include "ColorBatchConversions.h"
 #include "ColorConversionsInternal.h"
 
 #include <cmath>
@@ -7,18 +8,10 @@
 #include "OkLxx.h"
 #include "MathUtils.h"
 #include "ColorUtils.h"
-#include "gamutMapping/CSS4.h"
-
-// Define the transformation matrices as constants
-const double RGB_TO_LMS[3][3] = {
-    {0.4122214694707629, 0.5363325372617349, 0.0514459932675022},
-    {0.2119034958178251, 0.6806995506452345, 0.1073969535369406},
-    {0.0883024591900564, 0.2817188391361215, 0.6299787016738222}};
-
-const double LMS_TO_RGB[3][3] = {
-    {4.0767416360759601, -3.3077115392580625, 0.2309699031821046},
-    {-1.2684379732850317, 2.6097573492876882, -0.3413193760026572},
-    {-0.0041960761386754, -0.7034186179359361, 1.7076146940746113}};
+#include "TransferTables.h"
+#include "gamutMapping/GamutMappingPolicy.h"
+#include "BatchKernels.h"
+#include "ColorMatrices.h"
 
 namespace oklab
 {
@@ -35,58 +28,112 @@ namespace oklab
         return oklabToRgb(oklab);
     }
 
+    template <>
+    Oklch convertToOklch<RGB>(const RGB &rgb)
+    {
+        return oklabToOklch(convertToOklab(rgb));
+    }
+
+    template <>
+    RGB convertFromOklch<RGB>(const Oklch &oklch)
+    {
+        return convertFromOklab<RGB>(oklchToOklab(oklch));
+    }
+
+    namespace
+    {
+        template <typename Scalar>
+        BasicLinearSRGB<Scalar> clipToRgbGamut(const BasicLinearSRGB<Scalar> &linearRgb)
+        {
+            return BasicLinearSRGB<Scalar>{
+                std::clamp(linearRgb[0], Scalar{0}, Scalar{1}),
+                std::clamp(linearRgb[1], Scalar{0}, Scalar{1}),
+                std::clamp(linearRgb[2], Scalar{0}, Scalar{1})};
+        }
+
+        template <typename Scalar>
+        bool isInRgbGamut(const BasicLinearSRGB<Scalar> &linearRgb)
+        {
+            return linearRgb[0] >= 0 && linearRgb[0] <= 1 &&
+                   linearRgb[1] >= 0 && linearRgb[1] <= 1 &&
+                   linearRgb[2] >= 0 && linearRgb[2] <= 1;
+        }
+    } // namespace
+
     template <>
     LinearSRGB clipToGamut<LinearSRGB>(const LinearSRGB &linearRgb)
     {
-        return LinearSRGB{
-            std::clamp(linearRgb[0], 0.0, 1.0),
-            std::clamp(linearRgb[1], 0.0, 1.0),
-            std::clamp(linearRgb[2], 0.0, 1.0)};
-    };
+        return clipToRgbGamut(linearRgb);
+    }
+
+    template <>
+    LinearSRGBf clipToGamut<LinearSRGBf>(const LinearSRGBf &linearRgb)
+    {
+        return clipToRgbGamut(linearRgb);
+    }
 
     LinearSRGB rgbToLinearRgb(const RGB &rgb)
     {
+        const TransferTables8Bit &tables = transferTables8Bit();
         return LinearSRGB{
-            gammaToLinear(rgb[0] / 255.0),
-            gammaToLinear(rgb[1] / 255.0),
-            gammaToLinear(rgb[2] / 255.0)};
+            gammaToLinear8Bit(tables, rgb[0]),
+            gammaToLinear8Bit(tables, rgb[1]),
+            gammaToLinear8Bit(tables, rgb[2])};
     }
 
-    RGB linearRgbToRgb(const LinearSRGB &linearRgb)
+    template <typename Scalar>
+    RGB linearRgbToRgb(const BasicLinearSRGB<Scalar> &linearRgb)
     {
+        const TransferTables8Bit &tables = transferTables8Bit();
         return RGB{
-            static_cast<int>(std::round(linearToGamma(linearRgb[0]) * 255.0)),
-            static_cast<int>(std::round(linearToGamma(linearRgb[1]) * 255.0)),
-            static_cast<int>(std::round(linearToGamma(linearRgb[2]) * 255.0))};
+            linearToGamma8Bit(tables, linearRgb[0]),
+            linearToGamma8Bit(tables, linearRgb[1]),
+            linearToGamma8Bit(tables, linearRgb[2])};
     }
 
-    Oklab linearRgbToOklab(const LinearSRGB &linearRgb)
+    template <typename Scalar>
+    BasicOklab<Scalar> linearRgbToOklab(const BasicLinearSRGB<Scalar> &linearRgb)
     {
-        LMS lms = multiplyMatrix(RGB_TO_LMS, linearRgb);
-        Oklab oklab = lmsToOklab(lms);
+        BasicLMS<Scalar> lms = multiplyMatrix(RGB_TO_LMS, linearRgb);
+        BasicOklab<Scalar> oklab = lmsToOklab(lms);
         return oklab;
     }
 
+    template <typename Scalar>
+    BasicOklab<Scalar> rgbToOklab(const RGB &rgb)
+    {
+        const TransferTables8Bit &tables = transferTables8Bit();
+        return linearRgbToOklab<Scalar>({static_cast<Scalar>(gammaToLinear8Bit(tables, rgb[0])),
+                                   static_cast<Scalar>(gammaToLinear8Bit(tables, rgb[1])),
+                                   static_cast<Scalar>(gammaToLinear8Bit(tables, rgb[2]))});
+    }
+
+    template Oklab rgbToOklab<double>(const RGB &rgb);
+    template Oklabf rgbToOklab<float>(const RGB &rgb);
+
     Oklab rgbToOklab(const RGB &rgb)
     {
-        return linearRgbToOklab({gammaToLinear(rgb[0] / 255.0),
-                                 gammaToLinear(rgb[1] / 255.0),
-                                 gammaToLinear(rgb[2] / 255.0)});
+        return rgbToOklab<double>(rgb);
     }
 
-    LinearSRGB oklabToLinearRgb(const Oklab &oklab)
+    template <typename Scalar>
+    BasicLinearSRGB<Scalar> oklabToLinearRgb(const BasicOklab<Scalar> &oklab)
     {
-        LMS lms = oklabToLms(oklab);
-        LinearSRGB rgb = multiplyMatrix(LMS_TO_RGB, lms);
+        BasicLMS<Scalar> lms = oklabToLms(oklab);
+        BasicLinearSRGB<Scalar> rgb = multiplyMatrix(LMS_TO_RGB, lms);
         return rgb;
     }
 
     template <>
     bool isInGamut<LinearSRGB>(const LinearSRGB &linearRgb)
     {
-        return linearRgb[0] >= 0.0 && linearRgb[0] <= 1.0 &&
-               linearRgb[1] >= 0.0 && linearRgb[1] <= 1.0 &&
-               linearRgb[2] >= 0.0 && linearRgb[2] <= 1.0;
+        return isInRgbGamut(linearRgb);
+    }
+
+    template <>
+    bool isInGamut<LinearSRGBf>(const LinearSRGBf &linearRgb)
+    {
+        return isInRgbGamut(linearRgb);
     }
 
     template <>
@@ -95,29 +142,300 @@ namespace oklab
         return oklabToLinearRgb(oklab);
     }
 
+    template <>
+    LinearSRGBf oklabToLinearColor<LinearSRGBf>(const Oklabf &oklab)
+    {
+        return oklabToLinearRgb(oklab);
+    }
+
     template <>
     RGB linearColorToColor<LinearSRGB, RGB>(const LinearSRGB &linearRgb)
     {
         return linearRgbToRgb(linearRgb);
     }
 
+    template <>
+    RGB linearColorToColor<LinearSRGBf, RGB>(const LinearSRGBf &linearRgb)
+    {
+        return linearRgbToRgb(linearRgb);
+    }
+
+    template <>
+    GammaSRGB linearColorToColor<LinearSRGB, GammaSRGB>(const LinearSRGB &linearRgb)
+    {
+        return GammaSRGB{linearToGamma(linearRgb[0]), linearToGamma(linearRgb[1]), linearToGamma(linearRgb[2])};
+    }
+
     template <>
     Oklab linearColorToOklab<LinearSRGB>(const LinearSRGB &linearRgb)
     {
         return linearRgbToOklab(linearRgb);
     }
 
+    template <>
+    Oklabf linearColorToOklab<LinearSRGBf>(const LinearSRGBf &linearRgb)
+    {
+        return linearRgbToOklab(linearRgb);
+    }
+
+    namespace
+    {
+        template <typename ColorType, GamutMapping Mapping = DEFAULT_GAMUT_MAPPING, typename Scalar>
+        ColorType oklabToRgbImpl(const BasicOklab<Scalar> &oklab)
+        {
+            return mapToGamut<Mapping, ColorType, BasicLinearSRGB<Scalar>>(oklab);
+        }
+    } // namespace
+
     RGB oklabToRgb(const Oklab &oklab)
     {
-#ifdef MAPPING_CSS4
-        return performCssGamutMapping<RGB, LinearSRGB>(oklab);
-#elif MAPPING_CLAMP
-        LinearSRGB linearRgb = oklabToLinearRgb(oklab);
-        LinearSRGB clippedLinearRgb = clipToGamut<LinearSRGB>(linearRgb);
-        return linearColorToColor<LinearSRGB, RGB>(clippedLinearRgb);
-#else
-        LinearSRGB linearRgb = oklabToLinearRgb(oklab);
-        return linearColorToColor<LinearSRGB, RGB>(linearRgb);
-#endif
-    }
-}
\ No newline at end of file
+        return oklabToRgbImpl<RGB>(oklab);
+    }
+
+    RGB oklabToRgb(const Oklab &oklab, GamutMapping mapping)
+    {
+        return dispatchGamutMapping(mapping, [&](auto constant)
+        {
+            return oklabToRgbImpl<RGB, decltype(constant)::value>(oklab);
+        });
+    }
+
+    RGB oklabToRgb(const Oklabf &oklab)
+    {
+        return oklabToRgbImpl<RGB>(oklab);
+    }
+
+    RGB oklabToRgb(const Oklabf &oklab, GamutMapping mapping)
+    {
+        return dispatchGamutMapping(mapping, [&](auto constant)
+        {
+            return oklabToRgbImpl<RGB, decltype(constant)::value>(oklab);
+        });
+    }
+
+    Oklab gammaSRGBToOklab(const GammaSRGB &gammaRgb)
+    {
+        return linearRgbToOklab(LinearSRGB{gammaToLinear(gammaRgb[0]), gammaToLinear(gammaRgb[1]), gammaToLinear(gammaRgb[2])});
+    }
+
+    GammaSRGB oklabToGammaSRGB(const Oklab &oklab)
+    {
+        return oklabToRgbImpl<GammaSRGB>(oklab);
+    }
+
+    GammaSRGB oklabToGammaSRGB(const Oklab &oklab, GamutMapping mapping)
+    {
+        return dispatchGamutMapping(mapping, [&](auto constant)
+        {
+            return oklabToRgbImpl<GammaSRGB, decltype(constant)::value>(oklab);
+        });
+    }
+
+    Oklab rgbToOklab(const RGB &rgb, BitDepth depth)
+    {
+        const TransferTablesNBit &tables = transferTablesNBit(depth);
+        return linearRgbToOklab(LinearSRGB{gammaToLinearNBit(tables, rgb[0]), gammaToLinearNBit(tables, rgb[1]), gammaToLinearNBit(tables, rgb[2])});
+    }
+
+    RGB oklabToRgb(const Oklab &oklab, BitDepth depth)
+    {
+        return oklabToRgb(oklab, depth, DEFAULT_GAMUT_MAPPING);
+    }
+
+    RGB oklabToRgb(const Oklab &oklab, BitDepth depth, GamutMapping mapping)
+    {
+        // Mapped in linear light, as for 8-bit codes, then encoded to the depth
+        LinearSRGB linearColor = dispatchGamutMapping(mapping, [&](auto constant)
+        {
+            return oklabToRgbImpl<LinearSRGB, decltype(constant)::value>(oklab);
+        });
+        const TransferTablesNBit &tables = transferTablesNBit(depth);
+        return RGB{linearToGammaNBit(tables, linearColor[0]), linearToGammaNBit(tables, linearColor[1]), linearToGammaNBit(tables, linearColor[2])};
+    }
+
+    namespace
+    {
+        // Shared by the batch entry points: `load(offset, count, linear)` fills a block of linear colors
+        template <typename Load>
+        void convertRgbBlocksToOklab(StridedChannels<double> output, std::size_t size, Load load)
+        {
+            forEachBlock(size, [&](std::size_t offset, std::size_t count)
+            {
+                BlockPlanes block;
+                BlockPlanes lms;
+                load(offset, count, block);
+                multiplyMatrixBlock(RGB_TO_LMS, block, lms, count);
+                lmsToOklabBlock(lms, block, count);
+                storeBlock(block, count, output, offset);
+            });
+        }
+
+        void convertRgbToOklab(StridedChannels<const int> input, StridedChannels<double> output, std::size_t size)
+        {
+            convertRgbBlocksToOklab(output, size, [&](std::size_t offset, std::size_t count, BlockPlanes &block)
+            {
+                loadDecodedBlock(input, offset, count, block);
+            });
+        }
+
+        // `store(linear, offset, count)` encodes a block of mapped linear colors into the output
+        template <GamutMapping Mapping, typename Store>
+        void convertOklabBlocksToRgb(StridedChannels<const double> input, std::size_t size, Store store)
+        {
+            forEachBlock(size, [&](std::size_t offset, std::size_t count)
+            {
+                BlockPlanes oklab;
+                BlockPlanes lms;
+                BlockPlanes linear;
+                loadBlock(input, offset, count, oklab);
+                oklabToLmsBlock(oklab, lms, count);
+                multiplyMatrixBlock(LMS_TO_RGB, lms, linear, count);
+                mapBlockToGamut<LinearSRGB, Mapping>(oklab, linear, count);
+                store(linear, offset, count);
+            });
+        }
+
+        template <typename Store>
+        void convertOklabBlocksToRgb(StridedChannels<const double> input, std::size_t size, GamutMapping mapping, Store store)
+        {
+            dispatchGamutMapping(mapping, [&](auto constant)
+            {
+                convertOklabBlocksToRgb<decltype(constant)::value>(input, size, store);
+            });
+        }
+
+        void convertOklabToRgb(StridedChannels<const double> input, StridedChannels<int> output, std::size_t size, GamutMapping mapping)
+        {
+            convertOklabBlocksToRgb(input, size, mapping, [&](BlockPlanes &linear, std::size_t offset, std::size_t count)
+            {
+                encodeGammaBlock(linear, count, output, offset);
+            });
+        }
+
+        void convertRgbToOklab(StridedChannels<const int> input, StridedChannels<double> output, std::size_t size, BitDepth depth)
+        {
+            if (depth == BitDepth::Eight)
+            {
+                convertRgbToOklab(input, output, size);
+                return;
+            }
+            const TransferTablesNBit &tables = transferTablesNBit(depth);
+            convertRgbBlocksToOklab(output, size, [&](std::size_t offset, std::size_t count, BlockPlanes &block)
+            {
+                loadDecodedBlock(input, offset, count, tables, block);
+            });
+        }
+
+        void convertOklabToRgb(StridedChannels<const double> input, StridedChannels<int> output, std::size_t size, BitDepth depth,
+                              GamutMapping mapping)
+        {
+            if (depth == BitDepth::Eight)
+            {
+                convertOklabToRgb(input, output, size, mapping);
+                return;
+            }
+            const TransferTablesNBit &tables = transferTablesNBit(depth);
+            convertOklabBlocksToRgb(input, size, mapping, [&](BlockPlanes &linear, std::size_t offset, std::size_t count)
+            {
+                encodeGammaBlock(linear, count, tables, output, offset);
+            });
+        }
+
+        template <typename T>
+        void convertGammaSRGBToOklab(StridedChannels<const T> input, StridedChannels<double> output, std::size_t size, TransferAccuracy accuracy)
+        {
+            convertRgbBlocksToOklab(output, size, [&](std::size_t offset, std::size_t count, BlockPlanes &block)
+            {
+                loadLinearizedBlock(input, offset, count, accuracy, block);
+            });
+        }
+
+        template <typename T>
+        void convertOklabToGammaSRGB(StridedChannels<const double> input, StridedChannels<T> output, std::size_t size, GamutMapping mapping,
+                                 TransferAccuracy accuracy)
+        {
+            convertOklabBlocksToRgb(input, size, mapping, [&](BlockPlanes &linear, std::size_t offset, std::size_t count)
+            {
+                storeEncodedBlock(linear, count, accuracy, output, offset);
+            });
+        }
+    }
+
+    void rgbToOklab(Span<const RGB> input, Span<Oklab> output)
+    {
+        std::size_t size = batchSize(input, output);
+        convertRgbToOklab(stridedChannels(input), stridedChannels(output), size);
+    }
+
+    void rgbToOklab(Planar<const int> input, Planar<double> output)
+    {
+        std::size_t size = batchSize(input, output);
+        convertRgbToOklab(stridedChannels(input), stridedChannels(output), size);
+    }
+
+    void oklabToRgb(Span<const Oklab> input, Span<RGB> output)
+    {
+        std::size_t size = batchSize(input, output);
+        convertOklabToRgb(stridedChannels(input), stridedChannels(output), size, DEFAULT_GAMUT_MAPPING);
+    }
+
+    void oklabToRgb(Span<const Oklab> input, Span<RGB> output, GamutMapping mapping)
+    {
+        std::size_t size = batchSize(input, output);
+        convertOklabToRgb(stridedChannels(input), stridedChannels(output), size, mapping);
+    }
+
+    void oklabToRgb(Planar<const double> input, Planar<int> output)
+    {
+        std::size_t size = batchSize(input, output);
+        convertOklabToRgb(stridedChannels(input), stridedChannels(output), size, DEFAULT_GAMUT_MAPPING);
+    }
+
+    void oklabToRgb(Planar<const double> input, Planar<int> output, GamutMapping mapping)
+    {
+        std::size_t size = batchSize(input, output);
+        convertOklabToRgb(stridedChannels(input), stridedChannels(output), size, mapping);
+    }
+
+    void rgbToOklab(Span<const RGB> input, Span<Oklab> output, BitDepth depth)
+    {
+        std::size_t size = batchSize(input, output);
+        convertRgbToOklab(stridedChannels(input), stridedChannels(output), size, depth);
+    }
+
+    void oklabToRgb(Span<const Oklab> input, Span<RGB> output, BitDepth depth)
+    {
+        std::size_t size = batchSize(input, output);
+        convertOklabToRgb(stridedChannels(input), stridedChannels(output), size, depth, DEFAULT_GAMUT_MAPPING);
+    }
+
+    void oklabToRgb(Span<const Oklab> input, Span<RGB> output, BitDepth depth, GamutMapping mapping)
+    {
+        std::size_t size = batchSize(input, output);
+        convertOklabToRgb(stridedChannels(input), stridedChannels(output), size, depth, mapping);
+    }
+
+    void gammaSRGBToOklab(Span<const GammaSRGB> input, Span<Oklab> output, TransferAccuracy accuracy)
+    {
+        std::size_t size = batchSize(input, output);
+        convertGammaSRGBToOklab(stridedChannels(input), stridedChannels(output), size, accuracy);
+    }
+
+    void gammaSRGBToOklab(Span<const GammaSRGBf> input, Span<Oklab> output, TransferAccuracy accuracy)
+    {
+        std::size_t size = batchSize(input, output);
+        convertGammaSRGBToOklab(stridedChannels(input), stridedChannels(output), size, accuracy);
+    }
+
+    void oklabToGammaSRGB(Span<const Oklab> input, Span<GammaSRGB> output, GamutMapping mapping, TransferAccuracy accuracy)
+    {
+        std::size_t size = batchSize(input, output);
+        convertOklabToGammaSRGB(stridedChannels(input), stridedChannels(output), size, mapping, accuracy);
+    }
+
+    void oklabToGammaSRGB(Span<const Oklab> input, Span<GammaSRGBf> output, GamutMapping mapping, TransferAccuracy accuracy)
+    {
+        std::size_t size = batchSize(input, output);
+        convertOklabToGammaSRGB(stridedChannels(input), stridedChannels(output), size, mapping, accuracy);
+    }
+}
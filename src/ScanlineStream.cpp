@@ -0,0 +1,326 @@
+#include "ScanlineStream.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <stdexcept>
+#include <vector>
+
+#include "BatchKernels.h"
+
+namespace oklab
+{
+    namespace
+    {
+        // Number of whole rows in a buffer of `size` pixels
+        std::size_t rowCount(std::size_t size, std::size_t width)
+        {
+            if (size % width != 0)
+            {
+                throw std::invalid_argument("rows must be whole rows of the image width");
+            }
+            return size / width;
+        }
+
+        // Pixels converted per task, through an Oklab buffer on the stack
+        constexpr std::size_t SEGMENT_SIZE = 256;
+
+        void convertSegment(Span<const P3> input, Span<RGB> output, GamutMapping mapping)
+        {
+            std::array<Oklab, SEGMENT_SIZE> oklab;
+            Span<Oklab> oklabSegment(oklab.data(), input.size());
+            p3ToOklab(input, oklabSegment);
+            oklabToRgb(Span<const Oklab>(oklabSegment), output, mapping);
+        }
+
+        void convertSegment(Span<const RGB> input, Span<P3> output, GamutMapping mapping)
+        {
+            std::array<Oklab, SEGMENT_SIZE> oklab;
+            Span<Oklab> oklabSegment(oklab.data(), input.size());
+            rgbToOklab(input, oklabSegment);
+            oklabToP3(Span<const Oklab>(oklabSegment), output, mapping);
+        }
+
+        void convertSegment(Span<const Oklab> input, Span<RGB> output, GamutMapping mapping)
+        {
+            oklabToRgb(input, output, mapping);
+        }
+
+        void convertSegment(Span<const Oklab> input, Span<P3> output, GamutMapping mapping)
+        {
+            oklabToP3(input, output, mapping);
+        }
+    } // namespace
+
+    template <typename InputType, typename OutputType>
+    struct ScanlineStream<InputType, OutputType>::Strip
+    {
+        std::vector<InputType> input;
+        std::vector<OutputType> output;
+        std::size_t firstRow = 0;
+        std::size_t rowCount = 0;
+    };
+
+    template <typename InputType, typename OutputType>
+    ScanlineStream<InputType, OutputType>::ScanlineStream(std::size_t width, const ScanlineStreamOptions &options)
+        : ScanlineStream(width, nullptr, options)
+    {
+    }
+
+    template <typename InputType, typename OutputType>
+    ScanlineStream<InputType, OutputType>::ScanlineStream(std::size_t width, RowSink sink, const ScanlineStreamOptions &options)
+        : width_(width), mapping_(options.mapping), pool_(options.pool), sink_(std::move(sink))
+    {
+        if (width == 0 || options.stripHeight == 0)
+        {
+            throw std::invalid_argument("a scanline stream needs a width and a strip height of at least 1");
+        }
+
+        // Two strips at least, so that filling one overlaps converting the other
+        const std::size_t rowSize = width * (sizeof(InputType) + sizeof(OutputType));
+        stripHeight_ = std::max<std::size_t>(1, std::min(options.stripHeight, options.maxWorkingMemory / (2 * rowSize)));
+        stripCount_ = std::max<std::size_t>(2, options.maxWorkingMemory / (stripHeight_ * rowSize));
+        strips_.reset(new Strip[stripCount_]);
+
+        converter_ = std::thread([this]() { convert(); });
+        if (sink_)
+        {
+            drainer_ = std::thread([this]() { drainToSink(); });
+        }
+    }
+
+    template <typename InputType, typename OutputType>
+    ScanlineStream<InputType, OutputType>::~ScanlineStream()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            isStopping_ = true;
+        }
+        stripFilled_.notify_all();
+        stripConverted_.notify_all();
+        stripDrained_.notify_all();
+
+        converter_.join();
+        if (drainer_.joinable())
+        {
+            drainer_.join();
+        }
+    }
+
+    template <typename InputType, typename OutputType>
+    typename ScanlineStream<InputType, OutputType>::Strip &ScanlineStream<InputType, OutputType>::beginFilling()
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            stripDrained_.wait(lock, [&]() { return filled_ - drained_ < stripCount_; });
+        }
+
+        // Only this thread advances filled_
+        Strip &strip = strips_[filled_ % stripCount_];
+        if (strip.input.empty())
+        {
+            strip.input.resize(stripHeight_ * width_);
+            strip.output.resize(stripHeight_ * width_);
+        }
+        return strip;
+    }
+
+    template <typename InputType, typename OutputType>
+    void ScanlineStream<InputType, OutputType>::endFilling()
+    {
+        Strip &strip = strips_[filled_ % stripCount_];
+        strip.firstRow = filled_ * stripHeight_;
+        strip.rowCount = filledRows_;
+        filledRows_ = 0;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++filled_;
+        }
+        stripFilled_.notify_all();
+    }
+
+    template <typename InputType, typename OutputType>
+    template <typename CopyRows>
+    void ScanlineStream<InputType, OutputType>::pushRows(std::size_t rowCount, CopyRows copyRows)
+    {
+        assert(!isFinished_);
+
+        for (std::size_t row = 0; row < rowCount;)
+        {
+            Strip &strip = filledRows_ == 0 ? beginFilling() : strips_[filled_ % stripCount_];
+            std::size_t count = std::min(rowCount - row, stripHeight_ - filledRows_);
+            copyRows(row, strip.input.data() + filledRows_ * width_, count);
+            row += count;
+            filledRows_ += count;
+
+            if (filledRows_ == stripHeight_)
+            {
+                endFilling();
+            }
+        }
+    }
+
+    template <typename InputType, typename OutputType>
+    void ScanlineStream<InputType, OutputType>::push(Span<const InputType> rows)
+    {
+        pushRows(rowCount(rows.size(), width_), [&](std::size_t row, InputType *strip, std::size_t count)
+        {
+            std::copy_n(rows.data() + row * width_, count * width_, strip);
+        });
+    }
+
+    template <typename InputType, typename OutputType>
+    void ScanlineStream<InputType, OutputType>::push(Planar<const InputComponent> rows)
+    {
+        pushRows(rowCount(planarSize(rows), width_), [&](std::size_t row, InputType *strip, std::size_t count)
+        {
+            for (std::size_t i = 0, j = row * width_; i < count * width_; ++i, ++j)
+            {
+                strip[i] = InputType{rows.channels[0][j], rows.channels[1][j], rows.channels[2][j]};
+            }
+        });
+    }
+
+    template <typename InputType, typename OutputType>
+    void ScanlineStream<InputType, OutputType>::finish()
+    {
+        if (filledRows_ > 0)
+        {
+            endFilling();
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        isFinished_ = true;
+        stripFilled_.notify_all();
+        stripConverted_.notify_all();
+
+        if (sink_)
+        {
+            stripDrained_.wait(lock, [&]() { return drained_ == filled_; });
+        }
+    }
+
+    template <typename InputType, typename OutputType>
+    void ScanlineStream<InputType, OutputType>::convert()
+    {
+        ThreadPool &pool = pool_ != nullptr ? *pool_ : ThreadPool::shared();
+        for (;;)
+        {
+            Strip *strip;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                stripFilled_.wait(lock, [&]() { return isStopping_ || isFinished_ || converted_ < filled_; });
+                if (isStopping_ || converted_ == filled_)
+                {
+                    return;
+                }
+                strip = &strips_[converted_ % stripCount_];
+            }
+
+            const std::size_t size = strip->rowCount * width_;
+            pool.parallelFor((size + SEGMENT_SIZE - 1) / SEGMENT_SIZE, [&](std::size_t segment)
+            {
+                std::size_t begin = segment * SEGMENT_SIZE;
+                std::size_t count = std::min(SEGMENT_SIZE, size - begin);
+                convertSegment(Span<const InputType>(strip->input.data() + begin, count),
+                               Span<OutputType>(strip->output.data() + begin, count), mapping_);
+            });
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                ++converted_;
+            }
+            stripConverted_.notify_all();
+        }
+    }
+
+    template <typename InputType, typename OutputType>
+    typename ScanlineStream<InputType, OutputType>::Strip *ScanlineStream<InputType, OutputType>::nextConverted(bool isBlocking)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (isBlocking)
+        {
+            stripConverted_.wait(lock, [&]() { return isStopping_ || drained_ < converted_ || (isFinished_ && drained_ == filled_); });
+        }
+        return !isStopping_ && drained_ < converted_ ? &strips_[drained_ % stripCount_] : nullptr;
+    }
+
+    template <typename InputType, typename OutputType>
+    void ScanlineStream<InputType, OutputType>::endDraining()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++drained_;
+        }
+        stripDrained_.notify_all();
+    }
+
+    template <typename InputType, typename OutputType>
+    void ScanlineStream<InputType, OutputType>::drainToSink()
+    {
+        while (Strip *strip = nextConverted(true))
+        {
+            sink_(strip->firstRow, Span<const OutputType>(strip->output.data(), strip->rowCount * width_));
+            endDraining();
+        }
+    }
+
+    template <typename InputType, typename OutputType>
+    template <typename CopyRows>
+    std::size_t ScanlineStream<InputType, OutputType>::pullRows(std::size_t rowCount, CopyRows copyRows)
+    {
+        assert(!sink_);
+
+        // Blocks for the first row only, then takes what is already converted
+        std::size_t row = 0;
+        while (row < rowCount)
+        {
+            Strip *strip = nextConverted(row == 0);
+            if (strip == nullptr)
+            {
+                break;
+            }
+
+            std::size_t count = std::min(rowCount - row, strip->rowCount - pulledRows_);
+            copyRows(row, strip->output.data() + pulledRows_ * width_, count);
+            row += count;
+            pulledRows_ += count;
+
+            if (pulledRows_ == strip->rowCount)
+            {
+                pulledRows_ = 0;
+                endDraining();
+            }
+        }
+        return row;
+    }
+
+    template <typename InputType, typename OutputType>
+    std::size_t ScanlineStream<InputType, OutputType>::pull(Span<OutputType> rows)
+    {
+        return pullRows(rowCount(rows.size(), width_), [&](std::size_t row, const OutputType *strip, std::size_t count)
+        {
+            std::copy_n(strip, count * width_, rows.data() + row * width_);
+        });
+    }
+
+    template <typename InputType, typename OutputType>
+    std::size_t ScanlineStream<InputType, OutputType>::pull(Planar<OutputComponent> rows)
+    {
+        return pullRows(rowCount(planarSize(rows), width_), [&](std::size_t row, const OutputType *strip, std::size_t count)
+        {
+            for (std::size_t i = 0, j = row * width_; i < count * width_; ++i, ++j)
+            {
+                rows.channels[0][j] = strip[i][0];
+                rows.channels[1][j] = strip[i][1];
+                rows.channels[2][j] = strip[i][2];
+            }
+        });
+    }
+
+    template class ScanlineStream<P3, RGB>;
+    template class ScanlineStream<RGB, P3>;
+    template class ScanlineStream<Oklab, RGB>;
+    template class ScanlineStream<Oklab, P3>;
+} // namespace oklab
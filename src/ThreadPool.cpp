@@ -0,0 +1,205 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+
+namespace oklab
+{
+    namespace
+    {
+        // A range of indices [begin, end) packed in one word, so that its owner and thieves can
+        // claim parts of it with a single compare-and-swap
+        struct alignas(64) RangeSlot
+        {
+            std::atomic<std::uint64_t> range;
+        };
+
+        constexpr std::uint64_t packRange(std::uint64_t begin, std::uint64_t end)
+        {
+            return (begin << 32) | end;
+        }
+
+        constexpr std::uint64_t rangeBegin(std::uint64_t range)
+        {
+            return range >> 32;
+        }
+
+        constexpr std::uint64_t rangeEnd(std::uint64_t range)
+        {
+            return range & 0xffffffffu;
+        }
+
+        // Takes the first index of the range of `slot`
+        bool popFront(RangeSlot &slot, std::size_t &index)
+        {
+            std::uint64_t range = slot.range.load(std::memory_order_relaxed);
+            while (rangeBegin(range) < rangeEnd(range))
+            {
+                if (slot.range.compare_exchange_weak(range, packRange(rangeBegin(range) + 1, rangeEnd(range)), std::memory_order_relaxed))
+                {
+                    index = static_cast<std::size_t>(rangeBegin(range));
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Takes the back half of the range of `victim`, the whole range when it has one index
+        bool stealBack(RangeSlot &victim, std::uint64_t &stolen)
+        {
+            std::uint64_t range = victim.range.load(std::memory_order_relaxed);
+            while (rangeBegin(range) < rangeEnd(range))
+            {
+                std::uint64_t middle = rangeBegin(range) + (rangeEnd(range) - rangeBegin(range)) / 2;
+                if (victim.range.compare_exchange_weak(range, packRange(rangeBegin(range), middle), std::memory_order_relaxed))
+                {
+                    stolen = packRange(middle, rangeEnd(range));
+                    return true;
+                }
+            }
+            return false;
+        }
+    } // namespace
+
+    struct ThreadPool::Job
+    {
+        Job(std::size_t count, unsigned threadCount, const std::function<void(std::size_t)> &task)
+            : task(task), slotCount(threadCount), slots(new RangeSlot[threadCount])
+        {
+            for (unsigned slot = 0; slot < threadCount; ++slot)
+            {
+                std::uint64_t begin = count * slot / threadCount;
+                std::uint64_t end = count * (slot + 1) / threadCount;
+                slots[slot].range.store(packRange(begin, end), std::memory_order_relaxed);
+            }
+        }
+
+        // Runs the indices of `slot`, then those stolen from the other slots, until none is left
+        void run(unsigned slot)
+        {
+            for (;;)
+            {
+                std::size_t index;
+                while (popFront(slots[slot], index))
+                {
+                    task(index);
+                }
+
+                bool hasStolen = false;
+                for (unsigned offset = 1; offset < slotCount && !hasStolen; ++offset)
+                {
+                    std::uint64_t stolen;
+                    if (stealBack(slots[(slot + offset) % slotCount], stolen))
+                    {
+                        // Empty until now: nobody else writes it or steals from it
+                        slots[slot].range.store(stolen, std::memory_order_relaxed);
+                        hasStolen = true;
+                    }
+                }
+
+                if (!hasStolen)
+                {
+                    return;
+                }
+            }
+        }
+
+        const std::function<void(std::size_t)> &task;
+        unsigned slotCount;
+        std::unique_ptr<RangeSlot[]> slots;
+    };
+
+    ThreadPool::ThreadPool(unsigned threadCount)
+    {
+        if (threadCount == 0)
+        {
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        // Slot 0 belongs to the calling thread
+        for (unsigned slot = 1; slot < threadCount; ++slot)
+        {
+            workers_.emplace_back([this, slot]() { work(slot); });
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            isStopping_ = true;
+        }
+        jobStarted_.notify_all();
+
+        for (std::thread &worker : workers_)
+        {
+            worker.join();
+        }
+    }
+
+    void ThreadPool::work(unsigned slot)
+    {
+        std::uint64_t seenGeneration = 0;
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;)
+        {
+            jobStarted_.wait(lock, [&]() { return isStopping_ || (job_ != nullptr && generation_ != seenGeneration); });
+            if (isStopping_)
+            {
+                return;
+            }
+
+            seenGeneration = generation_;
+            Job *job = job_;
+            ++joinedWorkers_;
+            lock.unlock();
+
+            job->run(slot);
+
+            lock.lock();
+            if (--joinedWorkers_ == 0)
+            {
+                workersLeft_.notify_all();
+            }
+        }
+    }
+
+    void ThreadPool::parallelFor(std::size_t count, const std::function<void(std::size_t)> &task)
+    {
+        // Ranges pack two indices in one word
+        if (count >= (std::size_t{1} << 32))
+        {
+            throw std::invalid_argument("parallelFor runs fewer than 2^32 tasks");
+        }
+        if (count == 0)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> call(callMutex_);
+        Job job(count, threadCount(), task);
+
+        if (!workers_.empty())
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            job_ = &job;
+            ++generation_;
+        }
+        jobStarted_.notify_all();
+
+        job.run(0);
+
+        // Every index is claimed: once the workers that joined have left, all have run
+        std::unique_lock<std::mutex> lock(mutex_);
+        job_ = nullptr;
+        workersLeft_.wait(lock, [&]() { return joinedWorkers_ == 0; });
+    }
+
+    ThreadPool &ThreadPool::shared()
+    {
+        static ThreadPool pool;
+        return pool;
+    }
+} // namespace oklab
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include "TransferFunctions.h"
+
+/**
+ * @file TransferApprox.h
+ * @brief Provides branchless polynomial approximations of the sRGB / Display P3 transfer functions.
+ *
+ * `x^2.4` and `x^(1/2.4)` are evaluated as `exp2(y * log2(x))`:
+ * - log2 splits x into an exponent and a mantissa in [sqrt(1/2), sqrt(2)) with integer operations,
+ *   then evaluates the atanh series `ln(m) = 2 (u + u^3/3 + u^5/5 + ...)`, `u = (m - 1) / (m + 1)`;
+ * - exp2 splits its input into a nearest integer and a fraction in [-1/2, 1/2], evaluates the
+ *   Taylor series of `e^(f ln 2)` and rebuilds the power of two in the exponent bits.
+ * The number of series terms sets the accuracy; the linear segment and the sign are applied
+ * with selects instead of branches.
+ *
+ * All functions are generic over `Value`, either `double` or a GCC/Clang vector of doubles, so
+ * the scalar functions and the SIMD kernels share the same code. They have internal linkage:
+ * the SIMD kernels compile them with wider target flags, which must never leak into other
+ * translation units. Inputs must be finite.
+ */
+
+namespace oklab
+{
+    namespace
+    {
+        namespace transferApprox
+        {
+            // Integer type with the same layout as Value: int64_t, or a vector of int64.
+            template <typename Value>
+            struct IntegerOf
+            {
+                using type = decltype(Value{} < Value{});
+            };
+
+            template <>
+            struct IntegerOf<double>
+            {
+                using type = std::int64_t;
+            };
+
+            template <typename To, typename From>
+            inline To bitCast(const From &from)
+            {
+                static_assert(sizeof(To) == sizeof(From), "bitCast requires types of the same size");
+                To to;
+                std::memcpy(&to, &from, sizeof(To));
+                return to;
+            }
+
+            constexpr std::int64_t SIGN_MASK = INT64_MIN;
+            constexpr std::int64_t SQRT_HALF_BITS = 0x3fe6a09e667f3bcdLL; // sqrt(1/2)
+            constexpr double ROUNDING_MAGIC = 6755399441055744.0;         // 1.5 * 2^52
+            constexpr std::int64_t ROUNDING_MAGIC_BITS = 0x4338000000000000LL;
+            constexpr double LN2 = 0.693147180559945309417;
+            constexpr double INV_LN2 = 1.442695040888963407360;
+
+            /**
+             * @brief log2(x) for x > 0, using `LogTerms` terms of the atanh series.
+             */
+            template <int LogTerms, typename Value>
+            inline Value log2(Value x)
+            {
+                using Integer = typename IntegerOf<Value>::type;
+
+                // x = m * 2^k with m in [sqrt(1/2), sqrt(2))
+                Integer bits = bitCast<Integer>(x);
+                Integer k = (bits - SQRT_HALF_BITS) >> 52;
+                Value m = bitCast<Value>(bits - (k << 52));
+                Value exponent = bitCast<Value>(k + ROUNDING_MAGIC_BITS) - ROUNDING_MAGIC;
+
+                Value u = (m - 1.0) / (m + 1.0);
+                Value u2 = u * u;
+
+                Value series = Value{} + 1.0 / (2 * LogTerms - 1);
+                for (int term = LogTerms - 2; term >= 0; --term)
+                {
+                    series = series * u2 + 1.0 / (2 * term + 1);
+                }
+
+                return exponent + (2.0 * INV_LN2) * u * series;
+            }
+
+            /**
+             * @brief 2^x for x in [-1000, 1000], using a Taylor polynomial of degree `ExpDegree`.
+             */
+            template <int ExpDegree, typename Value>
+            inline Value exp2(Value x)
+            {
+                using Integer = typename IntegerOf<Value>::type;
+
+                // x = n + f with n integer and f in [-1/2, 1/2]
+                Value shifted = x + ROUNDING_MAGIC;
+                Integer n = bitCast<Integer>(shifted) - ROUNDING_MAGIC_BITS;
+                Value f = (x - (shifted - ROUNDING_MAGIC)) * LN2;
+
+                // Horner form of the Taylor series: 1 + f (1 + f/2 (1 + f/3 (...)))
+                Value polynomial = Value{} + 1.0;
+                for (int degree = ExpDegree; degree >= 1; --degree)
+                {
+                    polynomial = 1.0 + polynomial * f * (1.0 / degree);
+                }
+
+                return polynomial * bitCast<Value>((n + 1023) << 52);
+            }
+
+            template <typename Value>
+            inline Value abs(Value x)
+            {
+                using Integer = typename IntegerOf<Value>::type;
+                return bitCast<Value>(bitCast<Integer>(x) & ~SIGN_MASK);
+            }
+
+            template <typename Value>
+            inline Value copySign(Value magnitude, Value sign)
+            {
+                using Integer = typename IntegerOf<Value>::type;
+                return bitCast<Value>(bitCast<Integer>(magnitude) | (bitCast<Integer>(sign) & SIGN_MASK));
+            }
+
+            /**
+             * @brief Branchless approximation of `gammaToLinear`.
+             */
+            template <int LogTerms, int ExpDegree, typename Value>
+            inline Value gammaToLinearSeries(Value value)
+            {
+                Value absValue = abs(value);
+                Value linear = absValue * (1.0 / 12.92);
+                Value curve = exp2<ExpDegree>(2.4 * log2<LogTerms>((absValue + 0.055) * (1.0 / 1.055)));
+                return copySign((absValue <= 0.04045) ? linear : curve, value);
+            }
+
+            /**
+             * @brief Branchless approximation of `linearToGamma`.
+             */
+            template <int LogTerms, int ExpDegree, typename Value>
+            inline Value linearToGammaSeries(Value value)
+            {
+                Value absValue = abs(value);
+                // Keep log2 away from zero and denormals; the linear segment covers these values.
+                Value clamped = (absValue < 0.0031308) ? (Value{} + 0.0031308) : absValue;
+                Value linear = absValue * 12.92;
+                Value curve = 1.055 * exp2<ExpDegree>((1.0 / 2.4) * log2<LogTerms>(clamped)) - 0.055;
+                return copySign((absValue <= 0.0031308) ? linear : curve, value);
+            }
+
+            /**
+             * @brief Series lengths of each approximated accuracy tier.
+             */
+            template <TransferAccuracy Accuracy>
+            struct Tier;
+
+            template <>
+            struct Tier<TransferAccuracy::Precise>
+            {
+                static constexpr int LOG_TERMS = 4;
+                static constexpr int EXP_DEGREE = 7;
+            };
+
+            template <>
+            struct Tier<TransferAccuracy::EightBit>
+            {
+                static constexpr int LOG_TERMS = 2;
+                static constexpr int EXP_DEGREE = 4;
+            };
+
+            /**
+             * @brief Branchless approximation of `gammaToLinear` at the given accuracy tier.
+             */
+            template <TransferAccuracy Accuracy, typename Value>
+            inline Value gammaToLinear(Value value)
+            {
+                return gammaToLinearSeries<Tier<Accuracy>::LOG_TERMS, Tier<Accuracy>::EXP_DEGREE>(value);
+            }
+
+            /**
+             * @brief Branchless approximation of `linearToGamma` at the given accuracy tier.
+             */
+            template <TransferAccuracy Accuracy, typename Value>
+            inline Value linearToGamma(Value value)
+            {
+                return linearToGammaSeries<Tier<Accuracy>::LOG_TERMS, Tier<Accuracy>::EXP_DEGREE>(value);
+            }
+        } // namespace transferApprox
+    } // namespace
+} // namespace oklab
@@ -0,0 +1,181 @@
+#include "TransferTables.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace oklab
+{
+    namespace
+    {
+        int encodeWithPow(double value)
+        {
+            return static_cast<int>(std::round(linearToGamma(value) * 255.0));
+        }
+
+        // Non-negative doubles sort like their bit patterns, so bisecting on the bits
+        // finds the exact smallest value encoded to `code`.
+        double findThreshold(int code)
+        {
+            std::uint64_t low;
+            std::uint64_t high;
+            double zero = 0.0;
+            double one = 1.0;
+            std::memcpy(&low, &zero, sizeof(double));
+            std::memcpy(&high, &one, sizeof(double));
+
+            while (low < high)
+            {
+                std::uint64_t middle = low + (high - low) / 2;
+                double value;
+                std::memcpy(&value, &middle, sizeof(double));
+
+                if (encodeWithPow(value) >= code)
+                {
+                    high = middle;
+                }
+                else
+                {
+                    low = middle + 1;
+                }
+            }
+
+            double threshold;
+            std::memcpy(&threshold, &low, sizeof(double));
+            return threshold;
+        }
+
+        std::uint64_t toBits(double value)
+        {
+            std::uint64_t bits;
+            std::memcpy(&bits, &value, sizeof(double));
+            return bits;
+        }
+
+        double fromBits(std::uint64_t bits)
+        {
+            double value;
+            std::memcpy(&value, &bits, sizeof(double));
+            return value;
+        }
+
+        int encodeWithPow(double value, int maxCode)
+        {
+            return static_cast<int>(std::round(linearToGamma(value) * maxCode));
+        }
+
+        // Same search as findThreshold, over a bracket around the decoded midpoint between
+        // `code - 1` and `code`: widening it from a few ulps keeps deep tables cheap to build.
+        double findThreshold(int code, int maxCode)
+        {
+            const std::uint64_t zero = toBits(0.0);
+            const std::uint64_t one = toBits(1.0);
+            const std::uint64_t middle = toBits(gammaToLinear((code - 0.5) / maxCode));
+
+            std::uint64_t low = middle;
+            std::uint64_t high = middle;
+            for (std::uint64_t width = 16; low > zero && encodeWithPow(fromBits(low), maxCode) >= code; width *= 2)
+            {
+                low = middle - zero > width ? middle - width : zero;
+            }
+            for (std::uint64_t width = 16; high < one && encodeWithPow(fromBits(high), maxCode) < code; width *= 2)
+            {
+                high = one - middle > width ? middle + width : one;
+            }
+
+            while (low < high)
+            {
+                std::uint64_t bisection = low + (high - low) / 2;
+                if (encodeWithPow(fromBits(bisection), maxCode) >= code)
+                {
+                    high = bisection;
+                }
+                else
+                {
+                    low = bisection + 1;
+                }
+            }
+            return fromBits(low);
+        }
+
+        TransferTablesNBit buildTransferTables(BitDepth depth)
+        {
+            TransferTablesNBit tables;
+            tables.maxCode = maxCodeValue(depth);
+            tables.decode.resize(tables.maxCode + 1);
+            tables.encodeThresholds.resize(tables.maxCode + 2);
+
+            for (int code = 0; code <= tables.maxCode; ++code)
+            {
+                tables.decode[code] = gammaToLinear(code / static_cast<double>(tables.maxCode));
+            }
+
+            tables.encodeThresholds[0] = 0.0;
+            for (int code = 1; code <= tables.maxCode; ++code)
+            {
+                tables.encodeThresholds[code] = findThreshold(code, tables.maxCode);
+            }
+            tables.encodeThresholds[tables.maxCode + 1] = std::numeric_limits<double>::infinity();
+
+            return tables;
+        }
+
+        TransferTables8Bit buildTransferTables()
+        {
+            TransferTables8Bit tables;
+
+            for (int code = 0; code < 256; ++code)
+            {
+                tables.decode[code] = gammaToLinear(code / 255.0);
+            }
+
+            tables.encodeThresholds[0] = 0.0;
+            for (int code = 1; code < 256; ++code)
+            {
+                tables.encodeThresholds[code] = findThreshold(code);
+            }
+            tables.encodeThresholds[256] = std::numeric_limits<double>::infinity();
+
+            for (int bucket = 0; bucket <= ENCODE_TABLE_BUCKETS; ++bucket)
+            {
+                tables.encodeBuckets[bucket] = static_cast<unsigned char>(encodeWithPow(static_cast<double>(bucket) / ENCODE_TABLE_BUCKETS));
+            }
+
+            return tables;
+        }
+    } // namespace
+
+    const TransferTables8Bit &transferTables8Bit()
+    {
+        static const TransferTables8Bit tables = buildTransferTables();
+        return tables;
+    }
+
+    const TransferTablesNBit &transferTablesNBit(BitDepth depth)
+    {
+        switch (depth)
+        {
+        case BitDepth::Eight:
+        {
+            static const TransferTablesNBit tables = buildTransferTables(BitDepth::Eight);
+            return tables;
+        }
+        case BitDepth::Ten:
+        {
+            static const TransferTablesNBit tables = buildTransferTables(BitDepth::Ten);
+            return tables;
+        }
+        case BitDepth::Twelve:
+        {
+            static const TransferTablesNBit tables = buildTransferTables(BitDepth::Twelve);
+            return tables;
+        }
+        default:
+        {
+            static const TransferTablesNBit tables = buildTransferTables(BitDepth::Sixteen);
+            return tables;
+        }
+        }
+    }
+} // namespace oklab
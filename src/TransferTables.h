@@ -0,0 +1,173 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "ColorTypes.h"
+#include "ColorUtils.h"
+
+/**
+ * @file TransferTables.h
+ * @brief Provides table-driven transfer functions for integer gamma-encoded values.
+ *
+ * sRGB and Display P3 share the same transfer function, so one pair of tables serves both.
+ * Results are bit-identical to the pow-based `gammaToLinear` / `linearToGamma`:
+ * - decoding reads the 256 precomputed values of `gammaToLinear(code / 255.0)`;
+ * - encoding maps a linear value in [0, 1] to a bucket of a high-resolution table, then
+ *   compares it against the exact linear threshold of the next code. Thresholds are the
+ *   smallest doubles the pow-based path rounds to each code, and buckets are narrower than
+ *   the smallest gap between two thresholds, so a bucket spans at most one code change.
+ *
+ * Deeper codes (`BitDepth`) have the same decoding table and exact thresholds, without buckets:
+ * encoding starts from an estimate of the code, the value of a polynomial transfer function,
+ * and moves it to the code whose thresholds surround the value.
+ */
+
+namespace oklab
+{
+    /**
+     * @brief Number of buckets of the encoding table over [0, 1].
+     */
+    constexpr int ENCODE_TABLE_BUCKETS = 4096;
+
+    /**
+     * @brief Precomputed tables for 8-bit gamma decoding and encoding.
+     */
+    struct TransferTables8Bit
+    {
+        /** `gammaToLinear(code / 255.0)` for each code. */
+        double decode[256];
+
+        /** Code of the first linear value of each bucket `[b, b + 1) / ENCODE_TABLE_BUCKETS`. */
+        unsigned char encodeBuckets[ENCODE_TABLE_BUCKETS + 1];
+
+        /** Smallest linear value encoded to each code; `encodeThresholds[256]` is +infinity. */
+        double encodeThresholds[257];
+    };
+
+    /**
+     * @brief Returns the 8-bit transfer tables, computing them on first use.
+     */
+    const TransferTables8Bit &transferTables8Bit();
+
+    // The helpers below have internal linkage on purpose: they are also compiled into the
+    // SIMD kernels with wider target flags, which must never be shared with other translation units.
+
+    /**
+     * @brief Converts an 8-bit gamma-encoded code to a linear light value.
+     *
+     * Equivalent to `gammaToLinear(code / 255.0)`; codes outside [0, 255] use the pow-based path.
+     */
+    static inline double gammaToLinear8Bit(const TransferTables8Bit &tables, int code)
+    {
+        if (static_cast<unsigned>(code) <= 255u)
+        {
+            return tables.decode[code];
+        }
+        return gammaToLinear(code / 255.0);
+    }
+
+    /**
+     * @brief Converts a linear light value to an 8-bit gamma-encoded code.
+     *
+     * Equivalent to `static_cast<int>(std::round(linearToGamma(value) * 255.0))`;
+     * values outside [0, 1] use the pow-based path.
+     */
+    static inline int linearToGamma8Bit(const TransferTables8Bit &tables, double value)
+    {
+        if (value >= 0.0 && value <= 1.0)
+        {
+            int code = tables.encodeBuckets[static_cast<int>(value * ENCODE_TABLE_BUCKETS)];
+            return value >= tables.encodeThresholds[code + 1] ? code + 1 : code;
+        }
+        return static_cast<int>(std::round(linearToGamma(value) * 255.0));
+    }
+
+    /**
+     * @brief Precomputed tables for the gamma decoding and encoding of one bit depth.
+     */
+    struct TransferTablesNBit
+    {
+        /** Largest code, `maxCodeValue(depth)`. */
+        int maxCode;
+
+        /** `gammaToLinear(code / double(maxCode))` for each code. */
+        std::vector<double> decode;
+
+        /** Smallest linear value encoded to each code; the entry after the largest code is +infinity. */
+        std::vector<double> encodeThresholds;
+    };
+
+    /**
+     * @brief Returns the transfer tables of a bit depth, computing them on first use.
+     */
+    const TransferTablesNBit &transferTablesNBit(BitDepth depth);
+
+    /**
+     * @brief Converts a gamma-encoded code of the tables' depth to a linear light value.
+     *
+     * Equivalent to `gammaToLinear(code / double(maxCode))`; codes outside [0, maxCode] use the
+     * pow-based path.
+     */
+    static inline double gammaToLinearNBit(const TransferTablesNBit &tables, int code)
+    {
+        if (static_cast<unsigned>(code) <= static_cast<unsigned>(tables.maxCode))
+        {
+            return tables.decode[code];
+        }
+        return gammaToLinear(code / static_cast<double>(tables.maxCode));
+    }
+
+    /**
+     * @brief Converts a linear light value to a gamma-encoded code of the tables' depth.
+     *
+     * Equivalent to `static_cast<int>(std::round(linearToGamma(value) * maxCode))`, starting the
+     * search from `estimate`, an approximation of `linearToGamma(value)`. Values outside [0, 1]
+     * use the pow-based path.
+     */
+    static inline int linearToGammaNBit(const TransferTablesNBit &tables, double value, double estimate)
+    {
+        if (value >= 0.0 && value <= 1.0)
+        {
+            const double *thresholds = tables.encodeThresholds.data();
+            int code = std::clamp(static_cast<int>(estimate * tables.maxCode + 0.5), 0, tables.maxCode);
+            while (value < thresholds[code])
+            {
+                --code;
+            }
+            while (value >= thresholds[code + 1])
+            {
+                ++code;
+            }
+            return code;
+        }
+        return static_cast<int>(std::round(linearToGamma(value) * tables.maxCode));
+    }
+
+    /**
+     * @brief Converts a linear light value to a gamma-encoded code of the tables' depth.
+     *
+     * Equivalent to `static_cast<int>(std::round(linearToGamma(value) * maxCode))`, by bisecting
+     * the thresholds.
+     */
+    static inline int linearToGammaNBit(const TransferTablesNBit &tables, double value)
+    {
+        if (value >= 0.0 && value <= 1.0)
+        {
+            auto firstAbove = std::upper_bound(tables.encodeThresholds.begin() + 1, tables.encodeThresholds.end(), value);
+            return static_cast<int>(firstAbove - (tables.encodeThresholds.begin() + 1));
+        }
+        return static_cast<int>(std::round(linearToGamma(value) * tables.maxCode));
+    }
+
+    static inline double gammaToLinear8Bit(int code)
+    {
+        return gammaToLinear8Bit(transferTables8Bit(), code);
+    }
+
+    static inline int linearToGamma8Bit(double value)
+    {
+        return linearToGamma8Bit(transferTables8Bit(), value);
+    }
+} // namespace oklab
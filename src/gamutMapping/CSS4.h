@@ -1,14 +1,14 @@
 #pragma once
 
+#include <cmath>
+
 #include "ColorTypes.h"
+#include "GamutMappingFormulas.h"
 
 #include "../ColorUtils.h"
+#include "../MathUtils.h"
 #include "../OkLxx.h"
-
-#ifdef DEBUG_LOOP_COUNT
-#include <iostream>
-#include <iomanip>
-#endif
+#include "Telemetry.h"
 
 /**
  * @file gamutMapping/CSS4.h
@@ -24,141 +24,140 @@ namespace oklab
     bool isInGamut(const LinearColorType &color);
 
     template <typename LinearColorType>
-    LinearColorType oklabToLinearColor(const Oklab &oklab);
+    LinearColorType oklabToLinearColor(const BasicOklab<typename LinearColorType::value_type> &oklab);
 
     template <typename LinearColorType, typename ColorType>
     ColorType linearColorToColor(const LinearColorType &linearColor);
 
     template <typename LinearColorType>
-    Oklab linearColorToOklab(const LinearColorType &linearColor);
+    BasicOklab<typename LinearColorType::value_type> linearColorToOklab(const LinearColorType &linearColor);
 
+    /**
+     * @brief The `Space` policy of GamutMappingFormulas.h bound to the hooks above, for a target
+     * color type and the linear color type the mapping runs in.
+     */
     template <typename ColorType, typename LinearColorType>
-    ColorType performCssGamutMapping(const Oklab &oklab);
-
-    template <typename ColorType, typename LinearColorType>
-    ColorType performCssGamutMapping(const Oklab &oklab)
+    struct LibrarySpace
     {
-        Oklch oklch = oklabToOklch(oklab);
+        using Color = ColorType;
+        using LinearColor = LinearColorType;
+        using Scalar = typename LinearColorType::value_type;
 
-        if (oklch[0] >= 1)
+        static LinearColorType toLinear(const BasicOklab<Scalar> &oklab)
         {
-            return ColorType{255, 255, 255};
+            return oklabToLinearColor<LinearColorType>(oklab);
         }
 
-        if (oklch[0] <= 0)
+        static BasicOklab<Scalar> toOklab(const LinearColorType &linearColor)
         {
-            return ColorType{0, 0, 0};
+            return linearColorToOklab<LinearColorType>(linearColor);
         }
 
-        LinearColorType linearColor = oklabToLinearColor<LinearColorType>(oklab);
-
-        if (isInGamut(linearColor))
+        static BasicPolarOklab<Scalar> toPolar(const BasicOklab<Scalar> &oklab)
         {
-            return linearColorToColor<LinearColorType, ColorType>(linearColor);
+            return oklabToPolar(oklab);
         }
 
-        const double JUST_NON_DISCERNIBLE = 0.02;
-        const double EPSILON = 0.0001;
-
-        LinearColorType clippedLinearColor = clipToGamut<LinearColorType>(linearColor);
-        Oklab clippedOklab = linearColorToOklab<LinearColorType>(clippedLinearColor);
-
-        double E = deltaE(clippedLinearColor, oklab);
-
-        if (E < JUST_NON_DISCERNIBLE)
+        static bool isInGamut(const LinearColorType &linearColor)
         {
-            return linearColorToColor<LinearColorType, ColorType>(clippedLinearColor);
+            return oklab::isInGamut<LinearColorType>(linearColor);
         }
 
-        double minChroma = 0.0;
-        double maxChroma = oklch[1];
+        static LinearColorType clip(const LinearColorType &linearColor)
+        {
+            return clipToGamut<LinearColorType>(linearColor);
+        }
 
-        bool isMinChromaInGamut = true;
+        static ColorType encode(const LinearColorType &linearColor)
+        {
+            return linearColorToColor<LinearColorType, ColorType>(linearColor);
+        }
 
-        Oklch optimisedOklch = {oklch[0], oklch[1], oklch[2]};
+        static Scalar deltaE(const BasicOklab<Scalar> &oklab1, const BasicOklab<Scalar> &oklab2)
+        {
+            return oklab::deltaE(oklab1, oklab2);
+        }
 
-#ifdef DEBUG_LOOP_COUNT
-        int loopCount = 0;
-#endif
+        static Scalar sqrt(Scalar value)
+        {
+            return std::sqrt(value);
+        }
 
-        while (maxChroma - minChroma > EPSILON)
+        static Scalar cbrt(Scalar value)
         {
-#ifdef DEBUG_LOOP_COUNT
-            ++loopCount;
-#endif
-            double optimisedChroma = (minChroma + maxChroma) / 2.0;
+            return oklab::cbrt(value);
+        }
+    };
 
-            optimisedOklch = Oklch{oklch[0], optimisedChroma, oklch[2]};
-            Oklab optimisedOklab = oklchToOklab(optimisedOklch);
-            LinearColorType optimisedLinearColor = oklabToLinearColor<LinearColorType>(optimisedOklab);
+    namespace css4
+    {
+        using formulas::css4::EPSILON;
+        using formulas::css4::JUST_NON_DISCERNIBLE;
 
-            if (isMinChromaInGamut && isInGamut<LinearColorType>(optimisedLinearColor))
+        inline telemetry::Counter telemetryCounter(formulas::css4::Exit exit)
+        {
+            switch (exit)
             {
-                minChroma = optimisedChroma;
-#ifdef DEBUG_LOOP_COUNT
-                std::cerr << "Loop " << loopCount << ": Chroma adjusted to "
-                          << std::fixed << std::setprecision(4) << optimisedChroma
-                          << " - Min chroma is in Gamut. Oklab ("
-                          << std::fixed << std::setprecision(4) << optimisedOklab[0] << ", "
-                          << std::fixed << std::setprecision(4) << optimisedOklab[1] << ", "
-                          << std::fixed << std::setprecision(4) << optimisedOklab[2] << ")\n";
-#endif
+            case formulas::css4::Exit::White:
+                return telemetry::WHITE_EXITS;
+            case formulas::css4::Exit::Black:
+                return telemetry::BLACK_EXITS;
+            case formulas::css4::Exit::InGamut:
+                return telemetry::IN_GAMUT_EXITS;
+            case formulas::css4::Exit::Clip:
+                return telemetry::CLIP_EXITS;
+            case formulas::css4::Exit::Threshold:
+                return telemetry::THRESHOLD_EXITS;
+            default:
+                return telemetry::CONVERGED_EXITS;
             }
-            else
+        }
+
+        /**
+         * @brief The exits of `performCssGamutMapping` before its chroma search, recorded by the
+         * telemetry (`formulas::css4::mapWithoutSearch`).
+         *
+         * Returns true with the mapped `color` for white, black, colors in gamut and colors whose
+         * clipping is not noticeable. Otherwise returns false with the `polar` form of the color,
+         * whose chroma line the search follows, and its clipped linear color, the result of a
+         * search deciding no candidate.
+         */
+        template <typename ColorType, typename LinearColorType>
+        bool mapWithoutSearch(const BasicOklab<typename LinearColorType::value_type> &oklab, ColorType &color,
+                              BasicPolarOklab<typename LinearColorType::value_type> &polar, LinearColorType &clippedLinearColor)
+        {
+            formulas::css4::Exit exit =
+                formulas::css4::mapWithoutSearch<LibrarySpace<ColorType, LinearColorType>>(oklab, color, polar, clippedLinearColor);
+            if (exit == formulas::css4::Exit::Search)
             {
-                clippedLinearColor = clipToGamut<LinearColorType>(optimisedLinearColor);
-                Oklab clippedOklab = linearColorToOklab<LinearColorType>(clippedLinearColor);
-
-                E = deltaE(clippedOklab, optimisedOklab);
-
-                if (E < JUST_NON_DISCERNIBLE)
-                {
-                    if (JUST_NON_DISCERNIBLE - E < EPSILON) [[unlikely]]
-                    {
-#ifdef DEBUG_LOOP_COUNT
-                        std::cerr << "Loop " << loopCount << ": Chroma adjusted to "
-                                  << std::fixed << std::setprecision(4) << optimisedChroma
-                                  << " - Optimised TADA. Oklab ("
-                                  << std::fixed << std::setprecision(4) << optimisedOklab[0] << ", "
-                                  << std::fixed << std::setprecision(4) << optimisedOklab[1] << ", "
-                                  << std::fixed << std::setprecision(4) << optimisedOklab[2] << ")\n";
-#endif
-                        break;
-                    }
-                    else
-                    {
-                        isMinChromaInGamut = false;
-                        minChroma = optimisedChroma;
-#ifdef DEBUG_LOOP_COUNT
-                        std::cerr << "Loop " << loopCount << ": Chroma adjusted to "
-                                  << std::fixed << std::setprecision(4) << optimisedChroma
-                                  << " - Min chroma is out of Gamut - Update Min Chroma. Oklab ("
-                                  << std::fixed << std::setprecision(4) << optimisedOklab[0] << ", "
-                                  << std::fixed << std::setprecision(4) << optimisedOklab[1] << ", "
-                                  << std::fixed << std::setprecision(4) << optimisedOklab[2] << ")\n";
-#endif
-                    }
-                }
-                else [[unlikely]]
-                {
-                    maxChroma = optimisedChroma;
-#ifdef DEBUG_LOOP_COUNT
-                    std::cerr << "Loop " << loopCount << ": Chroma adjusted to "
-                              << std::fixed << std::setprecision(4) << optimisedChroma
-                              << " - Min chroma is out of Gamut - Update Max Chroma. Oklab ("
-                              << std::fixed << std::setprecision(4) << optimisedOklab[0] << ", "
-                              << std::fixed << std::setprecision(4) << optimisedOklab[1] << ", "
-                              << std::fixed << std::setprecision(4) << optimisedOklab[2] << ")\n";
-#endif
-                    continue;
-                }
+                return false;
             }
+
+            telemetry::record(telemetryCounter(exit));
+            return true;
         }
+    }
+
+    template <typename ColorType, typename LinearColorType>
+    ColorType performCssGamutMapping(const BasicOklab<typename LinearColorType::value_type> &oklab)
+    {
+        // Computations run in the precision of the linear color type (double or float).
+        using Scalar = typename LinearColorType::value_type;
+
+        ColorType color;
+        BasicPolarOklab<Scalar> polar;
+        LinearColorType clippedLinearColor;
+        if (css4::mapWithoutSearch(oklab, color, polar, clippedLinearColor))
+        {
+            return color;
+        }
+
+        int iterations = 0;
 
-#ifdef DEBUG_LOOP_COUNT
-        std::cerr << "CSS4 gamut mapping loop executed " << loopCount << " times" << "\n ";
-#endif
+        // The bisection of CSS Color 4, shared with the constexpr conversions
+        formulas::css4::Exit exit = formulas::css4::bisect<LibrarySpace<ColorType, LinearColorType>>(polar, clippedLinearColor, iterations);
 
+        telemetry::recordSearch(css4::telemetryCounter(exit), iterations);
         return linearColorToColor<LinearColorType, ColorType>(clipToGamut<LinearColorType>(clippedLinearColor));
     }
 }
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "ColorTypes.h"
+#include "GamutMappingFormulas.h"
+
+#include "CSS4.h" // Color space hooks shared by the mapping algorithms
+
+/**
+ * @file gamutMapping/Cusp.h
+ * @brief Provides the analytic cusp-based gamut mapping, an alternative to the CSS4 bisection.
+ *
+ * Implements the gamut clipping of Björn Ottosson ("sRGB gamut clipping", 2021), keeping
+ * lightness and hue like CSS4. In a plane of constant hue, the gamut boundary is a straight
+ * line from black to the cusp (the most saturated color) and a curve from the cusp to white:
+ * - the saturation of the cusp is approximated by a polynomial in the hue direction `(a, b)`,
+ *   then refined with Halley steps on the linear channel that reaches 0 (two instead of the
+ *   published one, which leaves visible errors next to the blue primary);
+ * - below the cusp, the boundary is intersected exactly;
+ * - above, the triangle cusp-white gives an estimate, refined with one Halley step on the
+ *   channels reaching 1.
+ * The result is clipped to remove the residual error of the approximation. The algorithm is
+ * `formulas::cusp::map` of GamutMappingFormulas.h, shared with the constexpr conversions.
+ *
+ * On all 2^24 P3 colors converted to sRGB, the conversions run ~5x faster than with CSS4. The
+ * mapped chroma is within 0.001 of the exact boundary for all but 0.01% of the out-of-gamut
+ * colors, which sit next to the blue primary, where the boundary of a constant hue plane folds.
+ * Outputs differ from CSS4 by up to 0.055 deltaE (90% below 0.02): CSS4 keeps colors slightly
+ * out of gamut when clipping them is not noticeable, this mapping lands on the boundary.
+ */
+
+namespace oklab
+{
+    template <typename ColorType, typename LinearColorType>
+    ColorType performCuspGamutMapping(const BasicOklab<typename LinearColorType::value_type> &oklab)
+    {
+        return formulas::cusp::map<LibrarySpace<ColorType, LinearColorType>>(oklab);
+    }
+}
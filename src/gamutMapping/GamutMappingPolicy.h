@@ -0,0 +1,70 @@
+#pragma once
+
+#include <type_traits>
+
+#include "GamutMapping.h"
+#include "ColorTypes.h"
+
+#include "CSS4.h"
+#include "Cusp.h"
+
+/**
+ * @file gamutMapping/GamutMappingPolicy.h
+ * @brief Turns the `GamutMapping` enum into a compile-time policy of the conversions.
+ *
+ * Conversion code is templated on the algorithm; the runtime value of the public API is
+ * dispatched once per call (once per buffer for the batch conversions), so the per-pixel loops
+ * contain no test of the algorithm.
+ */
+
+namespace oklab
+{
+    template <GamutMapping Mapping>
+    using GamutMappingConstant = std::integral_constant<GamutMapping, Mapping>;
+
+    /**
+     * @brief Calls `function` with the `GamutMappingConstant` of `mapping` and returns its result.
+     */
+    template <typename Function>
+    decltype(auto) dispatchGamutMapping(GamutMapping mapping, Function &&function)
+    {
+        switch (mapping)
+        {
+        case GamutMapping::Css4:
+            return function(GamutMappingConstant<GamutMapping::Css4>{});
+        case GamutMapping::Cusp:
+            return function(GamutMappingConstant<GamutMapping::Cusp>{});
+        case GamutMapping::Clamp:
+            return function(GamutMappingConstant<GamutMapping::Clamp>{});
+        case GamutMapping::None:
+        default:
+            return function(GamutMappingConstant<GamutMapping::None>{});
+        }
+    }
+
+    /**
+     * @brief Converts an Oklab color to `ColorType`, bringing it into the gamut of
+     * `LinearColorType` with `Mapping`.
+     */
+    template <GamutMapping Mapping, typename ColorType, typename LinearColorType>
+    ColorType mapToGamut(const BasicOklab<typename LinearColorType::value_type> &oklab)
+    {
+        if constexpr (Mapping == GamutMapping::Css4)
+        {
+            return performCssGamutMapping<ColorType, LinearColorType>(oklab);
+        }
+        else if constexpr (Mapping == GamutMapping::Cusp)
+        {
+            return performCuspGamutMapping<ColorType, LinearColorType>(oklab);
+        }
+        else if constexpr (Mapping == GamutMapping::Clamp)
+        {
+            LinearColorType linearColor = oklabToLinearColor<LinearColorType>(oklab);
+            return linearColorToColor<LinearColorType, ColorType>(clipToGamut<LinearColorType>(linearColor));
+        }
+        else
+        {
+            return linearColorToColor<LinearColorType, ColorType>(oklabToLinearColor<LinearColorType>(oklab));
+        }
+    }
+}
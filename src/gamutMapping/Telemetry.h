@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "GamutMappingTelemetry.h"
+
+/**
+ * @file gamutMapping/Telemetry.h
+ * @brief Counting side of GamutMappingTelemetry.h, used by the gamut mapping code.
+ *
+ * Without OKLAB_TELEMETRY, `record` is an empty inline function.
+ */
+
+namespace oklab
+{
+    namespace telemetry
+    {
+        enum Counter : std::size_t
+        {
+            WHITE_EXITS,
+            BLACK_EXITS,
+            IN_GAMUT_EXITS,
+            CLIP_EXITS,
+            CONVERGED_EXITS,
+            THRESHOLD_EXITS,
+            TOTAL_ITERATIONS,
+            ITERATIONS,
+            COUNTER_COUNT = ITERATIONS + GamutMappingTelemetry::ITERATION_BUCKETS
+        };
+
+        /**
+         * @brief Counters of one thread. Blocks are reused by later threads and never freed.
+         */
+        struct alignas(64) CounterBlock
+        {
+            // Written by the owning thread only, read by snapshots
+            std::atomic<std::uint64_t> counters[COUNTER_COUNT];
+            std::atomic<bool> inUse;
+            CounterBlock *next;
+        };
+
+#ifdef OKLAB_TELEMETRY
+        extern thread_local CounterBlock *threadBlock;
+
+        CounterBlock *claimBlock();
+
+        inline CounterBlock &currentBlock()
+        {
+            CounterBlock *block = threadBlock;
+            if (block == nullptr) [[unlikely]]
+            {
+                block = claimBlock();
+            }
+            return *block;
+        }
+
+        inline void increment(CounterBlock &block, Counter counter, std::uint64_t count)
+        {
+            std::atomic<std::uint64_t> &value = block.counters[counter];
+            value.store(value.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+        }
+
+        inline void record(Counter counter, std::uint64_t count = 1)
+        {
+            increment(currentBlock(), counter, count);
+        }
+
+        /**
+         * @brief Records the end of a chroma search.
+         */
+        inline void recordSearch(Counter exit, std::uint64_t iterations)
+        {
+            CounterBlock &block = currentBlock();
+            std::size_t bucket = iterations < GamutMappingTelemetry::ITERATION_BUCKETS ? iterations : GamutMappingTelemetry::ITERATION_BUCKETS - 1;
+            increment(block, exit, 1);
+            increment(block, TOTAL_ITERATIONS, iterations);
+            increment(block, static_cast<Counter>(ITERATIONS + bucket), 1);
+        }
+#else
+        inline void record(Counter, std::uint64_t = 1) {}
+
+        inline void recordSearch(Counter, std::uint64_t) {}
+#endif
+    } // namespace telemetry
+} // namespace oklab
@@ -0,0 +1,66 @@
+#include "SimdKernels.h"
+#include "SimdKernelsImpl.h"
+
+#include <atomic>
+
+namespace oklab
+{
+    const KernelTable SCALAR_KERNELS = makeKernelTable<double>("scalar");
+
+    namespace
+    {
+        const KernelTable &selectKernels()
+        {
+#ifdef OKLAB_X86_KERNELS
+            for (const KernelTable *table : {&AVX512_KERNELS, &AVX2_KERNELS, &SSE42_KERNELS})
+            {
+                if (isSupported(*table))
+                {
+                    return *table;
+                }
+            }
+#endif
+            return SCALAR_KERNELS;
+        }
+
+        std::atomic<const KernelTable *> &activeKernels()
+        {
+            static std::atomic<const KernelTable *> active{&selectKernels()};
+            return active;
+        }
+
+        // Run the CPUID dispatch when the library is loaded rather than on the first conversion.
+        [[maybe_unused]] const bool KERNELS_SELECTED = (activeKernels(), true);
+    } // namespace
+
+    bool isSupported(const KernelTable &table)
+    {
+#ifdef OKLAB_X86_KERNELS
+        __builtin_cpu_init();
+
+        if (&table == &AVX512_KERNELS)
+        {
+            return __builtin_cpu_supports("avx512f");
+        }
+        if (&table == &AVX2_KERNELS)
+        {
+            return __builtin_cpu_supports("avx2");
+        }
+        if (&table == &SSE42_KERNELS)
+        {
+            return __builtin_cpu_supports("sse4.2");
+        }
+#endif
+        return &table == &SCALAR_KERNELS;
+    }
+
+    const KernelTable &kernels()
+    {
+        return *activeKernels().load(std::memory_order_relaxed);
+    }
+
+    void useKernels(const KernelTable &table)
+    {
+        activeKernels().store(&table, std::memory_order_relaxed);
+    }
+} // namespace oklab
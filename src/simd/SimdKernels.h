@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "TransferFunctions.h"
+#include "Lut3D.h"
+
+#include "../BatchKernels.h"
+
+/**
+ * @file simd/SimdKernels.h
+ * @brief Provides the vectorized implementations of the batch conversion stages.
+ *
+ * Each instruction set gets its own kernel table, compiled in its own translation unit with the
+ * matching target flags. The best table supported by the CPU is selected once, when the library
+ * is loaded, so a single binary runs on any x86-64 machine.
+ *
+ * Kernels operate on block planes and may process up to `paddedCount(count)` elements; the
+ * padding lanes are scratch and their results are ignored.
+ */
+
+namespace oklab
+{
+    /**
+     * @brief Nodes of a 3D LUT: `size^3` colors of 3 interleaved floats, see Lut3D.h.
+     */
+    struct LutGrid
+    {
+        const float *nodes;
+        std::int64_t size;
+    };
+
+    /**
+     * @brief Function table holding one implementation of every batch stage.
+     */
+    struct KernelTable
+    {
+        const char *name;
+
+        /** Block equivalent of `multiplyMatrix`. */
+        void (*multiplyMatrix)(const double matrix[3][3], const BlockPlanes &input, BlockPlanes &output, std::size_t count);
+
+        /** In-place `x * x * x`. */
+        void (*cube)(double *plane, std::size_t count);
+
+        /** In-place signed cube root, equivalent to `oklab::cbrt`. */
+        void (*cbrt)(double *plane, std::size_t count);
+
+        /** In-place `gammaToLinear(x, accuracy)`. */
+        void (*gammaToLinear)(double *plane, std::size_t count, TransferAccuracy accuracy);
+
+        /** In-place `linearToGamma(x, accuracy)`. */
+        void (*linearToGamma)(double *plane, std::size_t count, TransferAccuracy accuracy);
+
+        /** Equivalent of `static_cast<int>(std::round(linearToGamma(x) * 255.0))`. */
+        void (*encodeGamma)(const double *plane, int *output, std::size_t count);
+
+        /** In-place `std::clamp(x, 0.0, 1.0)`. */
+        void (*clipToUnit)(double *plane, std::size_t count);
+
+        /** Sets `mask[i]` to 1 when all three channels of color `i` lie in [0, 1], 0 otherwise. */
+        void (*inGamut)(const BlockPlanes &linear, unsigned char *mask, std::size_t count);
+
+        /** 3D LUT lookup of each color of a block, equivalent to `Lut3D::lookup`. */
+        void (*lut3D)(const LutGrid &grid, LutInterpolation interpolation, const BlockPlanes &input, BlockPlanes &output, std::size_t count);
+
+        /** In-place Oklab adjustment of a block, equivalent to `adjustOklabBlock`. */
+        void (*adjustOklab)(const OklabAdjustment &adjustment, BlockPlanes &oklab, std::size_t count);
+
+        /** In-place `oklchToOklab` of a block: the L, C and h planes become L, a and b. */
+        void (*oklchToOklab)(BlockPlanes &block, std::size_t count);
+
+        /** CSS4 chroma searches of a block, one search per lane, equivalent to `searchCss4Block`. */
+        void (*css4Search)(const double fromLms[3][3], const double toLms[3][3], Css4Searches &searches);
+    };
+
+    extern const KernelTable SCALAR_KERNELS;
+
+#ifdef OKLAB_X86_KERNELS
+    extern const KernelTable SSE42_KERNELS;
+    extern const KernelTable AVX2_KERNELS;
+    extern const KernelTable AVX512_KERNELS;
+#endif
+
+    /**
+     * @brief Returns the kernel table used by the batch conversions.
+     */
+    const KernelTable &kernels();
+
+    /**
+     * @brief Checks whether the running CPU can execute the given kernel table.
+     */
+    bool isSupported(const KernelTable &table);
+
+    /**
+     * @brief Replaces the kernel table used by the batch conversions.
+     *
+     * Meant for tests and benchmarks; the table must be supported by the running CPU.
+     */
+    void useKernels(const KernelTable &table);
+} // namespace oklab
@@ -0,0 +1,19 @@
+#include "SimdKernels.h"
+
+#ifdef OKLAB_X86_KERNELS
+
+#include "SimdKernelsImpl.h"
+
+// AVX2 kernels: this file is compiled with the matching target flags (see src/CMakeLists.txt).
+
+namespace oklab
+{
+    namespace
+    {
+        typedef double DoubleVector __attribute__((vector_size(32)));
+    }
+
+    const KernelTable AVX2_KERNELS = makeKernelTable<DoubleVector>("avx2");
+} // namespace oklab
+
+#endif
@@ -0,0 +1,19 @@
+#include "SimdKernels.h"
+
+#ifdef OKLAB_X86_KERNELS
+
+#include "SimdKernelsImpl.h"
+
+// AVX-512 kernels: this file is compiled with the matching target flags (see src/CMakeLists.txt).
+
+namespace oklab
+{
+    namespace
+    {
+        typedef double DoubleVector __attribute__((vector_size(64)));
+    }
+
+    const KernelTable AVX512_KERNELS = makeKernelTable<DoubleVector>("avx512");
+} // namespace oklab
+
+#endif
@@ -0,0 +1,462 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+#include "SimdKernels.h"
+#include "../MathUtils.h"
+#include "../ColorUtils.h"
+#include "../TransferTables.h"
+#include "../TransferApprox.h"
+#include "../CbrtApprox.h"
+#include "../TrigApprox.h"
+#include "../LutInterpolation.h"
+
+/**
+ * @file simd/SimdKernelsImpl.h
+ * @brief Generic kernel implementations, instantiated once per instruction set.
+ *
+ * Included by each simd/SimdKernels*.cpp file, compiled with the matching target flags.
+ * `Vector` is either `double` or a GCC/Clang vector of doubles.
+ *
+ * Everything here has internal linkage, so code compiled for a wider instruction set is never
+ * picked by the linker for another translation unit. Arithmetic follows the scalar functions
+ * operation by operation, so results are bit-identical across instruction sets. The cube root, the
+ * approximated transfer functions and the 3D LUT interpolation share their generic code with the
+ * scalar functions; exact transcendental stages call the scalar functions (or their lookup tables)
+ * lane by lane.
+ */
+
+namespace oklab
+{
+    namespace
+    {
+        template <typename Vector>
+        constexpr std::size_t lanes()
+        {
+            return sizeof(Vector) / sizeof(double);
+        }
+
+        template <typename Vector>
+        inline Vector load(const double *data)
+        {
+            Vector value;
+            std::memcpy(&value, data, sizeof(Vector));
+            return value;
+        }
+
+        template <typename Vector>
+        inline void store(double *data, const Vector &value)
+        {
+            std::memcpy(data, &value, sizeof(Vector));
+        }
+
+        template <typename T>
+        inline typename std::enable_if<std::is_arithmetic<T>::value, T &>::type lane(T &value, std::size_t)
+        {
+            return value;
+        }
+
+        template <typename T>
+        inline typename std::enable_if<!std::is_arithmetic<T>::value, decltype(std::declval<T &>()[0])>::type lane(T &value, std::size_t index)
+        {
+            return value[index];
+        }
+
+        template <typename Vector, typename Function>
+        inline Vector perLane(Vector value, Function function)
+        {
+            for (std::size_t l = 0; l < lanes<Vector>(); ++l)
+            {
+                lane(value, l) = function(lane(value, l));
+            }
+            return value;
+        }
+
+        template <typename Vector>
+        void multiplyMatrixKernel(const double matrix[3][3], const BlockPlanes &input, BlockPlanes &output, std::size_t count)
+        {
+            const std::size_t end = paddedCount(count);
+
+            for (int row = 0; row < 3; ++row)
+            {
+                const double m0 = matrix[row][0];
+                const double m1 = matrix[row][1];
+                const double m2 = matrix[row][2];
+
+                for (std::size_t i = 0; i < end; i += lanes<Vector>())
+                {
+                    // Same accumulation order as multiplyMatrix, starting from 0.0.
+                    Vector value = Vector{};
+                    value += m0 * load<Vector>(input.channels[0] + i);
+                    value += m1 * load<Vector>(input.channels[1] + i);
+                    value += m2 * load<Vector>(input.channels[2] + i);
+                    store(output.channels[row] + i, value);
+                }
+            }
+        }
+
+        template <typename Vector>
+        void cubeKernel(double *plane, std::size_t count)
+        {
+            const std::size_t end = paddedCount(count);
+            for (std::size_t i = 0; i < end; i += lanes<Vector>())
+            {
+                Vector value = load<Vector>(plane + i);
+                store(plane + i, value * value * value);
+            }
+        }
+
+        template <typename Vector>
+        void cbrtKernel(double *plane, std::size_t count)
+        {
+            const std::size_t end = paddedCount(count);
+            for (std::size_t i = 0; i < end; i += lanes<Vector>())
+            {
+                store(plane + i, cbrtApprox::cbrt(load<Vector>(plane + i)));
+            }
+        }
+
+        template <typename Vector, typename Function>
+        inline void transformPlane(double *plane, std::size_t count, Function function)
+        {
+            const std::size_t end = paddedCount(count);
+            for (std::size_t i = 0; i < end; i += lanes<Vector>())
+            {
+                store(plane + i, function(load<Vector>(plane + i)));
+            }
+        }
+
+        template <typename Vector>
+        void gammaToLinearKernel(double *plane, std::size_t count, TransferAccuracy accuracy)
+        {
+            switch (accuracy)
+            {
+            case TransferAccuracy::Precise:
+                transformPlane<Vector>(plane, count, [](Vector x) { return transferApprox::gammaToLinear<TransferAccuracy::Precise>(x); });
+                break;
+            case TransferAccuracy::EightBit:
+                transformPlane<Vector>(plane, count, [](Vector x) { return transferApprox::gammaToLinear<TransferAccuracy::EightBit>(x); });
+                break;
+            default:
+                transformPlane<Vector>(plane, count, [](Vector x) { return perLane(x, [](double value) { return gammaToLinear(value); }); });
+                break;
+            }
+        }
+
+        template <typename Vector>
+        void linearToGammaKernel(double *plane, std::size_t count, TransferAccuracy accuracy)
+        {
+            switch (accuracy)
+            {
+            case TransferAccuracy::Precise:
+                transformPlane<Vector>(plane, count, [](Vector x) { return transferApprox::linearToGamma<TransferAccuracy::Precise>(x); });
+                break;
+            case TransferAccuracy::EightBit:
+                transformPlane<Vector>(plane, count, [](Vector x) { return transferApprox::linearToGamma<TransferAccuracy::EightBit>(x); });
+                break;
+            default:
+                transformPlane<Vector>(plane, count, [](Vector x) { return perLane(x, [](double value) { return linearToGamma(value); }); });
+                break;
+            }
+        }
+
+        template <typename Vector>
+        void encodeGammaKernel(const double *plane, int *output, std::size_t count)
+        {
+            const TransferTables8Bit &tables = transferTables8Bit();
+            const std::size_t end = paddedCount(count);
+            for (std::size_t i = 0; i < end; i += lanes<Vector>())
+            {
+                Vector value = load<Vector>(plane + i);
+                for (std::size_t l = 0; l < lanes<Vector>(); ++l)
+                {
+                    output[i + l] = linearToGamma8Bit(tables, lane(value, l));
+                }
+            }
+        }
+
+        template <typename Vector>
+        void clipToUnitKernel(double *plane, std::size_t count)
+        {
+            const std::size_t end = paddedCount(count);
+            const Vector zero = Vector{};
+            const Vector one = Vector{} + 1.0;
+
+            for (std::size_t i = 0; i < end; i += lanes<Vector>())
+            {
+                // Same comparisons as std::clamp(value, 0.0, 1.0), so NaN and -0.0 pass through.
+                Vector value = load<Vector>(plane + i);
+                store(plane + i, (value < 0.0) ? zero : ((1.0 < value) ? one : value));
+            }
+        }
+
+        template <typename Vector>
+        void adjustOklabKernel(const OklabAdjustment &adjustment, BlockPlanes &oklab, std::size_t count)
+        {
+            const std::size_t end = paddedCount(count);
+            const Vector one = Vector{} + 1.0;
+            const double lightness = adjustment.lightness;
+            const double (&matrix)[2][2] = adjustment.matrix;
+
+            for (std::size_t i = 0; i < end; i += lanes<Vector>())
+            {
+                // Same operations as lighten / darken, so lightness matches them exactly
+                Vector l = load<Vector>(oklab.channels[0] + i);
+                if (adjustment.isLightening)
+                {
+                    Vector lightened = l + (1.0 - l) * lightness;
+                    l = (lightened < 1.0) ? lightened : one;
+                }
+                else
+                {
+                    l = l * (1.0 - lightness);
+                }
+                store(oklab.channels[0] + i, l);
+
+                Vector a = load<Vector>(oklab.channels[1] + i);
+                Vector b = load<Vector>(oklab.channels[2] + i);
+                store(oklab.channels[1] + i, matrix[0][0] * a + matrix[0][1] * b);
+                store(oklab.channels[2] + i, matrix[1][0] * a + matrix[1][1] * b);
+            }
+        }
+
+        template <typename Vector>
+        void oklchToOklabKernel(BlockPlanes &block, std::size_t count)
+        {
+            const std::size_t end = paddedCount(count);
+            const Vector zero = Vector{};
+
+            for (std::size_t i = 0; i < end; i += lanes<Vector>())
+            {
+                Vector chroma = load<Vector>(block.channels[1] + i);
+                Vector hue = load<Vector>(block.channels[2] + i);
+                Vector sine;
+                Vector cosine;
+                trigApprox::sinCosDegrees(hue, sine, cosine);
+
+                // A NaN hue is powerless: achromatic, as in oklchToOklab
+                auto isAchromatic = hue != hue;
+                store(block.channels[1] + i, isAchromatic ? zero : cosine * chroma);
+                store(block.channels[2] + i, isAchromatic ? zero : sine * chroma);
+            }
+        }
+
+        template <typename Vector>
+        void inGamutKernel(const BlockPlanes &linear, unsigned char *mask, std::size_t count)
+        {
+            const std::size_t end = paddedCount(count);
+            for (std::size_t i = 0; i < end; i += lanes<Vector>())
+            {
+                Vector x = load<Vector>(linear.channels[0] + i);
+                Vector y = load<Vector>(linear.channels[1] + i);
+                Vector z = load<Vector>(linear.channels[2] + i);
+
+                auto inside = (x >= 0.0) & (x <= 1.0) & (y >= 0.0) & (y <= 1.0) & (z >= 0.0) & (z <= 1.0);
+
+                for (std::size_t l = 0; l < lanes<Vector>(); ++l)
+                {
+                    mask[i + l] = lane(inside, l) != 0;
+                }
+            }
+        }
+
+        template <typename Vector>
+        void lut3DKernel(const LutGrid &grid, LutInterpolation interpolation, const BlockPlanes &input, BlockPlanes &output, std::size_t count)
+        {
+            const std::size_t end = paddedCount(count);
+            for (std::size_t i = 0; i < end; i += lanes<Vector>())
+            {
+                Vector result[3];
+                lutInterpolation::interpolate(grid, interpolation,
+                                              load<Vector>(input.channels[0] + i),
+                                              load<Vector>(input.channels[1] + i),
+                                              load<Vector>(input.channels[2] + i),
+                                              result);
+                for (int c = 0; c < 3; ++c)
+                {
+                    store(output.channels[c] + i, result[c]);
+                }
+            }
+        }
+
+        template <typename Vector>
+        inline void multiplyLanes(const double matrix[3][3], const Vector (&input)[3], Vector (&output)[3])
+        {
+            for (int row = 0; row < 3; ++row)
+            {
+                // Same accumulation order as multiplyMatrix, starting from 0.0.
+                Vector value = Vector{};
+                value += matrix[row][0] * input[0];
+                value += matrix[row][1] * input[1];
+                value += matrix[row][2] * input[2];
+                output[row] = value;
+            }
+        }
+
+        /**
+         * Runs one search per lane; when the search of a lane ends, the lane takes the next one.
+         * Each step evaluates the candidates of all lanes and applies the decisions of the bisection
+         * with selects; only the lanes whose search ends are handled one by one.
+         */
+        template <typename Vector>
+        void css4SearchKernel(const double fromLms[3][3], const double toLms[3][3], Css4Searches &searches)
+        {
+            const double JUST_NON_DISCERNIBLE = css4::JUST_NON_DISCERNIBLE;
+            const double EPSILON = css4::EPSILON;
+            const Vector zero = Vector{};
+            const Vector one = Vector{} + 1.0;
+
+            // Lanes without a search compute on black
+            Vector lightness = zero;
+            Vector cosine = zero;
+            Vector sine = zero;
+            Vector minChroma = zero;
+            Vector maxChroma = zero;
+            Vector isMinChromaInGamut = zero;
+            Vector clipped[3] = {zero, zero, zero};
+
+            std::size_t searchOfLane[lanes<Vector>()];
+            int iterations[lanes<Vector>()] = {};
+            std::size_t nextSearch = 0;
+
+            // Puts the next search with a step on lane `l`; searches without one end here
+            auto startSearch = [&](std::size_t l)
+            {
+                while (nextSearch < searches.count)
+                {
+                    std::size_t search = nextSearch++;
+                    if (!(searches.chroma[search] > EPSILON))
+                    {
+                        searches.iterations[search] = 0;
+                        searches.isThresholdExit[search] = false;
+                        continue;
+                    }
+
+                    searchOfLane[l] = search;
+                    iterations[l] = 0;
+                    lane(lightness, l) = searches.lightness[search];
+                    lane(cosine, l) = searches.cosine[search];
+                    lane(sine, l) = searches.sine[search];
+                    lane(minChroma, l) = 0.0;
+                    lane(maxChroma, l) = searches.chroma[search];
+                    lane(isMinChromaInGamut, l) = 1.0;
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        lane(clipped[c], l) = searches.clipped.channels[c][search];
+                    }
+                    return true;
+                }
+                return false;
+            };
+
+            bool isActive[lanes<Vector>()];
+            std::size_t activeLanes = 0;
+            for (std::size_t l = 0; l < lanes<Vector>(); ++l)
+            {
+                isActive[l] = startSearch(l);
+                activeLanes += isActive[l];
+            }
+
+            while (activeLanes > 0)
+            {
+                // The candidate, in linear and clipped back to Oklab
+                Vector chroma = (minChroma + maxChroma) / 2.0;
+                Vector oklab[3] = {lightness, cosine * chroma, sine * chroma};
+
+                Vector lms[3];
+                multiplyLanes(OKLAB_TO_LMSG, oklab, lms);
+                for (int c = 0; c < 3; ++c)
+                {
+                    lms[c] = lms[c] * lms[c] * lms[c];
+                }
+
+                Vector linear[3];
+                multiplyLanes(fromLms, lms, linear);
+                auto isInGamut = (linear[0] >= 0.0) & (linear[0] <= 1.0) & (linear[1] >= 0.0) & (linear[1] <= 1.0) & (linear[2] >= 0.0) & (linear[2] <= 1.0);
+
+                Vector candidate[3];
+                for (int c = 0; c < 3; ++c)
+                {
+                    candidate[c] = (linear[c] < 0.0) ? zero : ((1.0 < linear[c]) ? one : linear[c]);
+                }
+
+                multiplyLanes(toLms, candidate, lms);
+                for (int c = 0; c < 3; ++c)
+                {
+                    lms[c] = cbrtApprox::cbrt(lms[c]);
+                }
+
+                Vector clippedOklab[3];
+                multiplyLanes(LMSG_TO_OKLAB, lms, clippedOklab);
+
+                Vector deltaL = clippedOklab[0] - oklab[0];
+                Vector deltaA = clippedOklab[1] - oklab[1];
+                Vector deltaB = clippedOklab[2] - oklab[2];
+                Vector E = perLane(deltaL * deltaL + deltaA * deltaA + deltaB * deltaB, [](double value) { return std::sqrt(value); });
+
+                // Decisions of the bisection
+                auto isKeptInGamut = (isMinChromaInGamut > 0.0) & isInGamut;
+                auto isNotNoticeable = E < JUST_NON_DISCERNIBLE;
+                auto isAtThreshold = JUST_NON_DISCERNIBLE - E < EPSILON;
+
+                Vector isThresholdExit = isKeptInGamut ? zero : (isNotNoticeable ? (isAtThreshold ? one : zero) : zero);
+                minChroma = isKeptInGamut ? chroma : (isNotNoticeable ? (isAtThreshold ? minChroma : chroma) : minChroma);
+                maxChroma = isKeptInGamut ? maxChroma : (isNotNoticeable ? maxChroma : chroma);
+                isMinChromaInGamut = isKeptInGamut ? isMinChromaInGamut : (isNotNoticeable ? (isAtThreshold ? isMinChromaInGamut : zero) : isMinChromaInGamut);
+                for (int c = 0; c < 3; ++c)
+                {
+                    clipped[c] = isKeptInGamut ? clipped[c] : candidate[c];
+                }
+
+                Vector width = maxChroma - minChroma;
+                for (std::size_t l = 0; l < lanes<Vector>(); ++l)
+                {
+                    if (!isActive[l])
+                    {
+                        continue;
+                    }
+
+                    ++iterations[l];
+                    bool isThresholdLane = lane(isThresholdExit, l) > 0.0;
+                    if (!isThresholdLane && lane(width, l) > EPSILON)
+                    {
+                        continue;
+                    }
+
+                    std::size_t search = searchOfLane[l];
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        searches.clipped.channels[c][search] = lane(clipped[c], l);
+                    }
+                    searches.iterations[search] = iterations[l];
+                    searches.isThresholdExit[search] = isThresholdLane;
+
+                    isActive[l] = startSearch(l);
+                    activeLanes -= !isActive[l];
+                }
+            }
+        }
+
+        template <typename Vector>
+        constexpr KernelTable makeKernelTable(const char *name)
+        {
+            return KernelTable{
+                name,
+                &multiplyMatrixKernel<Vector>,
+                &cubeKernel<Vector>,
+                &cbrtKernel<Vector>,
+                &gammaToLinearKernel<Vector>,
+                &linearToGammaKernel<Vector>,
+                &encodeGammaKernel<Vector>,
+                &clipToUnitKernel<Vector>,
+                &inGamutKernel<Vector>,
+                &lut3DKernel<Vector>,
+                &adjustOklabKernel<Vector>,
+                &oklchToOklabKernel<Vector>,
+                &css4SearchKernel<Vector>};
+        }
+    } // namespace
+} // namespace oklab
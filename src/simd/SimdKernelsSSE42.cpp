@@ -0,0 +1,19 @@
+#include "SimdKernels.h"
+
+#ifdef OKLAB_X86_KERNELS
+
+#include "SimdKernelsImpl.h"
+
+// SSE4.2 kernels: this file is compiled with the matching target flags (see src/CMakeLists.txt).
+
+namespace oklab
+{
+    namespace
+    {
+        typedef double DoubleVector __attribute__((vector_size(16)));
+    }
+
+    const KernelTable SSE42_KERNELS = makeKernelTable<DoubleVector>("sse4.2");
+} // namespace oklab
+
+#endif
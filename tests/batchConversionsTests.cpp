@@ -0,0 +1,172 @@
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "gtest/gtest.h"
+#include "ColorConversions.h"
+#include "ColorBatchConversions.h"
+
+using namespace oklab;
+
+namespace
+{
+    // A coarse grid over the 8-bit cube, including the extremes.
+    template <typename ColorType>
+    std::vector<ColorType> colorGrid()
+    {
+        std::vector<ColorType> colors;
+        for (int r = 0; r <= 255; r += 15)
+            for (int g = 0; g <= 255; g += 15)
+                for (int b = 0; b <= 255; b += 15)
+                    colors.push_back(ColorType{r, g, b});
+        return colors;
+    }
+
+    // Oklab colors covering in-gamut, out-of-gamut and out-of-range lightness values.
+    std::vector<Oklab> oklabGrid()
+    {
+        std::vector<Oklab> colors;
+        for (int l = -1; l <= 11; ++l)
+            for (int a = -8; a <= 8; ++a)
+                for (int b = -8; b <= 8; ++b)
+                    colors.push_back(Oklab{l / 10.0, a * 0.05, b * 0.05});
+        return colors;
+    }
+}
+
+TEST(BatchConversions, RgbToOklabMatchesScalar)
+{
+    std::vector<RGB> input = colorGrid<RGB>();
+    std::vector<Oklab> output(input.size());
+
+    rgbToOklab(input, output);
+
+    for (size_t i = 0; i < input.size(); ++i)
+    {
+        EXPECT_EQ(output[i], rgbToOklab(input[i])) << "at index " << i;
+    }
+}
+
+TEST(BatchConversions, P3ToOklabPlanarMatchesScalar)
+{
+    std::vector<P3> colors = colorGrid<P3>();
+    std::vector<int> r, g, b;
+    for (const P3 &color : colors)
+    {
+        r.push_back(color[0]);
+        g.push_back(color[1]);
+        b.push_back(color[2]);
+    }
+    std::vector<double> l(colors.size()), a(colors.size()), bb(colors.size());
+
+    p3ToOklab(Planar<const int>(r, g, b), Planar<double>(l, a, bb));
+
+    for (size_t i = 0; i < colors.size(); ++i)
+    {
+        EXPECT_EQ(Oklab({l[i], a[i], bb[i]}), p3ToOklab(colors[i])) << "at index " << i;
+    }
+}
+
+TEST(BatchConversions, OklabToRgbMatchesScalar)
+{
+    std::vector<Oklab> input = oklabGrid();
+    std::vector<RGB> output(input.size());
+
+    oklabToRgb(input, output);
+
+    for (size_t i = 0; i < input.size(); ++i)
+    {
+        EXPECT_EQ(output[i], oklabToRgb(input[i])) << "at index " << i;
+    }
+}
+
+TEST(BatchConversions, OklabToP3PlanarMatchesScalar)
+{
+    std::vector<Oklab> colors = oklabGrid();
+    std::vector<double> l, a, b;
+    for (const Oklab &color : colors)
+    {
+        l.push_back(color[0]);
+        a.push_back(color[1]);
+        b.push_back(color[2]);
+    }
+    std::vector<int> r(colors.size()), g(colors.size()), bb(colors.size());
+
+    oklabToP3(Planar<const double>(l, a, b), Planar<int>(r, g, bb));
+
+    for (size_t i = 0; i < colors.size(); ++i)
+    {
+        EXPECT_EQ(P3({r[i], g[i], bb[i]}), oklabToP3(colors[i])) << "at index " << i;
+    }
+}
+
+TEST(BatchConversions, OklabToRgbAndP3MatchScalarOnRandomColors)
+{
+    // Any Oklab color, far out of gamut and with lightness outside [0, 1]: the CSS4 searches run
+    // in SIMD lanes and must decide every candidate as the single-color bisection
+    std::uint64_t state = 0x2545F4914F6CDD1Dull;
+    auto next = [&state]()
+    {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        return static_cast<double>(state >> 11) / static_cast<double>(1ull << 53);
+    };
+
+    std::vector<Oklab> input = {
+        // Where the clipped deltaE folds back at a threshold
+        Oklab{0.98356513378555666, -0.11890936588590467, 0.40493080914847479},
+        Oklab{0.46013582449629048, -0.056898753848912687, -0.35459939868241475},
+        Oklab{0.97308668992289515, -0.080308000576213179, 0.28261100734399069},
+    };
+    for (int i = 0; i < 300000; ++i)
+    {
+        input.push_back(Oklab{next() * 1.2 - 0.1, next() - 0.5, next() - 0.5});
+    }
+
+    for (GamutMapping mapping : {GamutMapping::Css4, GamutMapping::Cusp, GamutMapping::Clamp})
+    {
+        std::vector<RGB> rgb(input.size());
+        std::vector<P3> p3(input.size());
+        oklabToRgb(input, rgb, mapping);
+        oklabToP3(input, p3, mapping);
+
+        for (size_t i = 0; i < input.size(); ++i)
+        {
+            ASSERT_EQ(rgb[i], oklabToRgb(input[i], mapping)) << "at index " << i;
+            ASSERT_EQ(p3[i], oklabToP3(input[i], mapping)) << "at index " << i;
+        }
+    }
+}
+
+TEST(BatchConversions, EmptyBuffers)
+{
+    std::vector<RGB> input;
+    std::vector<Oklab> output;
+
+    rgbToOklab(input, output);
+    oklabToRgb(output, input);
+
+    EXPECT_TRUE(input.empty());
+}
+
+TEST(BatchConversions, MismatchedSizesThrow)
+{
+    std::vector<RGB> rgb(10, RGB{10, 20, 30});
+    std::vector<Oklab> oklab(9);
+    std::vector<P3> p3(11);
+
+    EXPECT_THROW(rgbToOklab(rgb, oklab), std::invalid_argument);
+    EXPECT_THROW(oklabToRgb(oklab, rgb), std::invalid_argument);
+    EXPECT_THROW(oklabToP3(oklab, p3, GamutMapping::Clamp), std::invalid_argument);
+    EXPECT_THROW(rgbToOklab(rgb, oklab, BitDepth::Ten), std::invalid_argument);
+
+    // Planes of one buffer must match too
+    std::vector<int> r(10, 10), g(10, 20), shortB(9, 30);
+    std::vector<double> l(10), a(10), b(10), shortL(9);
+    EXPECT_THROW(rgbToOklab(Planar<const int>(r, g, shortB), Planar<double>(l, a, b)), std::invalid_argument);
+    EXPECT_THROW(rgbToOklab(Planar<const int>(r, g, g), Planar<double>(shortL, a, b)), std::invalid_argument);
+    EXPECT_THROW(p3ToOklab(Planar<const int>(r, g, g), Planar<double>(l, a, shortL)), std::invalid_argument);
+
+    // Nothing is written before the check
+    EXPECT_EQ(l, std::vector<double>(10));
+    rgbToOklab(Planar<const int>(r, g, g), Planar<double>(l, a, b));
+    EXPECT_EQ(rgbToOklab(RGB{10, 20, 20})[0], l[0]);
+}
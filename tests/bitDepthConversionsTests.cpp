@@ -0,0 +1,192 @@
+#include <cmath>
+#include <random>
+#include <vector>
+#include "gtest/gtest.h"
+#include "ColorBatchConversions.h"
+#include "ColorConversions.h"
+#include "PixelFormats.h"
+#include "TransferFunctions.h"
+
+using namespace oklab;
+
+namespace
+{
+    const BitDepth DEEP_DEPTHS[] = {BitDepth::Ten, BitDepth::Twelve, BitDepth::Sixteen};
+
+    // Oklab colors over and beyond both gamuts, lightness extremes included
+    std::vector<Oklab> makeOklabColors()
+    {
+        std::mt19937_64 generator(2024);
+        std::uniform_real_distribution<double> lightness(-0.05, 1.05);
+        std::uniform_real_distribution<double> axis(-0.4, 0.4);
+        std::vector<Oklab> colors;
+        for (int i = 0; i < 5000; ++i)
+        {
+            colors.push_back(Oklab{lightness(generator), axis(generator), axis(generator)});
+        }
+        return colors;
+    }
+
+    int encodeWithPow(double gamma, BitDepth depth)
+    {
+        return static_cast<int>(std::round(gamma * maxCodeValue(depth)));
+    }
+}
+
+TEST(BitDepthConversions, DeepCodesRoundTheUnquantizedConversion)
+{
+    for (GamutMapping mapping : {GamutMapping::Css4, GamutMapping::Cusp, GamutMapping::Clamp})
+    {
+        for (const Oklab &oklab : makeOklabColors())
+        {
+            GammaSRGB gammaRgb = oklabToGammaSRGB(oklab, mapping);
+            GammaP3 gammaP3 = oklabToGammaP3(oklab, mapping);
+            for (BitDepth depth : DEEP_DEPTHS)
+            {
+                RGB rgb = oklabToRgb(oklab, depth, mapping);
+                P3 p3 = oklabToP3(oklab, depth, mapping);
+                for (int c = 0; c < 3; ++c)
+                {
+                    ASSERT_EQ(rgb[c], encodeWithPow(gammaRgb[c], depth)) << oklab[0] << ", " << oklab[1] << ", " << oklab[2];
+                    ASSERT_EQ(p3[c], encodeWithPow(gammaP3[c], depth)) << oklab[0] << ", " << oklab[1] << ", " << oklab[2];
+                }
+            }
+        }
+    }
+}
+
+TEST(BitDepthConversions, EightBitDepthMatchesEightBitConversions)
+{
+    std::vector<Oklab> colors = makeOklabColors();
+    for (const Oklab &oklab : colors)
+    {
+        ASSERT_EQ(oklabToRgb(oklab, BitDepth::Eight), oklabToRgb(oklab));
+        ASSERT_EQ(oklabToP3(oklab, BitDepth::Eight, GamutMapping::Cusp), oklabToP3(oklab, GamutMapping::Cusp));
+    }
+    for (int code = 0; code < 256; code += 5)
+    {
+        ASSERT_EQ(rgbToOklab(RGB{code, 255 - code, code / 2}, BitDepth::Eight), rgbToOklab(RGB{code, 255 - code, code / 2}));
+        ASSERT_EQ(p3ToOklab(P3{code, code / 3, 255 - code}, BitDepth::Eight), p3ToOklab(P3{code, code / 3, 255 - code}));
+    }
+}
+
+TEST(BitDepthConversions, BatchMatchesSingleColor)
+{
+    std::vector<Oklab> colors = makeOklabColors();
+    for (BitDepth depth : DEEP_DEPTHS)
+    {
+        for (GamutMapping mapping : {GamutMapping::Css4, GamutMapping::Cusp, GamutMapping::None})
+        {
+            std::vector<RGB> rgb(colors.size());
+            std::vector<P3> p3(colors.size());
+            oklabToRgb(Span<const Oklab>(colors), Span<RGB>(rgb), depth, mapping);
+            oklabToP3(Span<const Oklab>(colors), Span<P3>(p3), depth, mapping);
+            for (std::size_t i = 0; i < colors.size(); ++i)
+            {
+                ASSERT_EQ(rgb[i], oklabToRgb(colors[i], depth, mapping)) << i;
+                ASSERT_EQ(p3[i], oklabToP3(colors[i], depth, mapping)) << i;
+            }
+
+            if (mapping == GamutMapping::None)
+            {
+                continue;
+            }
+            std::vector<Oklab> fromRgb(colors.size());
+            std::vector<Oklab> fromP3(colors.size());
+            rgbToOklab(Span<const RGB>(rgb), Span<Oklab>(fromRgb), depth);
+            p3ToOklab(Span<const P3>(p3), Span<Oklab>(fromP3), depth);
+            for (std::size_t i = 0; i < colors.size(); ++i)
+            {
+                ASSERT_EQ(fromRgb[i], rgbToOklab(rgb[i], depth)) << i;
+                ASSERT_EQ(fromP3[i], p3ToOklab(p3[i], depth)) << i;
+            }
+        }
+    }
+}
+
+TEST(BitDepthConversions, SixteenBitCodesRoundTrip)
+{
+    // Round trips may leave in-gamut colors a few 1e-17 out of gamut: clamping them back is exact,
+    // where the CSS4 search may move them within its JND, which 16-bit codes resolve
+    for (int r = 0; r <= 65535; r += 1021)
+    {
+        for (int g = 0; g <= 65535; g += 4093)
+        {
+            for (int b = 0; b <= 65535; b += 8191)
+            {
+                ASSERT_EQ(oklabToP3(p3ToOklab(P3{r, g, b}, BitDepth::Sixteen), BitDepth::Sixteen, GamutMapping::Clamp), (P3{r, g, b}));
+                ASSERT_EQ(oklabToRgb(rgbToOklab(RGB{r, g, b}, BitDepth::Sixteen), BitDepth::Sixteen, GamutMapping::Clamp), (RGB{r, g, b}));
+            }
+        }
+    }
+}
+
+TEST(BitDepthConversions, GammaEncodedBatchesMatchSingleColor)
+{
+    std::vector<Oklab> colors = makeOklabColors();
+    std::vector<GammaSRGB> gammaRgb(colors.size());
+    std::vector<GammaP3f> gammaP3f(colors.size());
+    oklabToGammaSRGB(Span<const Oklab>(colors), Span<GammaSRGB>(gammaRgb), GamutMapping::Css4);
+    oklabToGammaP3(Span<const Oklab>(colors), Span<GammaP3f>(gammaP3f), GamutMapping::Css4);
+
+    for (std::size_t i = 0; i < colors.size(); ++i)
+    {
+        ASSERT_EQ(gammaRgb[i], oklabToGammaSRGB(colors[i], GamutMapping::Css4)) << i;
+        GammaP3 expected = oklabToGammaP3(colors[i], GamutMapping::Css4);
+        for (int c = 0; c < 3; ++c)
+        {
+            ASSERT_EQ(gammaP3f[i][c], static_cast<float>(expected[c])) << i;
+        }
+    }
+
+    std::vector<Oklab> exact(colors.size());
+    std::vector<Oklab> precise(colors.size());
+    gammaSRGBToOklab(Span<const GammaSRGB>(gammaRgb), Span<Oklab>(exact));
+    gammaSRGBToOklab(Span<const GammaSRGB>(gammaRgb), Span<Oklab>(precise), TransferAccuracy::Precise);
+    for (std::size_t i = 0; i < colors.size(); ++i)
+    {
+        ASSERT_EQ(exact[i], gammaSRGBToOklab(gammaRgb[i])) << i;
+        for (int c = 0; c < 3; ++c)
+        {
+            ASSERT_NEAR(precise[i][c], exact[i][c], 1e-7) << i;
+        }
+    }
+
+    gammaP3ToOklab(Span<const GammaP3f>(gammaP3f), Span<Oklab>(exact));
+    for (std::size_t i = 0; i < colors.size(); ++i)
+    {
+        GammaP3 widened{gammaP3f[i][0], gammaP3f[i][1], gammaP3f[i][2]};
+        ASSERT_EQ(exact[i], gammaP3ToOklab(widened)) << i;
+    }
+}
+
+TEST(BitDepthConversions, PackedDeepFormatsMatchBitDepthConversions)
+{
+    std::vector<RGBA16> input;
+    std::vector<RGB10A2> input10;
+    for (int i = 0; i < 4096; ++i)
+    {
+        input.push_back(RGBA16{static_cast<std::uint16_t>(i * 16411 % 65536), static_cast<std::uint16_t>(i * 7919 % 65536),
+                               static_cast<std::uint16_t>(i * 104729 % 65536), 65535});
+        input10.push_back(RGB10A2{static_cast<std::uint32_t>(i * 613 % 1024) | static_cast<std::uint32_t>(i * 97 % 1024) << 10 |
+                                  static_cast<std::uint32_t>(i * 331 % 1024) << 20 | 3u << 30});
+    }
+    std::vector<RGBA16> output(input.size());
+    std::vector<RGB10A2> output10(input.size());
+    p3ToRgb(Span<const RGBA16>(input), Span<RGBA16>(output));
+    p3ToRgb(Span<const RGB10A2>(input10), Span<RGB10A2>(output10));
+
+    for (std::size_t i = 0; i < input.size(); ++i)
+    {
+        RGB expected = oklabToRgb(p3ToOklab(P3{input[i].r, input[i].g, input[i].b}, BitDepth::Sixteen), BitDepth::Sixteen);
+        ASSERT_EQ((RGB{output[i].r, output[i].g, output[i].b}), expected) << i;
+
+        std::uint32_t bits = input10[i].bits;
+        P3 p3{static_cast<int>(bits & 0x3ff), static_cast<int>((bits >> 10) & 0x3ff), static_cast<int>((bits >> 20) & 0x3ff)};
+        RGB expected10 = oklabToRgb(p3ToOklab(p3, BitDepth::Ten), BitDepth::Ten);
+        bits = output10[i].bits;
+        ASSERT_EQ((RGB{static_cast<int>(bits & 0x3ff), static_cast<int>((bits >> 10) & 0x3ff), static_cast<int>((bits >> 20) & 0x3ff)}),
+                  expected10)
+            << i;
+    }
+}
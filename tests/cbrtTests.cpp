@@ -0,0 +1,94 @@
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "gtest/gtest.h"
+#include "../src/MathUtils.h"
+#include "../src/simd/SimdKernels.h"
+
+using namespace oklab;
+
+namespace
+{
+    std::int64_t ulpDistance(double a, double b)
+    {
+        std::int64_t bitsA;
+        std::int64_t bitsB;
+        std::memcpy(&bitsA, &a, sizeof(double));
+        std::memcpy(&bitsB, &b, sizeof(double));
+        return bitsA > bitsB ? bitsA - bitsB : bitsB - bitsA;
+    }
+
+    // Covers the LMS values the RGB and P3 matrices produce from colors slightly out of [0, 1].
+    std::vector<double> lmsRangeValues()
+    {
+        std::vector<double> values;
+        const int steps = 500000;
+        for (int i = 0; i <= steps; ++i)
+        {
+            values.push_back(-0.5 + 2.0 * i / steps);
+        }
+        return values;
+    }
+}
+
+TEST(Cbrt, WithinOneUlpOfExactOverLmsRange)
+{
+    for (double value : lmsRangeValues())
+    {
+        double exact = static_cast<double>(std::cbrt(static_cast<long double>(value)));
+        ASSERT_LE(ulpDistance(oklab::cbrt(value), exact), 1) << "value " << value;
+        ASSERT_LE(ulpDistance(oklab::cbrt(value), std::cbrt(value)), 4) << "value " << value;
+    }
+}
+
+TEST(Cbrt, AccurateOverNormalRange)
+{
+    for (double value = 1e-300; value < 1e300; value *= 1.37)
+    {
+        double exact = static_cast<double>(std::cbrt(static_cast<long double>(value)));
+        ASSERT_LE(ulpDistance(oklab::cbrt(value), exact), 1) << "value " << value;
+        ASSERT_EQ(oklab::cbrt(-value), -oklab::cbrt(value)) << "value " << value;
+    }
+}
+
+TEST(Cbrt, SignedZeroAndExactCubes)
+{
+    EXPECT_EQ(oklab::cbrt(0.0), 0.0);
+    EXPECT_TRUE(std::signbit(oklab::cbrt(-0.0)));
+    EXPECT_EQ(oklab::cbrt(1.0), 1.0);
+    EXPECT_EQ(oklab::cbrt(-8.0), -2.0);
+    EXPECT_EQ(oklab::cbrt(0.125), 0.5);
+}
+
+TEST(Cbrt, KernelsMatchScalar)
+{
+    std::vector<const KernelTable *> tables = {&SCALAR_KERNELS};
+#ifdef OKLAB_X86_KERNELS
+    tables.insert(tables.end(), {&SSE42_KERNELS, &AVX2_KERNELS, &AVX512_KERNELS});
+#endif
+
+    std::vector<double> values = lmsRangeValues();
+
+    for (const KernelTable *table : tables)
+    {
+        if (!isSupported(*table))
+        {
+            continue;
+        }
+
+        for (std::size_t offset = 0; offset < values.size(); offset += BATCH_BLOCK_SIZE)
+        {
+            std::size_t count = std::min(BATCH_BLOCK_SIZE, values.size() - offset);
+            alignas(64) double plane[BATCH_BLOCK_SIZE] = {};
+            std::copy_n(values.begin() + offset, count, plane);
+
+            table->cbrt(plane, count);
+
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                ASSERT_EQ(plane[i], oklab::cbrt(values[offset + i])) << table->name << " value " << values[offset + i];
+            }
+        }
+    }
+}
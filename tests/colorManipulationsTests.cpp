@@ -0,0 +1,143 @@
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+#include "gtest/gtest.h"
+#include "ColorConversions.h"
+#include "ColorBatchConversions.h"
+#include "ColorManipulations.h"
+
+using namespace oklab;
+
+namespace
+{
+    // Colors spread over the cube, grays included
+    std::vector<RGB> makeRgbColors()
+    {
+        std::vector<RGB> colors;
+        for (int r = 0; r < 256; r += 17)
+            for (int g = 0; g < 256; g += 15)
+                for (int b = 0; b < 256; b += 51)
+                    colors.push_back(RGB{r, g, b});
+        return colors;
+    }
+
+    int maxDifference(const RGB &x, const RGB &y)
+    {
+        return std::max({std::abs(x[0] - y[0]), std::abs(x[1] - y[1]), std::abs(x[2] - y[2])});
+    }
+}
+
+TEST(ColorManipulations, SingleColorFunctionsAdjustOklch)
+{
+    RGB brown{150, 110, 80};
+    Oklch original = convertToOklch(brown);
+
+    EXPECT_NEAR(convertToOklch(darken(brown, 0.5))[0], original[0] * 0.5, 0.01);
+    EXPECT_NEAR(convertToOklch(lighten(brown, 0.5))[0], original[0] + (1 - original[0]) * 0.5, 0.01);
+    EXPECT_NEAR(convertToOklch(saturate(brown, -0.5))[1], original[1] * 0.5, 0.01);
+    EXPECT_NEAR(convertToOklch(rotateHue(brown, 90))[2], original[2] + 90, 1);
+
+    // Fully desaturated colors are grays, whose hue no rotation changes
+    RGB gray = saturate(brown, -1);
+    EXPECT_LE(std::abs(gray[0] - gray[1]) + std::abs(gray[1] - gray[2]), 1);
+    EXPECT_EQ(rotateHue(RGB{128, 128, 128}, 90), (RGB{128, 128, 128}));
+    EXPECT_EQ(convertFromOklch<P3>(convertToOklch(P3{40, 200, 90})), (P3{40, 200, 90}));
+}
+
+TEST(ColorManipulations, OklabAdjustmentsFollowTheirDefinition)
+{
+    std::vector<RGB> rgb = makeRgbColors();
+    std::vector<Oklab> input(rgb.size());
+    rgbToOklab(rgb, input);
+
+    for (OklchAdjustment adjustment : {OklchAdjustment{0.3, 0.5, 40}, OklchAdjustment{-0.4, -0.25, -200}, OklchAdjustment{}})
+    {
+        std::vector<Oklab> output(input.size());
+        adjustColors<Oklab>(input, output, adjustment);
+
+        double scale = 1 + adjustment.chroma;
+        double angle = adjustment.hue * M_PI / 180.0;
+        for (std::size_t i = 0; i < input.size(); ++i)
+        {
+            double lightness = input[i][0];
+            double expected = adjustment.lightness > 0 ? std::min(1.0, lightness + (1 - lightness) * adjustment.lightness)
+                                                       : lightness * (1 + adjustment.lightness);
+            ASSERT_EQ(output[i][0], expected) << i;
+            EXPECT_NEAR(output[i][1], scale * (std::cos(angle) * input[i][1] - std::sin(angle) * input[i][2]), 1e-15) << i;
+            EXPECT_NEAR(output[i][2], scale * (std::sin(angle) * input[i][1] + std::cos(angle) * input[i][2]), 1e-15) << i;
+        }
+    }
+}
+
+TEST(ColorManipulations, EncodedAdjustmentsMatchOklabAdjustments)
+{
+    std::vector<P3> p3;
+    for (const RGB &color : makeRgbColors())
+    {
+        p3.push_back(P3{color[0], color[1], color[2]});
+    }
+    OklchAdjustment adjustment{-0.1, 0.4, 75};
+
+    for (GamutMapping mapping : {GamutMapping::Css4, GamutMapping::Cusp, GamutMapping::Clamp})
+    {
+        std::vector<Oklab> oklab(p3.size());
+        p3ToOklab(p3, oklab);
+        adjustColors<Oklab>(oklab, oklab, adjustment);
+        std::vector<P3> expected(p3.size());
+        oklabToP3(oklab, expected, mapping);
+
+        // In place
+        std::vector<P3> output = p3;
+        adjustColors<P3>(output, output, adjustment, mapping);
+        for (std::size_t i = 0; i < p3.size(); ++i)
+        {
+            ASSERT_EQ(output[i], expected[i]) << i;
+        }
+    }
+}
+
+TEST(ColorManipulations, BatchAdjustmentsMatchSingleColorFunctions)
+{
+    std::vector<RGB> input = makeRgbColors();
+
+    struct Case
+    {
+        OklchAdjustment adjustment;
+        RGB (*single)(const RGB &);
+    };
+    const Case cases[] = {
+        {OklchAdjustment{0.25, 0, 0}, [](const RGB &color) { return lighten(color, 0.25); }},
+        {OklchAdjustment{-0.3, 0, 0}, [](const RGB &color) { return darken(color, 0.3); }},
+        {OklchAdjustment{0, 0.5, 0}, [](const RGB &color) { return saturate(color, 0.5); }},
+        {OklchAdjustment{0, -0.6, 0}, [](const RGB &color) { return saturate(color, -0.6); }},
+        {OklchAdjustment{0, 0, 135}, [](const RGB &color) { return rotateHue(color, 135); }},
+    };
+
+    for (const Case &test : cases)
+    {
+        std::vector<RGB> output(input.size());
+        adjustColors<RGB>(input, output, test.adjustment);
+
+        // Same Oklab color up to rounding: one code at most, on few colors
+        std::size_t mismatches = 0;
+        for (std::size_t i = 0; i < input.size(); ++i)
+        {
+            int difference = maxDifference(output[i], test.single(input[i]));
+            EXPECT_LE(difference, 1) << i;
+            mismatches += difference != 0;
+        }
+        EXPECT_LT(mismatches, input.size() / 100);
+    }
+}
+
+TEST(ColorManipulations, AdjustmentsRejectMismatchedSizes)
+{
+    std::vector<RGB> rgb = makeRgbColors();
+    std::vector<RGB> shortRgb(rgb.size() - 1);
+    std::vector<Oklab> oklab(3);
+    std::vector<Oklab> shortOklab(2);
+
+    EXPECT_THROW(adjustColors<RGB>(rgb, shortRgb, OklchAdjustment{0.1, 0, 0}), std::invalid_argument);
+    EXPECT_THROW(adjustColors<Oklab>(oklab, shortOklab, OklchAdjustment{0.1, 0, 0}), std::invalid_argument);
+}
@@ -0,0 +1,105 @@
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "gtest/gtest.h"
+#include "ColorConversions.h"
+#include "ConstexprConversions.h"
+#include "../src/OkLxx.h"
+
+using namespace oklab;
+
+namespace
+{
+    // Evaluated by the compiler: a failure here breaks the build.
+    constexpr Oklab WHITE = constant::rgbToOklab(RGB{255, 255, 255});
+    static_assert(WHITE[0] > 0.99999 && WHITE[0] < 1.00001, "White has a lightness of 1");
+
+    constexpr std::array<RGB, 3> PALETTE = {
+        constant::p3ToRgb(P3{255, 0, 0}),
+        constant::p3ToRgb(P3{0, 255, 0}),
+        constant::oklabToRgb(constant::oklchToOklab(Oklch{0.7, 0.1, 250.0}))};
+    static_assert(PALETTE[0][0] > 240 && PALETTE[0][1] < 40 && PALETTE[1][1] > 240, "P3 primaries map to saturated sRGB colors");
+
+    constexpr P3 SRGB_RED_IN_P3 = constant::rgbToP3(RGB{255, 0, 0});
+    static_assert(SRGB_RED_IN_P3[0] < 255 && SRGB_RED_IN_P3[1] > 0, "sRGB red lies inside P3");
+
+    constexpr RGB CUSP_MAPPED_GREEN = constant::p3ToRgb(P3{0, 255, 0}, GamutMapping::Cusp);
+    static_assert(CUSP_MAPPED_GREEN[1] > 200 && CUSP_MAPPED_GREEN[0] < 40, "Any gamut mapping runs at compile time");
+}
+
+TEST(ConstexprConversions, OklabWithinFewUlpsOfRuntime)
+{
+    for (int r = 0; r < 256; r += 5)
+        for (int g = 0; g < 256; g += 5)
+            for (int b = 0; b < 256; b += 5)
+            {
+                Oklab expected = rgbToOklab(RGB{r, g, b});
+                Oklab actual = constant::rgbToOklab(RGB{r, g, b});
+                for (int c = 0; c < 3; ++c)
+                {
+                    ASSERT_NEAR(actual[c], expected[c], 1e-15) << r << " " << g << " " << b;
+                }
+            }
+}
+
+TEST(ConstexprConversions, GamutMappedConversionsMatchRuntime)
+{
+    for (int r = 0; r < 256; r += 5)
+        for (int g = 0; g < 256; g += 5)
+            for (int b = 0; b < 256; b += 5)
+            {
+                ASSERT_EQ(constant::p3ToRgb(P3{r, g, b}), p3ToRgb(P3{r, g, b}, GamutMapping::Css4)) << r << " " << g << " " << b;
+                ASSERT_EQ(constant::rgbToP3(RGB{r, g, b}), rgbToP3(RGB{r, g, b}, GamutMapping::Css4)) << r << " " << g << " " << b;
+            }
+}
+
+TEST(ConstexprConversions, OklchMatchesRuntime)
+{
+    for (const Oklab &oklab : {Oklab{0.5, 0.1, -0.05}, Oklab{0.8, -0.2, 0.0}, Oklab{0.3, 0.0, 0.15}, Oklab{0.6, -0.01, -0.3}})
+    {
+        EXPECT_EQ(constant::oklabToP3(oklab), oklabToP3(oklab, GamutMapping::Css4));
+        EXPECT_EQ(constant::oklabToRgb(oklab), oklabToRgb(oklab, GamutMapping::Css4));
+    }
+    for (double hue = 0.0; hue < 720.0; hue += 7.5)
+    {
+        Oklab expected = oklchToOklab(Oklch{0.5, 0.2, hue});
+        Oklab actual = constant::oklchToOklab(Oklch{0.5, 0.2, hue});
+        EXPECT_NEAR(actual[1], expected[1], 1e-15) << hue;
+        EXPECT_NEAR(actual[2], expected[2], 1e-15) << hue;
+        EXPECT_NEAR(constant::oklabToOklch(expected)[2], oklabToOklch(expected)[2], 1e-12) << hue;
+    }
+}
+
+TEST(ConstexprConversions, GamutMappingsMatchRuntimeOnRandomOklab)
+{
+    EXPECT_EQ(DEFAULT_GAMUT_MAPPING, defaultGamutMapping());
+
+    // Any Oklab color, far out of gamut and with lightness outside [0, 1], not only 8-bit sources
+    std::uint64_t state = 0x2545F4914F6CDD1Dull;
+    auto next = [&state]()
+    {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        return static_cast<double>(state >> 11) / static_cast<double>(1ull << 53);
+    };
+
+    std::vector<Oklab> input = {
+        // Where the clipped deltaE folds back at a threshold
+        Oklab{0.98356513378555666, -0.11890936588590467, 0.40493080914847479},
+        Oklab{0.46013582449629048, -0.056898753848912687, -0.35459939868241475},
+        Oklab{0.97308668992289515, -0.080308000576213179, 0.28261100734399069},
+    };
+    for (int i = 0; i < 100000; ++i)
+    {
+        input.push_back(Oklab{next() * 1.2 - 0.1, next() - 0.5, next() - 0.5});
+    }
+
+    for (GamutMapping mapping : {GamutMapping::Css4, GamutMapping::Cusp, GamutMapping::Clamp, GamutMapping::None})
+    {
+        for (size_t i = 0; i < input.size(); ++i)
+        {
+            ASSERT_EQ(constant::oklabToRgb(input[i], mapping), oklabToRgb(input[i], mapping)) << "at index " << i;
+            ASSERT_EQ(constant::oklabToP3(input[i], mapping), oklabToP3(input[i], mapping)) << "at index " << i;
+        }
+    }
+}
@@ -0,0 +1,118 @@
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "ConversionCache.h"
+#include "ColorConversions.h"
+
+using namespace oklab;
+
+TEST(ConversionCache, FillsBlocksOnFirstTouch)
+{
+    P3ToRgbCache cache;
+
+    EXPECT_EQ(cache.convert(P3{255, 0, 0}), p3ToRgb(P3{255, 0, 0}));
+    CacheStatistics statistics = cache.statistics();
+    EXPECT_EQ(statistics.hits, 0u);
+    EXPECT_EQ(statistics.misses, 1u);
+    EXPECT_EQ(statistics.blockFills, 1u);
+    EXPECT_EQ(cache.memoryUsage(), P3ToRgbCache::BLOCK_BYTES);
+
+    // Same 16x16x16 block
+    for (int r = 240; r < 256; ++r)
+    {
+        for (int b = 0; b < 16; ++b)
+        {
+            ASSERT_EQ(cache.convert(P3{r, 7, b}), p3ToRgb(P3{r, 7, b})) << r << " 7 " << b;
+        }
+    }
+    statistics = cache.statistics();
+    EXPECT_EQ(statistics.hits, 256u);
+    EXPECT_EQ(statistics.blockFills, 1u);
+}
+
+TEST(ConversionCache, MatchesConversionOnAllInputs)
+{
+    RgbToP3Cache cache;
+
+    std::vector<RGB> input;
+    for (int i = 0; i < (1 << 24); i += 7)
+    {
+        input.push_back(RGB{i >> 16, (i >> 8) & 0xff, i & 0xff});
+    }
+    std::vector<P3> output(input.size());
+    cache.convert(input, output);
+
+    for (std::size_t i = 0; i < input.size(); ++i)
+    {
+        ASSERT_EQ(output[i], rgbToP3(input[i])) << input[i][0] << " " << input[i][1] << " " << input[i][2];
+    }
+    EXPECT_EQ(cache.statistics().blockFills, RgbToP3Cache::BLOCK_COUNT);
+}
+
+TEST(ConversionCache, RejectsMismatchedBuffers)
+{
+    P3ToRgbCache cache;
+    std::vector<P3> input(8, P3{255, 0, 0});
+    std::vector<RGB> output(7);
+
+    EXPECT_THROW(cache.convert(input, output), std::invalid_argument);
+    EXPECT_EQ(cache.statistics().misses, 0u);
+}
+
+TEST(ConversionCache, BypassesOnceMemoryLimitIsReached)
+{
+    P3ToRgbCache cache(2 * P3ToRgbCache::BLOCK_BYTES);
+
+    std::vector<P3> colors = {P3{0, 0, 0}, P3{255, 255, 255}, P3{128, 0, 255}, P3{130, 3, 250}};
+    for (const P3 &color : colors)
+    {
+        EXPECT_EQ(cache.convert(color), p3ToRgb(color));
+    }
+
+    CacheStatistics statistics = cache.statistics();
+    EXPECT_EQ(statistics.blockFills, 2u);
+    EXPECT_EQ(statistics.bypasses, 2u);
+    EXPECT_EQ(cache.memoryUsage(), 2 * P3ToRgbCache::BLOCK_BYTES);
+}
+
+TEST(ConversionCache, ConcurrentThreadsShareTheCache)
+{
+    P3ToRgbCache cache;
+    const int threadCount = 4;
+    const int colorsPerThread = 20000;
+    std::vector<int> mismatches(threadCount, 0);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t)
+    {
+        threads.emplace_back([&, t]()
+        {
+            // Few distinct blocks, so threads race on the same ones
+            std::mt19937 random(t);
+            std::uniform_int_distribution<int> channel(96, 159);
+            for (int i = 0; i < colorsPerThread; ++i)
+            {
+                P3 color{channel(random), channel(random), channel(random)};
+                if (cache.convert(color) != p3ToRgb(color))
+                {
+                    ++mismatches[t];
+                }
+            }
+        });
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+
+    for (int t = 0; t < threadCount; ++t)
+    {
+        EXPECT_EQ(mismatches[t], 0);
+    }
+    CacheStatistics statistics = cache.statistics();
+    EXPECT_EQ(statistics.hits + statistics.misses, std::uint64_t{threadCount * colorsPerThread});
+    EXPECT_LE(statistics.blockFills, 64u);
+    EXPECT_EQ(cache.memoryUsage(), statistics.blockFills * P3ToRgbCache::BLOCK_BYTES);
+}
@@ -0,0 +1,96 @@
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "ConversionTable.h"
+#include "ColorConversions.h"
+
+using namespace oklab;
+
+namespace
+{
+    std::string tablePath(const std::string &name)
+    {
+        return testing::TempDir() + "oklab_" + name + ".lut";
+    }
+}
+
+TEST(ConversionTable, RgbToP3TableMatchesConversion)
+{
+    std::string path = tablePath("rgbToP3");
+    ASSERT_TRUE(RgbToP3Table::build(path, 2));
+
+    std::unique_ptr<RgbToP3Table> table = RgbToP3Table::open(path);
+    ASSERT_NE(table, nullptr);
+
+    for (int r = 0; r < 256; ++r)
+    {
+        for (int g = 0; g < 256; ++g)
+        {
+            for (int b = 0; b < 256; ++b)
+            {
+                RGB rgb{r, g, b};
+                ASSERT_EQ(table->convert(rgb), rgbToP3(rgb)) << r << " " << g << " " << b;
+            }
+        }
+    }
+
+    std::remove(path.c_str());
+}
+
+TEST(ConversionTable, P3ToRgbTableMatchesConversion)
+{
+    std::string path = tablePath("p3ToRgb");
+    ASSERT_TRUE(P3ToRgbTable::build(path));
+
+    std::unique_ptr<P3ToRgbTable> table = P3ToRgbTable::open(path);
+    ASSERT_NE(table, nullptr);
+
+    std::vector<P3> input;
+    for (int i = 0; i < (1 << 24); i += 997)
+    {
+        input.push_back(P3{i >> 16, (i >> 8) & 0xff, i & 0xff});
+    }
+    input.push_back(P3{255, 255, 255});
+    std::vector<RGB> output(input.size());
+    table->convert(input, output);
+
+    for (std::size_t i = 0; i < input.size(); ++i)
+    {
+        ASSERT_EQ(output[i], p3ToRgb(input[i])) << input[i][0] << " " << input[i][1] << " " << input[i][2];
+    }
+
+    std::vector<RGB> shortOutput(input.size() - 1);
+    EXPECT_THROW(table->convert(input, shortOutput), std::invalid_argument);
+
+    std::remove(path.c_str());
+}
+
+TEST(ConversionTable, RejectsMissingOrMismatchedFiles)
+{
+    EXPECT_EQ(P3ToRgbTable::open(tablePath("missing")), nullptr);
+
+    std::string path = tablePath("mismatched");
+    ASSERT_TRUE(RgbToP3Table::build(path));
+    EXPECT_EQ(P3ToRgbTable::open(path), nullptr);
+
+    // Wrong format version
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(offsetof(ConversionTableHeader, formatVersion));
+        file.put(static_cast<char>(0x7f));
+    }
+    EXPECT_EQ(RgbToP3Table::open(path), nullptr);
+
+    // Truncated
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        ConversionTableHeader header{};
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    }
+    EXPECT_EQ(RgbToP3Table::open(path), nullptr);
+
+    std::remove(path.c_str());
+}
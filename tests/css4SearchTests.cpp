@@ -0,0 +1,33 @@
+#include <vector>
+#include "gtest/gtest.h"
+#include "ColorConversions.h"
+#include "ColorBatchConversions.h"
+
+using namespace oklab;
+
+// Colors whose clipped deltaE folds back at a threshold of the CSS4 chroma search: the
+// single-color and batch conversions both run the bisection on them, with the same result.
+
+TEST(Css4Search, FoldsMatchInSingleAndBatchConversions)
+{
+    std::vector<Oklab> colors = {
+        Oklab{0.98356513378555666, -0.11890936588590467, 0.40493080914847479},
+        Oklab{0.46013582449629048, -0.056898753848912687, -0.35459939868241475},
+        Oklab{0.97308668992289515, -0.080308000576213179, 0.28261100734399069},
+    };
+
+    std::vector<RGB> rgb(colors.size());
+    std::vector<P3> p3(colors.size());
+    oklabToRgb(colors, rgb, GamutMapping::Css4);
+    oklabToP3(colors, p3, GamutMapping::Css4);
+
+    for (std::size_t i = 0; i < colors.size(); ++i)
+    {
+        EXPECT_EQ(rgb[i], oklabToRgb(colors[i], GamutMapping::Css4)) << i;
+        EXPECT_EQ(p3[i], oklabToP3(colors[i], GamutMapping::Css4)) << i;
+    }
+
+    EXPECT_EQ(rgb[0], (RGB{255, 255, 0}));
+    EXPECT_EQ(rgb[1], (RGB{0, 32, 255}));
+    EXPECT_EQ(p3[2], (P3{255, 254, 0}));
+}
@@ -0,0 +1,103 @@
+#include <algorithm>
+#include <cmath>
+#include "gtest/gtest.h"
+#include "ColorConversions.h"
+#include "../src/ColorConversionsInternal.h"
+#include "../src/OkLxx.h"
+#include "../src/gamutMapping/Cusp.h"
+
+using namespace oklab;
+
+// The cusp mapping is called directly, whatever MAPPING_ALGORITHM the library was built with.
+
+namespace
+{
+    // Every 5th code per channel, both ends included: 52^3 colors.
+    template <typename Function>
+    void forEachSampledColor(Function function)
+    {
+        for (int r = 0; r < 256; r += 5)
+            for (int g = 0; g < 256; g += 5)
+                for (int b = 0; b < 256; b += 5)
+                    function(r, g, b);
+    }
+}
+
+TEST(CuspGamutMapping, InGamutColorsUnchanged)
+{
+    forEachSampledColor([](int r, int g, int b)
+    {
+        RGB rgb{r, g, b};
+        ASSERT_EQ((performCuspGamutMapping<RGB, LinearSRGB>(rgbToOklab(rgb))), rgb);
+        ASSERT_EQ((performCuspGamutMapping<P3, LinearP3>(rgbToOklab(rgb))), rgbToP3(rgb));
+    });
+}
+
+TEST(CuspGamutMapping, KeepsLightnessAndHueOnTheBoundary)
+{
+    forEachSampledColor([](int r, int g, int b)
+    {
+        Oklab oklab = p3ToOklab(P3{r, g, b});
+        if (oklab[0] <= 0 || oklab[0] >= 1 || isInGamut(oklabToLinearColor<LinearSRGB>(oklab)))
+        {
+            return;
+        }
+
+        GammaSRGB mapped = performCuspGamutMapping<GammaSRGB, LinearSRGB>(oklab);
+        Oklab mappedOklab = gammaSRGBToOklab(mapped);
+        // The final clip moves colors a little next to the blue primary, where the boundary folds
+        ASSERT_NEAR(mappedOklab[0], oklab[0], 5e-3) << r << " " << g << " " << b;
+
+        double chroma = std::hypot(oklab[1], oklab[2]);
+        double mappedChroma = std::hypot(mappedOklab[1], mappedOklab[2]);
+        ASSERT_LE(mappedChroma, chroma + 1e-9) << r << " " << g << " " << b;
+        ASSERT_NEAR(mappedOklab[1] * oklab[2] - mappedOklab[2] * oklab[1], 0, 5e-3 * chroma) << r << " " << g << " " << b;
+
+        // On the boundary: one channel at 0 or 1
+        double lowest = std::min({mapped[0], mapped[1], mapped[2]});
+        double highest = std::max({mapped[0], mapped[1], mapped[2]});
+        ASSERT_TRUE(lowest < 1e-3 || highest > 1 - 1e-3) << r << " " << g << " " << b;
+    });
+}
+
+TEST(CuspGamutMapping, OutOfRangeOklabMapsIntoGamut)
+{
+    for (double lightness : {-0.5, 0.0, 0.001, 0.3, 0.7, 0.999, 1.0, 1.5})
+    {
+        for (double hue = 0; hue < 360; hue += 7.5)
+        {
+            for (double chroma : {0.05, 0.4, 2.0})
+            {
+                double angle = hue * M_PI / 180;
+                Oklab oklab{lightness, chroma * std::cos(angle), chroma * std::sin(angle)};
+                GammaSRGB rgb = performCuspGamutMapping<GammaSRGB, LinearSRGB>(oklab);
+                GammaP3 p3 = performCuspGamutMapping<GammaP3, LinearP3>(oklab);
+                for (int c = 0; c < 3; ++c)
+                {
+                    ASSERT_TRUE(rgb[c] >= 0 && rgb[c] <= 1) << lightness << " " << hue << " " << chroma;
+                    ASSERT_TRUE(p3[c] >= 0 && p3[c] <= 1) << lightness << " " << hue << " " << chroma;
+                }
+            }
+        }
+    }
+}
+
+TEST(CuspGamutMapping, CloseToCss4)
+{
+    // CSS4 keeps some chroma beyond the boundary as long as clipping it is not noticeable, so the
+    // two mappings differ by a few hundredths of deltaE at most.
+    double maxError = 0;
+    double sumError = 0;
+    int count = 0;
+    forEachSampledColor([&](int r, int g, int b)
+    {
+        P3 p3{r, g, b};
+        RGB cusp = performCuspGamutMapping<RGB, LinearSRGB>(p3ToOklab(p3));
+        double error = deltaE(rgbToOklab(cusp), rgbToOklab(p3ToRgb(p3)));
+        maxError = std::max(maxError, error);
+        sumError += error;
+        ++count;
+    });
+    EXPECT_LT(maxError, 0.06);
+    EXPECT_LT(sumError / count, 0.01);
+}
@@ -0,0 +1,38 @@
+#include "gtest/gtest.h"
+#include "ColorConversions.h"
+
+using namespace oklab;
+
+// rgbToP3 / p3ToRgb take a direct linear transform for in-gamut colors; rgbToP3<double> /
+// p3ToRgb<double> always go through Oklab. Both must agree bit for bit.
+
+TEST(DirectConversions, RgbToP3MatchesOklabRoute)
+{
+    for (int r = 0; r < 256; r += 3)
+        for (int g = 0; g < 256; g += 3)
+            for (int b = 0; b < 256; b += 3)
+            {
+                ASSERT_EQ(rgbToP3(RGB{r, g, b}), rgbToP3<double>(RGB{r, g, b})) << r << " " << g << " " << b;
+            }
+}
+
+TEST(DirectConversions, P3ToRgbMatchesOklabRoute)
+{
+    for (int r = 0; r < 256; r += 3)
+        for (int g = 0; g < 256; g += 3)
+            for (int b = 0; b < 256; b += 3)
+            {
+                ASSERT_EQ(p3ToRgb(P3{r, g, b}), p3ToRgb<double>(P3{r, g, b})) << r << " " << g << " " << b;
+            }
+}
+
+TEST(DirectConversions, GamutEdges)
+{
+    for (int value : {0, 1, 254, 255})
+    {
+        EXPECT_EQ(rgbToP3(RGB{value, value, value}), rgbToP3<double>(RGB{value, value, value}));
+        EXPECT_EQ(p3ToRgb(P3{value, value, value}), p3ToRgb<double>(P3{value, value, value}));
+        EXPECT_EQ(rgbToP3(RGB{value, 0, 255}), rgbToP3<double>(RGB{value, 0, 255}));
+        EXPECT_EQ(p3ToRgb(P3{255, value, 0}), p3ToRgb<double>(P3{255, value, 0}));
+    }
+}
@@ -0,0 +1,70 @@
+#include <cmath>
+#include <cstdlib>
+#include "gtest/gtest.h"
+#include "ColorConversions.h"
+
+using namespace oklab;
+
+namespace
+{
+    // Every 5th code per channel, both ends included: 52^3 colors.
+    template <typename Function>
+    void forEachSampledColor(Function function)
+    {
+        for (int r = 0; r < 256; r += 5)
+            for (int g = 0; g < 256; g += 5)
+                for (int b = 0; b < 256; b += 5)
+                    function(r, g, b);
+    }
+
+    template <typename A, typename B>
+    int maxChannelDifference(const A &a, const B &b)
+    {
+        int difference = 0;
+        for (int c = 0; c < 3; ++c)
+        {
+            difference = std::max(difference, std::abs(a[c] - b[c]));
+        }
+        return difference;
+    }
+}
+
+TEST(FloatPipeline, OklabCloseToDouble)
+{
+    forEachSampledColor([](int r, int g, int b)
+    {
+        Oklabf single = rgbToOklab<float>(RGB{r, g, b});
+        Oklab reference = rgbToOklab(RGB{r, g, b});
+        for (int c = 0; c < 3; ++c)
+        {
+            ASSERT_NEAR(single[c], reference[c], 1e-6) << r << " " << g << " " << b;
+        }
+    });
+}
+
+TEST(FloatPipeline, RoundTripsMatchDouble)
+{
+    forEachSampledColor([](int r, int g, int b)
+    {
+        ASSERT_EQ(oklabToRgb(rgbToOklab<float>(RGB{r, g, b})), oklabToRgb(rgbToOklab(RGB{r, g, b})));
+        ASSERT_EQ(oklabToP3(p3ToOklab<float>(P3{r, g, b})), oklabToP3(p3ToOklab(P3{r, g, b})));
+    });
+}
+
+TEST(FloatPipeline, GamutMappedConversionsWithinOneCode)
+{
+    forEachSampledColor([](int r, int g, int b)
+    {
+        ASSERT_LE(maxChannelDifference(p3ToRgb<float>(P3{r, g, b}), p3ToRgb(P3{r, g, b})), 1) << r << " " << g << " " << b;
+        ASSERT_LE(maxChannelDifference(rgbToP3<float>(RGB{r, g, b}), rgbToP3(RGB{r, g, b})), 1) << r << " " << g << " " << b;
+    });
+}
+
+TEST(FloatPipeline, DoubleInstantiationMatchesDefault)
+{
+    for (const RGB &rgb : {RGB{0, 0, 0}, RGB{255, 0, 0}, RGB{12, 200, 99}})
+    {
+        EXPECT_EQ(rgbToOklab<double>(rgb), rgbToOklab(rgb));
+        EXPECT_EQ(rgbToP3<double>(rgb), rgbToP3(rgb));
+    }
+}
@@ -0,0 +1,111 @@
+#include <vector>
+#include "gtest/gtest.h"
+#include "ColorConversions.h"
+#include "ColorBatchConversions.h"
+#include "GamutMapping.h"
+
+using namespace oklab;
+
+namespace
+{
+    const GamutMapping ALL_MAPPINGS[] = {GamutMapping::Css4, GamutMapping::Cusp, GamutMapping::Clamp, GamutMapping::None};
+
+    // Oklab colors covering in-gamut, out-of-gamut and out-of-range lightness values.
+    std::vector<Oklab> oklabGrid()
+    {
+        std::vector<Oklab> colors;
+        for (int l = -1; l <= 11; ++l)
+            for (int a = -8; a <= 8; ++a)
+                for (int b = -8; b <= 8; ++b)
+                    colors.push_back(Oklab{l / 10.0, a * 0.05, b * 0.05});
+        return colors;
+    }
+
+    template <typename ColorType>
+    bool isEncodable(const ColorType &color)
+    {
+        return color[0] >= 0 && color[0] <= 255 && color[1] >= 0 && color[1] <= 255 && color[2] >= 0 && color[2] <= 255;
+    }
+}
+
+TEST(GamutMappingPolicy, DefaultOverloadsUseDefaultMapping)
+{
+    std::vector<Oklab> input = oklabGrid();
+    std::vector<RGB> rgb(input.size());
+    std::vector<P3> p3(input.size());
+    oklabToRgb(input, rgb, defaultGamutMapping());
+    oklabToP3(input, p3, defaultGamutMapping());
+
+    for (size_t i = 0; i < input.size(); ++i)
+    {
+        ASSERT_EQ(oklabToRgb(input[i], defaultGamutMapping()), oklabToRgb(input[i])) << "at index " << i;
+        ASSERT_EQ(oklabToP3(input[i], defaultGamutMapping()), oklabToP3(input[i])) << "at index " << i;
+        ASSERT_EQ(rgb[i], oklabToRgb(input[i])) << "at index " << i;
+        ASSERT_EQ(p3[i], oklabToP3(input[i])) << "at index " << i;
+    }
+}
+
+TEST(GamutMappingPolicy, BatchMatchesScalarForEveryMapping)
+{
+    std::vector<Oklab> input = oklabGrid();
+    std::vector<double> l, a, b;
+    for (const Oklab &color : input)
+    {
+        l.push_back(color[0]);
+        a.push_back(color[1]);
+        b.push_back(color[2]);
+    }
+
+    for (GamutMapping mapping : ALL_MAPPINGS)
+    {
+        std::vector<RGB> rgb(input.size());
+        std::vector<P3> p3(input.size());
+        std::vector<int> r(input.size()), g(input.size()), bl(input.size());
+        oklabToRgb(input, rgb, mapping);
+        oklabToP3(input, p3, mapping);
+        oklabToRgb(Planar<const double>(l, a, b), Planar<int>(r, g, bl), mapping);
+
+        for (size_t i = 0; i < input.size(); ++i)
+        {
+            RGB expected = oklabToRgb(input[i], mapping);
+            ASSERT_EQ(rgb[i], expected) << "mapping " << static_cast<int>(mapping) << " at index " << i;
+            ASSERT_EQ((RGB{r[i], g[i], bl[i]}), expected) << "mapping " << static_cast<int>(mapping) << " at index " << i;
+            ASSERT_EQ(p3[i], oklabToP3(input[i], mapping)) << "mapping " << static_cast<int>(mapping) << " at index " << i;
+        }
+    }
+}
+
+TEST(GamutMappingPolicy, MappingsBringColorsIntoGamut)
+{
+    for (const Oklab &color : oklabGrid())
+    {
+        for (GamutMapping mapping : {GamutMapping::Css4, GamutMapping::Cusp, GamutMapping::Clamp})
+        {
+            ASSERT_TRUE(isEncodable(oklabToRgb(color, mapping))) << "mapping " << static_cast<int>(mapping);
+            ASSERT_TRUE(isEncodable(oklabToP3(color, mapping))) << "mapping " << static_cast<int>(mapping);
+        }
+    }
+
+    // Without mapping, a saturated P3 red is out of the sRGB range
+    RGB unmapped = oklabToRgb(p3ToOklab(P3{255, 0, 0}), GamutMapping::None);
+    EXPECT_FALSE(isEncodable(unmapped));
+}
+
+TEST(GamutMappingPolicy, MappingsDifferOnlyOutOfGamut)
+{
+    for (int r = 0; r <= 255; r += 17)
+        for (int g = 0; g <= 255; g += 17)
+            for (int b = 0; b <= 255; b += 17)
+            {
+                RGB rgb{r, g, b};
+                P3 p3 = rgbToP3(rgb);
+                for (GamutMapping mapping : ALL_MAPPINGS)
+                {
+                    ASSERT_EQ(rgbToP3(rgb, mapping), p3) << "mapping " << static_cast<int>(mapping);
+                }
+            }
+
+    P3 red{255, 0, 0};
+    EXPECT_EQ(p3ToRgb(red, GamutMapping::Clamp), (RGB{255, 0, 0}));
+    EXPECT_NE(p3ToRgb(red, GamutMapping::Css4), p3ToRgb(red, GamutMapping::Clamp));
+}
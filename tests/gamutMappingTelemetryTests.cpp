@@ -0,0 +1,130 @@
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "ColorConversions.h"
+#include "ColorBatchConversions.h"
+#include "GamutMappingTelemetry.h"
+
+using namespace oklab;
+
+namespace
+{
+    std::uint64_t histogramTotal(const GamutMappingTelemetry &telemetry)
+    {
+        std::uint64_t total = 0;
+        for (std::uint64_t count : telemetry.iterations)
+        {
+            total += count;
+        }
+        return total;
+    }
+}
+
+TEST(GamutMappingTelemetry, CountsEachExit)
+{
+    if (!gamutMappingTelemetryEnabled())
+    {
+        GTEST_SKIP() << "built without OKLAB_TELEMETRY";
+    }
+
+    resetGamutMappingTelemetry();
+    oklabToRgb(Oklab{1.2, 0.0, 0.0}, GamutMapping::Css4);
+    oklabToRgb(Oklab{-0.1, 0.0, 0.0}, GamutMapping::Css4);
+    oklabToRgb(Oklab{0.5, 0.0, 0.0}, GamutMapping::Css4);
+    oklabToRgb(p3ToOklab(P3{255, 0, 0}), GamutMapping::Css4);
+
+    GamutMappingTelemetry telemetry = gamutMappingTelemetry();
+    EXPECT_EQ(telemetry.calls, 4u);
+    EXPECT_EQ(telemetry.whiteExits, 1u);
+    EXPECT_EQ(telemetry.blackExits, 1u);
+    EXPECT_EQ(telemetry.inGamutExits, 1u);
+    EXPECT_EQ(telemetry.clipExits + telemetry.searches, 1u);
+    EXPECT_EQ(telemetry.searches, telemetry.convergedExits + telemetry.thresholdExits);
+    EXPECT_EQ(histogramTotal(telemetry), telemetry.searches);
+    EXPECT_GE(telemetry.totalIterations, telemetry.searches);
+}
+
+TEST(GamutMappingTelemetry, CountsFastPathsAndSearches)
+{
+    if (!gamutMappingTelemetryEnabled())
+    {
+        GTEST_SKIP() << "built without OKLAB_TELEMETRY";
+    }
+
+    std::vector<P3> input;
+    for (int r = 0; r < 256; r += 15)
+        for (int g = 0; g < 256; g += 15)
+            for (int b = 0; b < 256; b += 15)
+                input.push_back(P3{r, g, b});
+    std::vector<Oklab> oklab(input.size());
+    std::vector<RGB> output(input.size());
+    p3ToOklab(input, oklab);
+
+    resetGamutMappingTelemetry();
+    oklabToRgb(oklab, output, GamutMapping::Css4);
+    GamutMappingTelemetry batch = gamutMappingTelemetry();
+    EXPECT_EQ(batch.calls, input.size());
+    EXPECT_GT(batch.inGamutExits, 0u);
+    EXPECT_GT(batch.searches, 0u);
+    EXPECT_EQ(histogramTotal(batch), batch.searches);
+
+    resetGamutMappingTelemetry();
+    for (const P3 &color : input)
+    {
+        p3ToRgb(color, GamutMapping::Css4);
+    }
+    GamutMappingTelemetry single = gamutMappingTelemetry();
+    EXPECT_EQ(single.calls, batch.calls);
+    EXPECT_EQ(single.inGamutExits, batch.inGamutExits);
+    EXPECT_EQ(single.searches, batch.searches);
+    EXPECT_EQ(single.thresholdExits, batch.thresholdExits);
+
+    // Both run every step of the bisection
+    EXPECT_EQ(single.totalIterations, batch.totalIterations);
+}
+
+TEST(GamutMappingTelemetry, OtherMappingsAreNotCounted)
+{
+    resetGamutMappingTelemetry();
+    oklabToRgb(p3ToOklab(P3{255, 0, 0}), GamutMapping::Clamp);
+    oklabToRgb(p3ToOklab(P3{255, 0, 0}), GamutMapping::Cusp);
+    p3ToRgb(P3{128, 128, 128}, GamutMapping::None);
+    EXPECT_EQ(gamutMappingTelemetry().calls, 0u);
+}
+
+TEST(GamutMappingTelemetry, SumsThreadsAfterTheyExit)
+{
+    if (!gamutMappingTelemetryEnabled())
+    {
+        GTEST_SKIP() << "built without OKLAB_TELEMETRY";
+    }
+
+    const int THREADS = 4;
+    const int COLORS_PER_THREAD = 1000;
+
+    resetGamutMappingTelemetry();
+    for (int round = 0; round < 2; ++round)
+    {
+        std::vector<std::thread> threads;
+        for (int t = 0; t < THREADS; ++t)
+        {
+            threads.emplace_back([t]()
+            {
+                for (int i = 0; i < COLORS_PER_THREAD; ++i)
+                {
+                    oklabToRgb(Oklab{0.5, 0.001 * t, 0.0001 * i}, GamutMapping::Css4);
+                }
+            });
+        }
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+
+        // The second round reuses the blocks of the first one's threads
+        EXPECT_EQ(gamutMappingTelemetry().calls, static_cast<std::uint64_t>((round + 1) * THREADS * COLORS_PER_THREAD));
+    }
+
+    resetGamutMappingTelemetry();
+    EXPECT_EQ(gamutMappingTelemetry().calls, 0u);
+}
@@ -0,0 +1,160 @@
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+#include "gtest/gtest.h"
+#include "ColorBatchConversions.h"
+#include "ColorConversions.h"
+#include "Gradient.h"
+#include "../src/OkLxx.h"
+
+using namespace oklab;
+
+namespace
+{
+    const Oklab RED = rgbToOklab(RGB{255, 0, 0});
+    const Oklab BLUE = rgbToOklab(RGB{0, 0, 255});
+    const Oklab WHITE = rgbToOklab(RGB{255, 255, 255});
+
+    double hueAt(const Gradient &gradient, double position)
+    {
+        return oklabToOklch(gradient.sample(position))[2];
+    }
+
+    // Angle from `from` to `to`, in (-180, 180]
+    double hueDifference(double from, double to)
+    {
+        double delta = std::fmod(to - from, 360.0);
+        return delta > 180 ? delta - 360 : (delta <= -180 ? delta + 360 : delta);
+    }
+}
+
+TEST(Gradient, TwoStopsMatchOklabInterpolation)
+{
+    GradientStop stops[] = {{RED, 0.0}, {BLUE, 1.0}};
+    Gradient gradient(stops);
+
+    std::vector<RGB> ramp(4096);
+    gradient.fillRamp<RGB>(ramp);
+    for (std::size_t i = 0; i < ramp.size(); ++i)
+    {
+        double t = static_cast<double>(i) / (ramp.size() - 1);
+        Oklab expected{RED[0] * (1 - t) + BLUE[0] * t, RED[1] * (1 - t) + BLUE[1] * t, RED[2] * (1 - t) + BLUE[2] * t};
+        ASSERT_EQ(gradient.sample(t), expected) << i;
+        ASSERT_EQ(ramp[i], oklabToRgb(expected)) << i;
+    }
+}
+
+TEST(Gradient, BatchOutputsMatchSingleConversions)
+{
+    GradientStop stops[] = {{RED, 0.1}, {WHITE, 0.4}, {BLUE, 0.4}, {rgbToOklab(RGB{0, 200, 40}), 0.9}};
+    Gradient gradient(stops, GradientSpace::Oklch, HueInterpolation::Longer);
+
+    std::vector<double> positions;
+    for (int i = -50; i <= 1050; ++i)
+    {
+        positions.push_back(i / 1000.0);
+    }
+    std::vector<Oklab> oklab(positions.size());
+    std::vector<P3> p3(positions.size());
+    std::vector<GammaSRGB> gammaRgb(positions.size());
+    gradient.sample<Oklab>(positions, oklab);
+    gradient.sample<P3>(positions, p3, GamutMapping::Css4);
+    gradient.sample<GammaSRGB>(positions, gammaRgb, GamutMapping::Cusp);
+
+    for (std::size_t i = 0; i < positions.size(); ++i)
+    {
+        ASSERT_EQ(oklab[i], gradient.sample(positions[i])) << i;
+        ASSERT_EQ(p3[i], oklabToP3(oklab[i], GamutMapping::Css4)) << i;
+        ASSERT_EQ(gammaRgb[i], oklabToGammaSRGB(oklab[i], GamutMapping::Cusp)) << i;
+    }
+}
+
+TEST(Gradient, StopsClampAndHardStops)
+{
+    // The third stop is moved back to 0.6, making a hard stop with the second
+    GradientStop stops[] = {{RED, 0.2}, {WHITE, 0.6}, {BLUE, 0.3}, {RED, 0.8}};
+    Gradient gradient(stops);
+
+    EXPECT_EQ(gradient.sample(-1.0), RED);
+    EXPECT_EQ(gradient.sample(0.2), RED);
+    EXPECT_EQ(gradient.sample(std::nan("")), RED);
+    EXPECT_NEAR(gradient.sample(std::nextafter(0.6, 0.0))[0], WHITE[0], 1e-12);
+    EXPECT_EQ(gradient.sample(0.6), BLUE);
+    EXPECT_EQ(gradient.sample(0.8), RED);
+    EXPECT_EQ(gradient.sample(2.0), RED);
+
+    GradientStop single[] = {{BLUE, 0.5}};
+    EXPECT_EQ(Gradient(single).sample(0.0), BLUE);
+    EXPECT_EQ(Gradient(single).sample(1.0), BLUE);
+}
+
+TEST(Gradient, HueInterpolationMethods)
+{
+    Oklch redLch = oklabToOklch(RED);
+    Oklch blueLch = oklabToOklch(BLUE);
+    double shorter = hueDifference(redLch[2], blueLch[2]);
+    GradientStop stops[] = {{RED, 0.0}, {BLUE, 1.0}};
+
+    auto midpointHue = [&](HueInterpolation method)
+    {
+        return hueAt(Gradient(stops, GradientSpace::Oklch, method), 0.5);
+    };
+    double longer = shorter > 0 ? shorter - 360 : shorter + 360;
+    double increasing = shorter > 0 ? shorter : longer;
+    double decreasing = shorter > 0 ? longer : shorter;
+
+    EXPECT_NEAR(hueDifference(redLch[2], midpointHue(HueInterpolation::Shorter)), shorter / 2, 1e-9);
+    EXPECT_NEAR(hueDifference(redLch[2], midpointHue(HueInterpolation::Longer)), hueDifference(0, longer / 2), 1e-9);
+    EXPECT_NEAR(hueDifference(redLch[2], midpointHue(HueInterpolation::Increasing)), hueDifference(0, increasing / 2), 1e-9);
+    EXPECT_NEAR(hueDifference(redLch[2], midpointHue(HueInterpolation::Decreasing)), hueDifference(0, decreasing / 2), 1e-9);
+
+    // Lightness and chroma are interpolated linearly whatever the hue path
+    Oklch midpoint = oklabToOklch(Gradient(stops, GradientSpace::Oklch).sample(0.5));
+    EXPECT_NEAR(midpoint[0], (redLch[0] + blueLch[0]) / 2, 1e-12);
+    EXPECT_NEAR(midpoint[1], (redLch[1] + blueLch[1]) / 2, 1e-12);
+}
+
+TEST(Gradient, AchromaticStopsTakeTheOtherHue)
+{
+    GradientStop stops[] = {{WHITE, 0.0}, {BLUE, 1.0}};
+    Gradient gradient(stops, GradientSpace::Oklch);
+    double blueHue = oklabToOklch(BLUE)[2];
+    for (double position : {0.25, 0.5, 0.75})
+    {
+        EXPECT_NEAR(hueAt(gradient, position), blueHue, 1e-9) << position;
+    }
+}
+
+TEST(Gradient, LinearImageSamplesPixelCenters)
+{
+    GradientStop stops[] = {{RED, 0.0}, {WHITE, 0.5}, {BLUE, 1.0}};
+    Gradient gradient(stops, GradientSpace::Oklch);
+
+    const std::size_t width = 300;
+    const std::size_t height = 7;
+    const std::size_t stride = 320;
+    std::vector<RGB> pixels(stride * height);
+    GradientLine line{0.0, 0.0, 300.0, 7.0};
+    gradient.fillLinear(ImageView<RGB>(pixels.data(), width, height, stride), line);
+
+    const double lengthSquared = 300.0 * 300.0 + 7.0 * 7.0;
+    for (std::size_t y = 0; y < height; ++y)
+    {
+        for (std::size_t x = 0; x < width; ++x)
+        {
+            double position = ((x + 0.5 - line.startX) * 300.0 + (y + 0.5 - line.startY) * 7.0) / lengthSquared;
+            EXPECT_EQ(pixels[y * stride + x], oklabToRgb(gradient.sample(position))) << x << ", " << y;
+        }
+    }
+}
+
+TEST(Gradient, RejectsInvalidArguments)
+{
+    EXPECT_THROW(Gradient(Span<const GradientStop>()), std::invalid_argument);
+
+    GradientStop stops[] = {{RED, 0.0}, {BLUE, 1.0}};
+    Gradient gradient(stops);
+    std::vector<double> positions = {0.0, 0.5, 1.0};
+    std::vector<RGB> output(2);
+    EXPECT_THROW(gradient.sample<RGB>(positions, output), std::invalid_argument);
+}
@@ -0,0 +1,181 @@
+#include <atomic>
+#include <chrono>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "ColorConversions.h"
+#include "ImageConversion.h"
+#include "ThreadPool.h"
+
+using namespace oklab;
+
+namespace
+{
+    // Saturated P3 colors over most of the image, so that tiles differ in cost
+    std::vector<P3> makeP3Image(std::size_t width, std::size_t height, std::size_t stride)
+    {
+        std::vector<P3> pixels(stride * height, P3{-1, -1, -1});
+        for (std::size_t y = 0; y < height; ++y)
+        {
+            for (std::size_t x = 0; x < width; ++x)
+            {
+                int r = static_cast<int>((x * 7 + y * 3) % 256);
+                int g = static_cast<int>((x * 13 + y * 29) % 256);
+                int b = static_cast<int>((x * y) % 256);
+                pixels[y * stride + x] = x % 3 == 0 ? P3{r, g, b} : P3{255, g / 4, b / 8};
+            }
+        }
+        return pixels;
+    }
+}
+
+TEST(ThreadPool, RunsEveryIndexOnce)
+{
+    for (unsigned threadCount : {1u, 3u, 8u})
+    {
+        ThreadPool pool(threadCount);
+        EXPECT_EQ(pool.threadCount(), threadCount);
+
+        for (std::size_t count : {std::size_t{1}, std::size_t{5}, std::size_t{10007}})
+        {
+            std::vector<std::atomic<int>> runs(count);
+            pool.parallelFor(count, [&](std::size_t index) { runs[index].fetch_add(1); });
+            for (std::size_t index = 0; index < count; ++index)
+            {
+                ASSERT_EQ(runs[index].load(), 1) << threadCount << " threads, index " << index << " of " << count;
+            }
+        }
+    }
+
+    ThreadPool pool(2);
+    EXPECT_THROW(pool.parallelFor(std::size_t{1} << 32, [](std::size_t) {}), std::invalid_argument);
+}
+
+TEST(ThreadPool, StealsFromSlowRanges)
+{
+    // The first quarter of the indices, the range of the calling thread, is much slower
+    ThreadPool pool(4);
+    std::vector<std::thread::id> runners(40);
+    pool.parallelFor(runners.size(), [&](std::size_t index)
+    {
+        if (index < 10)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        runners[index] = std::this_thread::get_id();
+    });
+
+    std::set<std::thread::id> slowRunners(runners.begin(), runners.begin() + 10);
+    EXPECT_GT(slowRunners.size(), 1u);
+}
+
+TEST(ImageConversion, P3ToRgbMatchesSingleColorConversions)
+{
+    // Neither dimension a multiple of the tile size, rows padded
+    const std::size_t width = 1000;
+    const std::size_t height = 37;
+    const std::size_t stride = 1003;
+    std::vector<P3> input = makeP3Image(width, height, stride);
+    std::vector<RGB> output(stride * height, RGB{-1, -1, -1});
+
+    ThreadPool pool(4);
+    ImageConversionOptions options;
+    options.pool = &pool;
+    options.mapping = GamutMapping::Css4;
+    ASSERT_TRUE(p3ToRgb(ImageView<const P3>(input.data(), width, height, stride), ImageView<RGB>(output.data(), width, height, stride), options));
+
+    for (std::size_t y = 0; y < height; ++y)
+    {
+        for (std::size_t x = 0; x < stride; ++x)
+        {
+            std::size_t i = y * stride + x;
+            RGB expected = x < width ? p3ToRgb(input[i], GamutMapping::Css4) : RGB{-1, -1, -1};
+            ASSERT_EQ(output[i], expected) << x << ", " << y;
+        }
+    }
+}
+
+TEST(ImageConversion, RgbToP3OnTheSharedPool)
+{
+    const std::size_t width = 300;
+    const std::size_t height = 20;
+    std::vector<RGB> input;
+    for (const P3 &color : makeP3Image(width, height, width))
+    {
+        input.push_back(RGB{color[0], color[1], color[2]});
+    }
+    std::vector<P3> output(input.size());
+
+    ASSERT_TRUE(rgbToP3(ImageView<const RGB>(input.data(), width, height), ImageView<P3>(output.data(), width, height)));
+    for (std::size_t i = 0; i < input.size(); ++i)
+    {
+        ASSERT_EQ(output[i], rgbToP3(input[i])) << i;
+    }
+}
+
+TEST(ImageConversion, EmptyImages)
+{
+    std::vector<P3> input;
+    std::vector<RGB> output;
+    EXPECT_TRUE(p3ToRgb(ImageView<const P3>(input.data(), 0, 0), ImageView<RGB>(output.data(), 0, 0)));
+    EXPECT_TRUE(p3ToRgb(ImageView<const P3>(input.data(), 100, 0), ImageView<RGB>(output.data(), 100, 0)));
+}
+
+TEST(ImageConversion, RejectsMismatchedImages)
+{
+    std::vector<P3> input(12);
+    std::vector<RGB> output(12);
+    EXPECT_THROW(p3ToRgb(ImageView<const P3>(input.data(), 4, 3), ImageView<RGB>(output.data(), 3, 4)), std::invalid_argument);
+    EXPECT_THROW(p3ToRgb(ImageView<const P3>(input.data(), 4, 3, 2), ImageView<RGB>(output.data(), 4, 3)), std::invalid_argument);
+    EXPECT_THROW(rgbToP3(ImageView<const RGB>(output.data(), 4, 3), ImageView<P3>(input.data(), 4, 2)), std::invalid_argument);
+}
+
+TEST(ImageConversion, CancelledBeforeStarting)
+{
+    std::vector<P3> input = makeP3Image(64, 64, 64);
+    std::vector<RGB> output(input.size(), RGB{-1, -1, -1});
+
+    CancellationToken cancellation;
+    cancellation.cancel();
+    ImageConversionOptions options;
+    options.cancellation = &cancellation;
+    EXPECT_FALSE(p3ToRgb(ImageView<const P3>(input.data(), 64, 64), ImageView<RGB>(output.data(), 64, 64), options));
+
+    for (const RGB &color : output)
+    {
+        ASSERT_EQ(color, (RGB{-1, -1, -1}));
+    }
+}
+
+TEST(ImageConversion, CancelledWhileConverting)
+{
+    const std::size_t width = 2048;
+    const std::size_t height = 512;
+    std::vector<P3> input = makeP3Image(width, height, width);
+    std::vector<RGB> output(input.size(), RGB{-1, -1, -1});
+
+    ThreadPool pool(2);
+    CancellationToken cancellation;
+    ImageConversionOptions options;
+    options.pool = &pool;
+    options.cancellation = &cancellation;
+
+    std::thread canceller([&]()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        cancellation.cancel();
+    });
+    bool isComplete = p3ToRgb(ImageView<const P3>(input.data(), width, height), ImageView<RGB>(output.data(), width, height), options);
+    canceller.join();
+
+    // Tiles are converted whole or not at all; the conversion may also end before the cancellation
+    std::size_t unconverted = 0;
+    for (const RGB &color : output)
+    {
+        unconverted += color == RGB{-1, -1, -1};
+    }
+    EXPECT_EQ(isComplete, unconverted == 0);
+    EXPECT_EQ(unconverted % IMAGE_TILE_WIDTH, 0u);
+}
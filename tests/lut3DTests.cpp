@@ -0,0 +1,134 @@
+#include <stdexcept>
+#include <vector>
+#include "gtest/gtest.h"
+#include "Lut3D.h"
+#include "ColorConversions.h"
+#include "../src/simd/SimdKernels.h"
+
+using namespace oklab;
+
+namespace
+{
+    const LutInterpolation INTERPOLATIONS[] = {LutInterpolation::Trilinear, LutInterpolation::Tetrahedral};
+
+    std::vector<GammaP3> sampleColors()
+    {
+        std::vector<GammaP3> colors;
+        const int steps = 23;
+        for (int r = 0; r <= steps; ++r)
+        {
+            for (int g = 0; g <= steps; ++g)
+            {
+                for (int b = 0; b <= steps; ++b)
+                {
+                    colors.push_back(GammaP3{r / double(steps), g / double(steps), b / double(steps)});
+                }
+            }
+        }
+        // Outside [0, 1]: clamped to the cube
+        colors.push_back(GammaP3{-0.5, 0.25, 1.5});
+        return colors;
+    }
+}
+
+TEST(Lut3D, NodesMatchExactConversion)
+{
+    P3ToRgbLut lut(17);
+
+    for (int x = 0; x < 17; ++x)
+    {
+        for (int y = 0; y < 17; y += 4)
+        {
+            for (int z = 0; z < 17; z += 2)
+            {
+                GammaP3 p3{x / 16.0, y / 16.0, z / 16.0};
+                RGB exact = p3ToRgb(P3{x * 255 / 16, y * 255 / 16, z * 255 / 16});
+                for (LutInterpolation interpolation : INTERPOLATIONS)
+                {
+                    GammaSRGB rgb = lut.lookup(p3, interpolation);
+                    if (x * 255 % 16 == 0 && y * 255 % 16 == 0 && z * 255 % 16 == 0)
+                    {
+                        for (int c = 0; c < 3; ++c)
+                        {
+                            EXPECT_NEAR(rgb[c] * 255.0, exact[c], 0.5 + 1e-4);
+                        }
+                    }
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        EXPECT_GE(rgb[c], -1e-6);
+                        EXPECT_LE(rgb[c], 1 + 1e-6);
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST(Lut3D, ErrorShrinksWithSize)
+{
+    for (LutInterpolation interpolation : INTERPOLATIONS)
+    {
+        LutError small = P3ToRgbLut(9).measureError(24, interpolation);
+        LutError large = P3ToRgbLut(33).measureError(24, interpolation);
+        EXPECT_LT(large.meanDeltaE, small.meanDeltaE);
+        EXPECT_LT(large.maxDeltaE, small.maxDeltaE);
+        EXPECT_LE(large.meanDeltaE, large.maxDeltaE);
+        // Below the CSS4 "just noticeable" difference
+        EXPECT_LT(large.maxDeltaE, 0.02);
+    }
+
+    // In-gamut everywhere: smooth, so far more accurate
+    LutError inGamut = RgbToP3Lut(33).measureError(24, LutInterpolation::Tetrahedral);
+    EXPECT_LT(inGamut.maxDeltaE, 1e-3);
+}
+
+TEST(Lut3D, KernelsMatchScalarLookup)
+{
+    std::vector<const KernelTable *> tables = {&SCALAR_KERNELS};
+#ifdef OKLAB_X86_KERNELS
+    tables.insert(tables.end(), {&SSE42_KERNELS, &AVX2_KERNELS, &AVX512_KERNELS});
+#endif
+
+    const KernelTable &defaultKernels = kernels();
+    P3ToRgbLut lut(33);
+    std::vector<GammaP3> input = sampleColors();
+    std::vector<GammaSRGB> output(input.size());
+
+    for (const KernelTable *table : tables)
+    {
+        if (!isSupported(*table))
+        {
+            continue;
+        }
+        useKernels(*table);
+
+        for (LutInterpolation interpolation : INTERPOLATIONS)
+        {
+            lut.lookup(input, output, interpolation);
+            for (std::size_t i = 0; i < input.size(); ++i)
+            {
+                ASSERT_EQ(output[i], lut.lookup(input[i], interpolation)) << table->name << " color " << i;
+            }
+        }
+    }
+
+    useKernels(defaultKernels);
+}
+
+TEST(Lut3D, RejectsInvalidArguments)
+{
+    EXPECT_THROW(P3ToRgbLut(0), std::invalid_argument);
+    EXPECT_THROW(RgbToP3Lut(1), std::invalid_argument);
+
+    P3ToRgbLut lut(2);
+    EXPECT_THROW(lut.measureError(0, LutInterpolation::Trilinear), std::invalid_argument);
+
+    std::vector<GammaP3> input = sampleColors();
+    std::vector<GammaSRGB> output(input.size() - 1);
+    EXPECT_THROW(lut.lookup(input, output), std::invalid_argument);
+
+    std::vector<double> planes[3] = {std::vector<double>(4), std::vector<double>(4), std::vector<double>(3)};
+    std::vector<double> result[3] = {std::vector<double>(4), std::vector<double>(4), std::vector<double>(4)};
+    EXPECT_THROW(lut.lookup(Planar<const double>(planes[0], planes[1], planes[2]), Planar<double>(result[0], result[1], result[2])),
+                 std::invalid_argument);
+}
@@ -0,0 +1,94 @@
+#include <cmath>
+#include <random>
+#include "gtest/gtest.h"
+#include "../src/OkLxx.h"
+
+using namespace oklab;
+
+namespace
+{
+    const long double PI_LONG = 3.141592653589793238462643383279502884L;
+
+    double exactHue(double a, double b)
+    {
+        long double hue = std::atan2(static_cast<long double>(b), static_cast<long double>(a)) * 180 / PI_LONG;
+        return static_cast<double>(hue < 0 ? hue + 360 : hue);
+    }
+}
+
+TEST(OklchConversions, OklchToOklabWithinUlpsOfExact)
+{
+    for (double hue = -1080.0; hue <= 1080.0; hue += 0.37)
+    {
+        Oklab oklab = oklchToOklab(Oklch{0.5, 1.0, hue});
+        long double angle = std::fmod(static_cast<long double>(hue), 360.0L) * PI_LONG / 180;
+        ASSERT_NEAR(oklab[1], static_cast<double>(std::cos(angle)), 2.3e-16) << hue;
+        ASSERT_NEAR(oklab[2], static_cast<double>(std::sin(angle)), 2.3e-16) << hue;
+    }
+
+    // Quarter turns are reduced exactly
+    EXPECT_EQ(oklchToOklab(Oklch{0.5, 0.2, 90.0}), (Oklab{0.5, 0.0, 0.2}));
+    EXPECT_EQ(oklchToOklab(Oklch{0.5, 0.2, 180.0}), (Oklab{0.5, -0.2, 0.0}));
+    EXPECT_EQ(oklchToOklab(Oklch{0.5, 0.2, -270.0}), (Oklab{0.5, 0.0, 0.2}));
+    EXPECT_EQ(oklchToOklab(Oklch{0.5, 0.2, NAN}), (Oklab{0.5, 0.0, 0.0}));
+}
+
+TEST(OklchConversions, OklabToOklchWithinTolerance)
+{
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<double> channel(-0.4, 0.4);
+    for (int i = 0; i < 200000; ++i)
+    {
+        double a = channel(generator);
+        double b = channel(generator);
+        Oklch oklch = oklabToOklch(Oklab{0.5, a, b});
+        if (std::isnan(oklch[2]))
+        {
+            continue;
+        }
+        ASSERT_GE(oklch[2], 0.0);
+        ASSERT_LT(oklch[2], 360.0);
+        // One ulp at 360 degrees: the arc tangent, then the wrapping of negative angles
+        double expected = exactHue(a, b);
+        double difference = std::abs(oklch[2] - expected);
+        ASSERT_LE(std::min(difference, 360.0 - difference), 6e-14) << a << " " << b;
+    }
+
+    EXPECT_EQ(oklabToOklch(Oklab{0.5, 0.1, -0.0})[2], 0.0);
+    EXPECT_EQ(oklabToOklch(Oklab{0.5, -0.1, -0.0})[2], 180.0);
+    EXPECT_TRUE(std::isnan(oklabToOklch(Oklab{0.5, 0.0001, -0.0001})[2]));
+    EXPECT_LT(oklabToOklch(Oklabf{0.5f, 0.1f, -1e-30f})[2], 360.0f);
+}
+
+TEST(OklchConversions, PolarFormFollowsTheChromaLine)
+{
+    std::mt19937 generator(11);
+    std::uniform_real_distribution<double> channel(-0.4, 0.4);
+    for (int i = 0; i < 100000; ++i)
+    {
+        Oklab oklab{0.6, channel(generator), channel(generator)};
+        Oklch oklch = oklabToOklch(oklab);
+        PolarOklab polar = oklabToPolar(oklab);
+        if (std::isnan(oklch[2]))
+        {
+            EXPECT_EQ(polar.cosine, 0.0);
+            EXPECT_EQ(polar.sine, 0.0);
+            continue;
+        }
+
+        ASSERT_EQ(polar.chroma, oklch[1]);
+        Oklab back = polar.at(polar.chroma);
+        ASSERT_NEAR(back[1], oklab[1], 1e-16);
+        ASSERT_NEAR(back[2], oklab[2], 1e-16);
+        ASSERT_NEAR(polarToOklch(polar)[2], oklch[2], 1e-12);
+
+        // The same line from the Oklch color
+        Oklab unit = oklchToPolar(oklch).at(1.0);
+        ASSERT_NEAR(unit[1], polar.cosine, 1e-15);
+        ASSERT_NEAR(unit[2], polar.sine, 1e-15);
+    }
+
+    PolarOklab gray = oklchToPolar(Oklch{0.3, 0.1, NAN});
+    EXPECT_EQ(gray.at(0.1), (Oklab{0.3, 0.0, 0.0}));
+    EXPECT_TRUE(std::isnan(polarToOklch(gray)[2]));
+}
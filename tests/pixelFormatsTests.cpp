@@ -0,0 +1,178 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "gtest/gtest.h"
+#include "ColorConversions.h"
+#include "PixelFormats.h"
+#include "../src/ColorConversionsInternal.h"
+#include "../src/HalfFloat.h"
+
+using namespace oklab;
+
+namespace
+{
+    // Colors spread over the cube, with varied alpha
+    std::vector<RGBA8> makeRgba8Pixels()
+    {
+        std::vector<RGBA8> pixels;
+        for (int r = 0; r < 256; r += 15)
+        {
+            for (int g = 0; g < 256; g += 17)
+            {
+                for (int b = 0; b < 256; b += 5)
+                {
+                    pixels.push_back(RGBA8{static_cast<std::uint8_t>(r), static_cast<std::uint8_t>(g), static_cast<std::uint8_t>(b),
+                                           static_cast<std::uint8_t>((r + g + b) % 256)});
+                }
+            }
+        }
+        return pixels;
+    }
+
+    std::uint16_t to16Bit(double value)
+    {
+        return static_cast<std::uint16_t>(std::lround(std::clamp(value, 0.0, 1.0) * 65535));
+    }
+}
+
+TEST(PixelFormats, EightBitFormatsMatchEightBitConversions)
+{
+    std::vector<RGBA8> input = makeRgba8Pixels();
+    std::vector<BGRA8> output(input.size());
+
+    for (GamutMapping mapping : {GamutMapping::Css4, GamutMapping::Cusp, GamutMapping::Clamp})
+    {
+        p3ToRgb(Span<const RGBA8>(input), Span<BGRA8>(output), mapping);
+        for (std::size_t i = 0; i < input.size(); ++i)
+        {
+            RGB expected = p3ToRgb(P3{input[i].r, input[i].g, input[i].b}, mapping);
+            ASSERT_EQ((RGB{output[i].r, output[i].g, output[i].b}), expected) << i;
+            ASSERT_EQ(output[i].a, input[i].a) << i;
+        }
+    }
+
+    std::vector<RGBA8> p3(input.size());
+    rgbToP3(Span<const BGRA8>(output), Span<RGBA8>(p3), GamutMapping::Css4);
+    for (std::size_t i = 0; i < input.size(); ++i)
+    {
+        P3 expected = rgbToP3(RGB{output[i].r, output[i].g, output[i].b}, GamutMapping::Css4);
+        ASSERT_EQ((P3{p3[i].r, p3[i].g, p3[i].b}), expected) << i;
+    }
+}
+
+TEST(PixelFormats, MismatchedSizesThrow)
+{
+    std::vector<RGBA8> input = makeRgba8Pixels();
+    std::vector<BGRA8> output(input.size() - 1);
+
+    EXPECT_THROW(p3ToRgb(Span<const RGBA8>(input), Span<BGRA8>(output)), std::invalid_argument);
+    EXPECT_THROW(rgbToP3(Span<const RGBA8>(input), Span<BGRA8>(output)), std::invalid_argument);
+}
+
+TEST(PixelFormats, SixteenBitFormatsKeepTheirPrecision)
+{
+    std::vector<RGBA16> input;
+    for (int i = 0; i < 4096; ++i)
+    {
+        input.push_back(RGBA16{static_cast<std::uint16_t>(i * 16411 % 65536), static_cast<std::uint16_t>(i * 7919 % 65536),
+                               static_cast<std::uint16_t>(i * 104729 % 65536), static_cast<std::uint16_t>(i)});
+    }
+    std::vector<RGBA16> output(input.size());
+    p3ToRgb(Span<const RGBA16>(input), Span<RGBA16>(output));
+
+    // Against the unquantized conversion: within one 16-bit code, the Precise transfer functions
+    for (std::size_t i = 0; i < input.size(); ++i)
+    {
+        GammaSRGB expected = oklabToGammaSRGB(gammaP3ToOklab(GammaP3{input[i].r / 65535.0, input[i].g / 65535.0, input[i].b / 65535.0}));
+        EXPECT_NEAR(output[i].r, to16Bit(expected[0]), 1) << i;
+        EXPECT_NEAR(output[i].g, to16Bit(expected[1]), 1) << i;
+        EXPECT_NEAR(output[i].b, to16Bit(expected[2]), 1) << i;
+        ASSERT_EQ(output[i].a, input[i].a) << i;
+    }
+}
+
+TEST(PixelFormats, Rgb10A2PacksChannelsAndAlpha)
+{
+    auto pack = [](unsigned r, unsigned g, unsigned b, unsigned a) { return RGB10A2{r | (g << 10) | (b << 20) | (a << 30)}; };
+    std::vector<RGB10A2> input = {pack(1023, 0, 0, 3), pack(0, 1023, 0, 2), pack(512, 512, 512, 1), pack(0, 0, 0, 0)};
+    std::vector<RGBA16> output(input.size());
+    rgbToP3(Span<const RGB10A2>(input), Span<RGBA16>(output));
+
+    for (std::size_t i = 0; i < input.size(); ++i)
+    {
+        unsigned bits = input[i].bits;
+        GammaSRGB gammaRgb{(bits & 0x3ff) / 1023.0, ((bits >> 10) & 0x3ff) / 1023.0, ((bits >> 20) & 0x3ff) / 1023.0};
+        GammaP3 expected = oklabToGammaP3(gammaSRGBToOklab(gammaRgb));
+        EXPECT_NEAR(output[i].r, to16Bit(expected[0]), 1) << i;
+        EXPECT_NEAR(output[i].g, to16Bit(expected[1]), 1) << i;
+        EXPECT_NEAR(output[i].b, to16Bit(expected[2]), 1) << i;
+        EXPECT_EQ(output[i].a, (bits >> 30) * 65535 / 3) << i;
+    }
+
+    // And back: 10-bit codes of the sRGB colors, alpha rescaled to 2 bits
+    std::vector<RGB10A2> roundTrip(input.size());
+    p3ToRgb(Span<const RGBA16>(output), Span<RGB10A2>(roundTrip));
+    for (std::size_t i = 0; i < input.size(); ++i)
+    {
+        for (int shift : {0, 10, 20})
+        {
+            EXPECT_NEAR((roundTrip[i].bits >> shift) & 0x3ff, (input[i].bits >> shift) & 0x3ff, 1) << i;
+        }
+        EXPECT_EQ(roundTrip[i].bits >> 30, input[i].bits >> 30) << i;
+    }
+}
+
+TEST(PixelFormats, PremultipliedAlphaDividesAndMultiplies)
+{
+    std::vector<RGBA16> straight = {RGBA16{60000, 20000, 5000, 65535}, RGBA16{10000, 40000, 30000, 65535}};
+    std::vector<RGBA16> premultiplied = {RGBA16{30000, 10000, 2500, 32768}, RGBA16{1234, 5678, 9012, 0}};
+
+    std::vector<RGBA16> straightOutput(2);
+    std::vector<RGBA16> premultipliedOutput(2);
+    p3ToRgb(Span<const RGBA16>(straight), Span<RGBA16>(straightOutput));
+    p3ToRgb(Span<const RGBA16>(premultiplied), Span<RGBA16>(premultipliedOutput), defaultGamutMapping(), AlphaMode::Premultiplied);
+
+    // Half of the straight conversion of the same color, at half alpha
+    double alpha = 32768 / 65535.0;
+    EXPECT_NEAR(premultipliedOutput[0].r, straightOutput[0].r * alpha, 2);
+    EXPECT_NEAR(premultipliedOutput[0].g, straightOutput[0].g * alpha, 2);
+    EXPECT_NEAR(premultipliedOutput[0].b, straightOutput[0].b * alpha, 2);
+    EXPECT_EQ(premultipliedOutput[0].a, 32768);
+
+    // Zero alpha: black
+    EXPECT_EQ(premultipliedOutput[1].r, 0);
+    EXPECT_EQ(premultipliedOutput[1].g, 0);
+    EXPECT_EQ(premultipliedOutput[1].b, 0);
+    EXPECT_EQ(premultipliedOutput[1].a, 0);
+}
+
+TEST(PixelFormats, HalfFloatsKeepExtendedValues)
+{
+    // Every finite half survives the round trip through float
+    for (std::uint32_t bits = 0; bits < 0x10000; ++bits)
+    {
+        std::uint16_t half = static_cast<std::uint16_t>(bits);
+        if ((half & 0x7c00) == 0x7c00)
+        {
+            continue;
+        }
+        ASSERT_EQ(floatToHalf(halfToFloat(half)), half) << bits;
+    }
+    EXPECT_EQ(floatToHalf(1.0f), 0x3c00);
+    EXPECT_EQ(floatToHalf(65520.0f), 0x7c00);
+    EXPECT_EQ(floatToHalf(1.0f + 1.0f / 4096), 0x3c00); // Tie, to even
+
+    // Without mapping, colors outside the sRGB gamut stay outside [0, 1]
+    std::vector<RGBAHalf> input = {RGBAHalf{floatToHalf(1.0f), 0, 0, floatToHalf(0.25f)}};
+    std::vector<RGBAHalf> output(1);
+    p3ToRgb(Span<const RGBAHalf>(input), Span<RGBAHalf>(output), GamutMapping::None);
+    EXPECT_GT(halfToFloat(output[0].r), 1.0f);
+    EXPECT_LT(halfToFloat(output[0].g), 0.0f);
+    EXPECT_EQ(halfToFloat(output[0].a), 0.25f);
+
+    p3ToRgb(Span<const RGBAHalf>(input), Span<RGBAHalf>(output), GamutMapping::Css4);
+    EXPECT_LE(halfToFloat(output[0].r), 1.0f);
+    EXPECT_GE(halfToFloat(output[0].g), 0.0f);
+}
@@ -0,0 +1,193 @@
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "ColorConversions.h"
+#include "PnmImage.h"
+
+using namespace oklab;
+
+namespace
+{
+    std::string imagePath(const std::string &name)
+    {
+        return testing::TempDir() + "oklab_" + name;
+    }
+
+    void writeFile(const std::string &path, const std::string &contents)
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << contents;
+    }
+
+    // 8-bit P3 colors covering the cube coarsely, as binary PPM samples
+    std::string p3Samples(std::size_t width, std::size_t height)
+    {
+        std::string samples;
+        for (std::size_t i = 0; i < width * height; ++i)
+        {
+            samples += static_cast<char>(i * 37 % 256);
+            samples += static_cast<char>(i * 101 % 256);
+            samples += static_cast<char>(255 - i * 13 % 256);
+        }
+        return samples;
+    }
+}
+
+TEST(PnmImage, OpensPpmWithComments)
+{
+    std::string path = imagePath("comments.ppm");
+    writeFile(path, "P6\n# written by a test\n3 2\n# maximum value\n255\n" + p3Samples(3, 2));
+
+    std::unique_ptr<PnmImage> image = PnmImage::open(path);
+    ASSERT_NE(image, nullptr);
+    EXPECT_EQ(image->format(), PnmFormat::Ppm);
+    EXPECT_EQ(image->width(), 3u);
+    EXPECT_EQ(image->height(), 2u);
+    EXPECT_EQ(image->maxValue(), 255u);
+    EXPECT_FALSE(image->hasAlpha());
+    EXPECT_FALSE(image->isWritable());
+    EXPECT_EQ(image->rowSize(), 9u);
+
+    std::string samples = p3Samples(3, 2);
+    EXPECT_EQ(std::string(reinterpret_cast<const char *>(image->row(1)), 9), samples.substr(9));
+
+    std::remove(path.c_str());
+}
+
+TEST(PnmImage, RejectsInvalidFiles)
+{
+    std::string path = imagePath("invalid.pnm");
+    for (const std::string &contents : {std::string("P5\n1 1\n255\nx"),                                           // grayscale
+                                        std::string("P6\n2 2\n255\n") + p3Samples(2, 1),                          // truncated
+                                        std::string("P6\n1 1\n70000\n") + p3Samples(1, 2),                        // maxval
+                                        std::string("P7\nWIDTH 1\nHEIGHT 1\nDEPTH 1\nMAXVAL 255\nTUPLTYPE GRAYSCALE\nENDHDR\nx"),
+                                        std::string("P7\nWIDTH 1\nHEIGHT 1\nDEPTH 3\nMAXVAL 255\n"),                // no ENDHDR
+                                        std::string()})
+    {
+        writeFile(path, contents);
+        EXPECT_EQ(PnmImage::open(path), nullptr) << contents.substr(0, 40);
+    }
+    EXPECT_EQ(PnmImage::open(imagePath("missing.ppm")), nullptr);
+    EXPECT_EQ(PnmImage::create(path, PnmFormat::Ppm, 1, 1, 255, true), nullptr);
+
+    std::remove(path.c_str());
+}
+
+TEST(PnmImage, CreatedPamReopensWith16BitSamples)
+{
+    std::string path = imagePath("created.pam");
+    {
+        std::unique_ptr<PnmImage> image = PnmImage::create(path, PnmFormat::Pam, 2, 3, 65535, true);
+        ASSERT_NE(image, nullptr);
+        EXPECT_TRUE(image->isWritable());
+        EXPECT_EQ(image->rowSize(), 16u);
+        for (std::size_t y = 0; y < 3; ++y)
+        {
+            for (std::size_t i = 0; i < image->rowSize(); ++i)
+            {
+                image->row(y)[i] = static_cast<unsigned char>(y * 16 + i);
+            }
+        }
+        EXPECT_TRUE(image->flush());
+    }
+
+    std::unique_ptr<PnmImage> image = PnmImage::open(path);
+    ASSERT_NE(image, nullptr);
+    EXPECT_EQ(image->format(), PnmFormat::Pam);
+    EXPECT_EQ(image->width(), 2u);
+    EXPECT_EQ(image->height(), 3u);
+    EXPECT_EQ(image->maxValue(), 65535u);
+    EXPECT_TRUE(image->hasAlpha());
+    EXPECT_EQ(image->sampleSize(), 2u);
+    EXPECT_EQ(image->row(2)[15], 47);
+
+    std::remove(path.c_str());
+}
+
+TEST(PnmImage, P3ToRgbMatchesSingleColorConversions)
+{
+    const std::size_t width = 300;
+    const std::size_t height = 20;
+    std::string inputPath = imagePath("p3.ppm");
+    std::string outputPath = imagePath("rgb.pam");
+    std::string samples = p3Samples(width, height);
+    writeFile(inputPath, "P6 300 20 255\n" + samples);
+
+    std::unique_ptr<PnmImage> input = PnmImage::open(inputPath);
+    ASSERT_NE(input, nullptr);
+    std::unique_ptr<PnmImage> output = PnmImage::create(outputPath, PnmFormat::Pam, width, height, 255, true);
+    ASSERT_NE(output, nullptr);
+    ASSERT_TRUE(p3ToRgb(*input, *output));
+
+    for (std::size_t y = 0; y < height; ++y)
+    {
+        for (std::size_t x = 0; x < width; ++x)
+        {
+            const unsigned char *in = input->row(y) + 3 * x;
+            const unsigned char *out = output->row(y) + 4 * x;
+            RGB expected = p3ToRgb(P3{in[0], in[1], in[2]});
+            ASSERT_EQ((RGB{out[0], out[1], out[2]}), expected) << x << ", " << y;
+            ASSERT_EQ(out[3], 255) << "opaque alpha";
+        }
+    }
+
+    std::remove(inputPath.c_str());
+    std::remove(outputPath.c_str());
+}
+
+TEST(PnmImage, RejectsMismatchedOrReadOnlyOutputs)
+{
+    std::string inputPath = imagePath("small.ppm");
+    std::string outputPath = imagePath("smaller.ppm");
+    writeFile(inputPath, "P6 4 2 255\n" + p3Samples(4, 2));
+
+    std::unique_ptr<PnmImage> input = PnmImage::open(inputPath);
+    ASSERT_NE(input, nullptr);
+    std::unique_ptr<PnmImage> output = PnmImage::create(outputPath, PnmFormat::Ppm, 4, 1, 255, false);
+    ASSERT_NE(output, nullptr);
+    EXPECT_THROW(p3ToRgb(*input, *output), std::invalid_argument);
+
+    std::unique_ptr<PnmImage> readOnly = PnmImage::open(inputPath);
+    ASSERT_NE(readOnly, nullptr);
+    EXPECT_THROW(rgbToP3(*input, *readOnly), std::invalid_argument);
+
+    std::remove(inputPath.c_str());
+    std::remove(outputPath.c_str());
+}
+
+TEST(PnmImage, RescalesSamplesAndAlpha)
+{
+    // 16-bit RGB with alpha to 8-bit P3 with alpha
+    std::string inputPath = imagePath("rgb16.pam");
+    std::string outputPath = imagePath("p3.pam");
+    const unsigned char samples[] = {0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x80, 0x00,
+                                     0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0xff, 0xff};
+    writeFile(inputPath, "P7\nWIDTH 2\nHEIGHT 1\nDEPTH 4\nMAXVAL 65535\nTUPLTYPE RGB_ALPHA\nENDHDR\n" +
+                             std::string(reinterpret_cast<const char *>(samples), sizeof(samples)));
+
+    std::unique_ptr<PnmImage> input = PnmImage::open(inputPath);
+    ASSERT_NE(input, nullptr);
+    std::unique_ptr<PnmImage> output = PnmImage::create(outputPath, PnmFormat::Pam, 2, 1, 255, true);
+    ASSERT_NE(output, nullptr);
+    ASSERT_TRUE(rgbToP3(*input, *output));
+
+    // Converted at 16 bits, then rescaled to 8
+    auto convert16 = [](const RGB &rgb)
+    {
+        P3 p3 = oklabToP3(rgbToOklab(rgb, BitDepth::Sixteen), BitDepth::Sixteen);
+        return P3{(p3[0] * 255 + 32767) / 65535, (p3[1] * 255 + 32767) / 65535, (p3[2] * 255 + 32767) / 65535};
+    };
+    const unsigned char *out = output->row(0);
+    P3 red = convert16(RGB{65535, 0, 0});
+    P3 gray = convert16(RGB{0x8080, 0x8080, 0x8080});
+    EXPECT_EQ((P3{out[0], out[1], out[2]}), red);
+    EXPECT_EQ(out[3], 128);
+    EXPECT_EQ((P3{out[4], out[5], out[6]}), gray);
+    EXPECT_EQ(out[7], 255);
+
+    std::remove(inputPath.c_str());
+    std::remove(outputPath.c_str());
+}
@@ -0,0 +1,200 @@
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "ColorConversions.h"
+#include "ScanlineStream.h"
+
+using namespace oklab;
+
+namespace
+{
+    // Saturated P3 colors, mostly out of the sRGB gamut
+    std::vector<P3> makeP3Rows(std::size_t width, std::size_t height)
+    {
+        std::vector<P3> pixels;
+        for (std::size_t y = 0; y < height; ++y)
+        {
+            for (std::size_t x = 0; x < width; ++x)
+            {
+                pixels.push_back(P3{static_cast<int>((x * 7 + y) % 256), 255, static_cast<int>((x * y) % 256)});
+            }
+        }
+        return pixels;
+    }
+}
+
+TEST(ScanlineStream, PullsRowsPushedFromAnotherThread)
+{
+    const std::size_t width = 301;
+    const std::size_t height = 97;
+    std::vector<P3> input = makeP3Rows(width, height);
+
+    // A bound of a few strips, for push to wait for pull
+    ScanlineStreamOptions options;
+    options.mapping = GamutMapping::Css4;
+    options.maxWorkingMemory = 5 * 8 * width * (sizeof(P3) + sizeof(RGB));
+    options.stripHeight = 8;
+    P3ToRgbStream stream(width, options);
+    EXPECT_EQ(stream.stripHeight(), 8u);
+    EXPECT_EQ(stream.stripCount(), 5u);
+    EXPECT_LE(stream.workingMemory(), options.maxWorkingMemory);
+
+    // Strips of uneven heights on both sides
+    std::thread decoder([&]()
+    {
+        for (std::size_t y = 0; y < height;)
+        {
+            std::size_t rows = std::min<std::size_t>(y % 5 + 1, height - y);
+            stream.push(Span<const P3>(input.data() + y * width, rows * width));
+            y += rows;
+        }
+        stream.finish();
+    });
+
+    std::vector<RGB> output(width * height);
+    std::vector<RGB> rows(3 * width);
+    std::size_t y = 0;
+    while (std::size_t count = stream.pull(rows))
+    {
+        ASSERT_LE(y + count, height);
+        std::copy_n(rows.begin(), count * width, output.begin() + y * width);
+        y += count;
+    }
+    decoder.join();
+
+    ASSERT_EQ(y, height);
+    for (std::size_t i = 0; i < input.size(); ++i)
+    {
+        ASSERT_EQ(output[i], p3ToRgb(input[i], GamutMapping::Css4)) << i;
+    }
+}
+
+TEST(ScanlineStream, PassesRowsToTheSinkInOrder)
+{
+    const std::size_t width = 64;
+    const std::size_t height = 50;
+    std::vector<P3> input = makeP3Rows(width, height);
+
+    // Planar input, as decoded from planar formats
+    std::vector<double> l, a, b;
+    std::vector<Oklab> oklab;
+    for (const P3 &color : input)
+    {
+        oklab.push_back(p3ToOklab(color));
+        l.push_back(oklab.back()[0]);
+        a.push_back(oklab.back()[1]);
+        b.push_back(oklab.back()[2]);
+    }
+
+    std::vector<P3> output;
+    std::size_t nextRow = 0;
+    OklabToP3Stream stream(width, [&](std::size_t firstRow, Span<const P3> rows)
+    {
+        EXPECT_EQ(firstRow, nextRow);
+        EXPECT_EQ(rows.size() % width, 0u);
+        nextRow += rows.size() / width;
+        output.insert(output.end(), rows.begin(), rows.end());
+    });
+
+    // One thread pushes everything, whatever the number of strips
+    for (std::size_t y = 0; y < height; y += 10)
+    {
+        std::size_t begin = y * width;
+        std::size_t size = 10 * width;
+        stream.push(Planar<const double>(Span<const double>(l.data() + begin, size), Span<const double>(a.data() + begin, size),
+                                         Span<const double>(b.data() + begin, size)));
+    }
+    stream.finish();
+
+    ASSERT_EQ(output.size(), input.size());
+    for (std::size_t i = 0; i < input.size(); ++i)
+    {
+        ASSERT_EQ(output[i], oklabToP3(oklab[i])) << i;
+    }
+}
+
+TEST(ScanlineStream, PullsPlanarRows)
+{
+    const std::size_t width = 10;
+    std::vector<RGB> input;
+    for (const P3 &color : makeP3Rows(width, 3))
+    {
+        input.push_back(RGB{color[0], color[1], color[2]});
+    }
+
+    RgbToP3Stream stream(width);
+    std::thread decoder([&]()
+    {
+        stream.push(input);
+        stream.finish();
+    });
+
+    std::vector<int> c0(input.size()), c1(input.size()), c2(input.size());
+    std::size_t rows = 0;
+    while (rows < 3)
+    {
+        std::size_t offset = rows * width;
+        std::size_t size = input.size() - offset;
+        std::size_t count = stream.pull(Planar<int>(Span<int>(c0.data() + offset, size), Span<int>(c1.data() + offset, size),
+                                                    Span<int>(c2.data() + offset, size)));
+        ASSERT_GT(count, 0u);
+        rows += count;
+    }
+    EXPECT_EQ(stream.pull(Span<P3>()), 0u);
+    decoder.join();
+
+    for (std::size_t i = 0; i < input.size(); ++i)
+    {
+        ASSERT_EQ((P3{c0[i], c1[i], c2[i]}), rgbToP3(input[i])) << i;
+    }
+}
+
+TEST(ScanlineStream, LowersTheStripHeightToTheMemoryBound)
+{
+    ScanlineStreamOptions options;
+    options.maxWorkingMemory = 1000 * (sizeof(P3) + sizeof(RGB)) * 5;
+    P3ToRgbStream stream(1000, options);
+    EXPECT_EQ(stream.stripHeight(), 2u);
+    EXPECT_EQ(stream.stripCount(), 2u);
+
+    // Two strips of a single row when even that is above the bound
+    options.maxWorkingMemory = 1;
+    P3ToRgbStream tiny(1000, options);
+    EXPECT_EQ(tiny.stripHeight(), 1u);
+    EXPECT_EQ(tiny.stripCount(), 2u);
+}
+
+TEST(ScanlineStream, EmptyImages)
+{
+    P3ToRgbStream stream(16);
+    stream.finish();
+    std::vector<RGB> rows(16);
+    EXPECT_EQ(stream.pull(rows), 0u);
+
+    std::size_t sinkCalls = 0;
+    P3ToRgbStream sinkStream(16, [&](std::size_t, Span<const RGB>) { ++sinkCalls; });
+    sinkStream.finish();
+    EXPECT_EQ(sinkCalls, 0u);
+}
+
+TEST(ScanlineStream, RejectsPartialRows)
+{
+    EXPECT_THROW(P3ToRgbStream(0), std::invalid_argument);
+    ScanlineStreamOptions options;
+    options.stripHeight = 0;
+    EXPECT_THROW(P3ToRgbStream(16, options), std::invalid_argument);
+
+    RgbToP3Stream stream(10);
+    std::vector<RGB> partial(15);
+    EXPECT_THROW(stream.push(partial), std::invalid_argument);
+    std::vector<int> r(10), g(10), b(9);
+    EXPECT_THROW(stream.push(Planar<const int>(r, g, b)), std::invalid_argument);
+    std::vector<P3> output(15);
+    EXPECT_THROW(stream.pull(output), std::invalid_argument);
+
+    // Nothing was pushed
+    stream.finish();
+    output.resize(10);
+    EXPECT_EQ(stream.pull(output), 0u);
+}
@@ -0,0 +1,186 @@
+#include <cmath>
+#include <vector>
+#include "gtest/gtest.h"
+#include "ColorConversions.h"
+#include "ColorBatchConversions.h"
+#include "ColorManipulations.h"
+#include "../src/simd/SimdKernels.h"
+
+using namespace oklab;
+
+namespace
+{
+    std::vector<const KernelTable *> supportedKernels()
+    {
+        std::vector<const KernelTable *> tables = {&SCALAR_KERNELS};
+#ifdef OKLAB_X86_KERNELS
+        tables.push_back(&SSE42_KERNELS);
+        tables.push_back(&AVX2_KERNELS);
+        tables.push_back(&AVX512_KERNELS);
+#endif
+        std::vector<const KernelTable *> supported;
+        for (const KernelTable *table : tables)
+        {
+            if (isSupported(*table))
+            {
+                supported.push_back(table);
+            }
+        }
+        return supported;
+    }
+
+    // Restores the kernels selected at load time when a test ends.
+    class SimdKernels : public ::testing::Test
+    {
+    protected:
+        void TearDown() override { useKernels(defaultKernels); }
+
+        const KernelTable &defaultKernels = kernels();
+    };
+}
+
+TEST_F(SimdKernels, ScalarKernelsAlwaysSupported)
+{
+    EXPECT_TRUE(isSupported(SCALAR_KERNELS));
+    EXPECT_TRUE(isSupported(kernels()));
+}
+
+TEST_F(SimdKernels, AllInstructionSetsMatchScalarConversions)
+{
+    // 1000 colors: not a multiple of the block size nor of any vector width.
+    std::vector<P3> p3;
+    for (int r = 0; r < 10; ++r)
+        for (int g = 0; g < 10; ++g)
+            for (int b = 0; b < 10; ++b)
+                p3.push_back(P3{r * 28 + 3, g * 28, 255 - b * 28});
+
+    std::vector<Oklab> expectedOklab;
+    std::vector<RGB> expectedRgb;
+    for (const P3 &color : p3)
+    {
+        expectedOklab.push_back(p3ToOklab(color));
+        expectedRgb.push_back(oklabToRgb(expectedOklab.back()));
+    }
+
+    for (const KernelTable *table : supportedKernels())
+    {
+        useKernels(*table);
+
+        std::vector<Oklab> oklab(p3.size());
+        std::vector<RGB> rgb(p3.size());
+        p3ToOklab(p3, oklab);
+        oklabToRgb(oklab, rgb);
+
+        for (size_t i = 0; i < p3.size(); ++i)
+        {
+            EXPECT_EQ(oklab[i], expectedOklab[i]) << table->name << " at index " << i;
+            EXPECT_EQ(rgb[i], expectedRgb[i]) << table->name << " at index " << i;
+        }
+    }
+}
+
+TEST_F(SimdKernels, Css4SearchesMatchTheBisectionOnEveryInstructionSet)
+{
+    // Out-of-gamut colors of all lightnesses and hues, in the sRGB gamut; compared before
+    // 8-bit encoding
+    std::vector<Oklab> oklab;
+    std::vector<GammaSRGB> expected;
+    Css4Searches searches;
+    for (int l = 1; l < 20 && searches.count < BATCH_BLOCK_SIZE; ++l)
+    {
+        for (int h = 0; h < 360 && searches.count < BATCH_BLOCK_SIZE; h += 7)
+        {
+            Oklab color = oklchToOklab(Oklch{l / 20.0, 0.1 + 0.02 * (h % 11), static_cast<double>(h)});
+            RGB unused;
+            PolarOklab polar;
+            LinearSRGB clippedLinearColor;
+            if (css4::mapWithoutSearch(color, unused, polar, clippedLinearColor))
+            {
+                continue;
+            }
+
+            std::size_t search = searches.count++;
+            searches.lightness[search] = polar.lightness;
+            searches.cosine[search] = polar.cosine;
+            searches.sine[search] = polar.sine;
+            searches.chroma[search] = polar.chroma;
+            for (int c = 0; c < 3; ++c)
+            {
+                searches.clipped.channels[c][search] = clippedLinearColor[c];
+            }
+            oklab.push_back(color);
+            expected.push_back(performCssGamutMapping<GammaSRGB, LinearSRGB>(color));
+        }
+    }
+    ASSERT_EQ(searches.count, BATCH_BLOCK_SIZE);
+
+    for (const KernelTable *table : supportedKernels())
+    {
+        Css4Searches tableSearches = searches;
+        table->css4Search(LMS_TO_RGB, RGB_TO_LMS, tableSearches);
+
+        for (std::size_t i = 0; i < tableSearches.count; ++i)
+        {
+            GammaSRGB gamma = linearColorToColor<LinearSRGB, GammaSRGB>(
+                LinearSRGB{tableSearches.clipped.channels[0][i], tableSearches.clipped.channels[1][i], tableSearches.clipped.channels[2][i]});
+            for (int c = 0; c < 3; ++c)
+            {
+                ASSERT_EQ(gamma[c], expected[i][c]) << table->name << " at index " << i;
+            }
+            EXPECT_GT(tableSearches.iterations[i], 0) << table->name << " at index " << i;
+        }
+    }
+}
+
+TEST_F(SimdKernels, OklabAdjustmentsMatchOnEveryInstructionSet)
+{
+    // Lightening clamps at 1, so lightness up to 1.5 goes through both branches
+    std::vector<Oklab> input;
+    for (int i = 0; i < 1000; ++i)
+    {
+        input.push_back(Oklab{i * 0.0015, std::sin(i * 0.1) * 0.3, std::cos(i * 0.07) * 0.3});
+    }
+
+    for (OklchAdjustment adjustment : {OklchAdjustment{0.6, 0.3, 70}, OklchAdjustment{-0.2, -0.5, -110}})
+    {
+        useKernels(SCALAR_KERNELS);
+        std::vector<Oklab> expected(input.size());
+        adjustColors<Oklab>(input, expected, adjustment);
+
+        for (const KernelTable *table : supportedKernels())
+        {
+            useKernels(*table);
+            std::vector<Oklab> output(input.size());
+            adjustColors<Oklab>(input, output, adjustment);
+            for (std::size_t i = 0; i < input.size(); ++i)
+            {
+                ASSERT_EQ(output[i], expected[i]) << table->name << " at index " << i;
+            }
+        }
+    }
+}
+
+TEST_F(SimdKernels, OklchToOklabMatchesOnEveryInstructionSet)
+{
+    // Hues of several turns, both signs, and powerless (NaN) hues
+    BlockPlanes input;
+    for (std::size_t i = 0; i < BATCH_BLOCK_SIZE; ++i)
+    {
+        input.channels[0][i] = i / 256.0;
+        input.channels[1][i] = 0.01 * (i % 37);
+        input.channels[2][i] = i % 41 == 0 ? NAN : (i * 7.77 - 900.0);
+    }
+    const std::size_t count = BATCH_BLOCK_SIZE - 3;
+
+    for (const KernelTable *table : supportedKernels())
+    {
+        BlockPlanes block = input;
+        table->oklchToOklab(block, count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            Oklab expected = oklchToOklab(Oklch{input.channels[0][i], input.channels[1][i], input.channels[2][i]});
+            ASSERT_EQ((Oklab{block.channels[0][i], block.channels[1][i], block.channels[2][i]}), expected)
+                << table->name << " at index " << i;
+        }
+    }
+}
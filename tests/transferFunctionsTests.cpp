@@ -0,0 +1,121 @@
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+#include "gtest/gtest.h"
+#include "TransferFunctions.h"
+#include "../src/ColorUtils.h"
+#include "../src/simd/SimdKernels.h"
+
+using namespace oklab;
+
+namespace
+{
+    std::vector<double> sampleValues()
+    {
+        std::vector<double> values;
+        const int steps = 200000;
+        for (int i = -steps; i <= steps; ++i)
+        {
+            values.push_back(static_cast<double>(i) / steps);
+        }
+        return values;
+    }
+
+    struct TierBound
+    {
+        TransferAccuracy accuracy;
+        double decodeError;
+        double encodeError;
+    };
+
+    // Documented maximum errors, see TransferAccuracy.
+    const TierBound TIER_BOUNDS[] = {
+        {TransferAccuracy::Exact, 0.0, 0.0},
+        {TransferAccuracy::Precise, 1e-7, 1e-7},
+        {TransferAccuracy::EightBit, 6.5e-5, 4.5e-5}};
+}
+
+TEST(TransferFunctions, ErrorWithinTierBounds)
+{
+    for (const TierBound &tier : TIER_BOUNDS)
+    {
+        double decodeError = 0.0;
+        double encodeError = 0.0;
+        for (double value : sampleValues())
+        {
+            decodeError = std::max(decodeError, std::abs(gammaToLinear(value, tier.accuracy) - gammaToLinear(value)));
+            encodeError = std::max(encodeError, std::abs(linearToGamma(value, tier.accuracy) - linearToGamma(value)));
+        }
+        EXPECT_LE(decodeError, tier.decodeError) << "tier " << static_cast<int>(tier.accuracy);
+        EXPECT_LE(encodeError, tier.encodeError) << "tier " << static_cast<int>(tier.accuracy);
+    }
+}
+
+TEST(TransferFunctions, CompileTimeTierMatchesRuntimeTier)
+{
+    for (double value : {-0.75, -0.02, 0.0, 0.003, 0.04, 0.2, 0.5, 1.0})
+    {
+        EXPECT_EQ(gammaToLinear<TransferAccuracy::Precise>(value), gammaToLinear(value, TransferAccuracy::Precise));
+        EXPECT_EQ(linearToGamma<TransferAccuracy::EightBit>(value), linearToGamma(value, TransferAccuracy::EightBit));
+        EXPECT_EQ(gammaToLinear<TransferAccuracy::Exact>(value), gammaToLinear(value));
+    }
+}
+
+TEST(TransferFunctions, SignAndSegments)
+{
+    for (const TierBound &tier : TIER_BOUNDS)
+    {
+        EXPECT_EQ(gammaToLinear(0.0, tier.accuracy), 0.0);
+        EXPECT_EQ(linearToGamma(0.0, tier.accuracy), 0.0);
+        EXPECT_EQ(gammaToLinear(-0.5, tier.accuracy), -gammaToLinear(0.5, tier.accuracy));
+        EXPECT_EQ(linearToGamma(-0.5, tier.accuracy), -linearToGamma(0.5, tier.accuracy));
+        // Linear segments only differ by rounding
+        EXPECT_NEAR(gammaToLinear(0.03, tier.accuracy), gammaToLinear(0.03), 1e-17);
+        EXPECT_NEAR(linearToGamma(0.002, tier.accuracy), linearToGamma(0.002), 1e-17);
+    }
+}
+
+TEST(TransferFunctions, BatchMatchesScalarOnEveryKernelTable)
+{
+    std::vector<const KernelTable *> tables = {&SCALAR_KERNELS};
+#ifdef OKLAB_X86_KERNELS
+    tables.insert(tables.end(), {&SSE42_KERNELS, &AVX2_KERNELS, &AVX512_KERNELS});
+#endif
+    const KernelTable &defaultKernels = kernels();
+
+    std::vector<double> input = sampleValues();
+    std::vector<double> decoded(input.size());
+    std::vector<double> encoded(input.size());
+
+    for (const KernelTable *table : tables)
+    {
+        if (!isSupported(*table))
+        {
+            continue;
+        }
+        useKernels(*table);
+
+        for (const TierBound &tier : TIER_BOUNDS)
+        {
+            gammaToLinear(input, decoded, tier.accuracy);
+            linearToGamma(input, encoded, tier.accuracy);
+
+            for (size_t i = 0; i < input.size(); ++i)
+            {
+                ASSERT_EQ(decoded[i], gammaToLinear(input[i], tier.accuracy)) << table->name << " value " << input[i];
+                ASSERT_EQ(encoded[i], linearToGamma(input[i], tier.accuracy)) << table->name << " value " << input[i];
+            }
+        }
+    }
+
+    useKernels(defaultKernels);
+}
+
+TEST(TransferFunctions, BatchRejectsMismatchedSizes)
+{
+    std::vector<double> input(5, 0.5);
+    std::vector<double> output(4);
+
+    EXPECT_THROW(gammaToLinear(input, output, TransferAccuracy::Exact), std::invalid_argument);
+    EXPECT_THROW(linearToGamma(input, output, TransferAccuracy::Precise), std::invalid_argument);
+}
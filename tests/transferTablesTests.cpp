@@ -0,0 +1,121 @@
+#include <cmath>
+#include <random>
+#include "gtest/gtest.h"
+#include "../src/ColorUtils.h"
+#include "../src/TransferTables.h"
+
+using namespace oklab;
+
+namespace
+{
+    int encodeWithPow(double value)
+    {
+        return static_cast<int>(std::round(linearToGamma(value) * 255.0));
+    }
+}
+
+TEST(TransferTables, DecodeMatchesPow)
+{
+    for (int code = 0; code < 256; ++code)
+    {
+        EXPECT_EQ(gammaToLinear8Bit(code), gammaToLinear(code / 255.0)) << "code " << code;
+    }
+}
+
+TEST(TransferTables, DecodeOutOfRangeCodes)
+{
+    for (int code : {-300, -1, 256, 279, 1000})
+    {
+        EXPECT_EQ(gammaToLinear8Bit(code), gammaToLinear(code / 255.0)) << "code " << code;
+    }
+}
+
+TEST(TransferTables, BucketsSpanAtMostOneCode)
+{
+    const TransferTables8Bit &tables = transferTables8Bit();
+    for (int bucket = 0; bucket < ENCODE_TABLE_BUCKETS; ++bucket)
+    {
+        EXPECT_LE(tables.encodeBuckets[bucket + 1] - tables.encodeBuckets[bucket], 1) << "bucket " << bucket;
+    }
+}
+
+TEST(TransferTables, EncodeMatchesPowAroundThresholds)
+{
+    const TransferTables8Bit &tables = transferTables8Bit();
+    for (int code = 1; code < 256; ++code)
+    {
+        double value = tables.encodeThresholds[code];
+        for (int step = 0; step < 4; ++step)
+        {
+            value = std::nextafter(value, 0.0);
+        }
+        for (int step = 0; step < 8; ++step)
+        {
+            EXPECT_EQ(linearToGamma8Bit(value), encodeWithPow(value)) << "value " << value;
+            value = std::nextafter(value, 1.0);
+        }
+    }
+}
+
+TEST(TransferTables, EncodeMatchesPowOnRandomValues)
+{
+    std::mt19937_64 generator(42);
+    std::uniform_real_distribution<double> distribution(0.0, 1.0);
+    for (int i = 0; i < 1000000; ++i)
+    {
+        double value = distribution(generator);
+        ASSERT_EQ(linearToGamma8Bit(value), encodeWithPow(value)) << "value " << value;
+    }
+}
+
+TEST(TransferTables, EncodeOutOfRangeValues)
+{
+    for (double value : {-1.5, -0.25, -0.0, 0.0, 1.0, 1.0000001, 1.25, 3.0})
+    {
+        EXPECT_EQ(linearToGamma8Bit(value), encodeWithPow(value)) << "value " << value;
+    }
+}
+
+TEST(TransferTables, DeepTablesMatchPowAroundThresholds)
+{
+    for (BitDepth depth : {BitDepth::Ten, BitDepth::Twelve, BitDepth::Sixteen})
+    {
+        const TransferTablesNBit &tables = transferTablesNBit(depth);
+        ASSERT_EQ(tables.maxCode, maxCodeValue(depth));
+        auto encodeWithPow = [&](double value) { return static_cast<int>(std::round(linearToGamma(value) * tables.maxCode)); };
+
+        for (int code = 0; code <= tables.maxCode; ++code)
+        {
+            ASSERT_EQ(gammaToLinearNBit(tables, code), gammaToLinear(code / static_cast<double>(tables.maxCode))) << "code " << code;
+        }
+        for (int code = 1; code <= tables.maxCode; ++code)
+        {
+            double threshold = tables.encodeThresholds[code];
+            double below = std::nextafter(threshold, 0.0);
+            ASSERT_EQ(encodeWithPow(threshold), code) << "code " << code;
+            ASSERT_EQ(encodeWithPow(below), code - 1) << "code " << code;
+            ASSERT_EQ(linearToGammaNBit(tables, threshold), code) << "code " << code;
+            ASSERT_EQ(linearToGammaNBit(tables, below), code - 1) << "code " << code;
+        }
+    }
+}
+
+TEST(TransferTables, DeepEncodeSettlesAnyEstimate)
+{
+    const TransferTablesNBit &tables = transferTablesNBit(BitDepth::Ten);
+    std::mt19937_64 generator(7);
+    std::uniform_real_distribution<double> distribution(0.0, 1.0);
+    for (int i = 0; i < 100000; ++i)
+    {
+        double value = distribution(generator);
+        int expected = static_cast<int>(std::round(linearToGamma(value) * tables.maxCode));
+        for (double error : {0.0, -0.01, 0.01, -2.0, 2.0})
+        {
+            ASSERT_EQ(linearToGammaNBit(tables, value, linearToGamma(value) + error), expected) << "value " << value;
+        }
+    }
+    for (double value : {-1.5, -0.25, 1.0000001, 1.25})
+    {
+        EXPECT_EQ(linearToGammaNBit(tables, value), static_cast<int>(std::round(linearToGamma(value) * tables.maxCode))) << value;
+    }
+}